@@ -0,0 +1,92 @@
+#include <stdlib.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "fontomas/debug.h"
+
+#include "benchglobals.h"
+
+
+/*
+ * The global operator new is replaced to count allocations, so a benchmark can
+ * report allocations per operation. Memory is taken from malloc as usual.
+ */
+
+
+namespace {
+
+
+    std::atomic<uint64_t> s_NbAllocations(0);
+
+
+    void* allocate(std::size_t size) noexcept {
+        s_NbAllocations.fetch_add(1, std::memory_order_relaxed);
+        return std::malloc(size > 0 ? size : 1);
+    }
+
+
+    void* allocate(std::size_t size, std::align_val_t alignment) noexcept {
+        s_NbAllocations.fetch_add(1, std::memory_order_relaxed);
+
+        std::size_t align = static_cast<std::size_t>(alignment);
+        if (align < sizeof(void*))
+            align = sizeof(void*);
+
+        void* ptr = nullptr;
+        if (0 != posix_memalign(&ptr, align, size > 0 ? size : 1))
+            return nullptr;
+        return ptr;
+    }
+
+
+    void* allocate_or_break(void* ptr) noexcept {
+        if (!ptr)
+            fontomas__hardbreak; // out of memory
+        return ptr;
+    }
+
+
+}
+
+
+uint64_t fontomas::bench::allocations() noexcept {
+    return s_NbAllocations.load(std::memory_order_relaxed);
+}
+
+
+void* operator new(std::size_t size) { return allocate_or_break(allocate(size)); }
+void* operator new[](std::size_t size) { return allocate_or_break(allocate(size)); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return allocate_or_break(allocate(size, alignment));
+}
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return allocate_or_break(allocate(size, alignment));
+}
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate(size, alignment);
+}
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { std::free(ptr); }
+
+
+// bench/allocations.cpp
@@ -0,0 +1,121 @@
+#include "fontomas/di.h"
+
+#include <memory>
+
+#include "fontomas/services/logger.h"
+
+#include "benchglobals.h"
+
+
+void bench__di__resolveservice();
+void bench__di__getservice();
+void bench__di__injected();
+void bench__di__inject_shared();
+
+fontomas__bench_suit_begin(DI)
+    fontomas__bench(bench__di__resolveservice),
+    fontomas__bench(bench__di__getservice),
+    fontomas__bench(bench__di__injected),
+    fontomas__bench(bench__di__inject_shared),
+fontomas__bench_suit_end(DI);
+
+
+namespace {
+
+    using namespace fontomas;
+
+    constexpr std::size_t sNbLookups = 1 << 22;
+
+    class NullLogger final : public services::Logger {
+    public:
+        bool visible(Level) const noexcept override { return false; }
+        void print(Level, const char*) noexcept override {}
+    };
+
+}
+
+
+using Logger = fontomas::services::Logger;
+fontomas__provide_as_shared(Logger, NullLogger)
+
+
+namespace {
+
+    // an object, which is made per glyph run
+    struct GlyphRun {
+        fontomas__inject(Logger, logger);
+        int nbGlyphs;
+    };
+
+}
+
+
+// a per-glyph path, which checks if it should log
+void bench__di__resolveservice() {
+    DIContainer di;
+    di.registerService<services::Logger, NullLogger>();
+
+    std::size_t nbVisible = 0;
+    bench::Stopwatch sw;
+    for (std::size_t i = 0; i < sNbLookups; ++i) {
+        std::shared_ptr<services::Logger> logger = di.resolveService<services::Logger>();
+        nbVisible += logger->visible(services::Logger::Level::Debug) ? 1 : 0;
+    }
+    double elapsed = sw.elapsedNs();
+
+    bench::keep(nbVisible);
+    bench::report("DIContainer::resolveService", sNbLookups, elapsed, sw.nballocs());
+}
+
+
+void bench__di__getservice() {
+    DIContainer di;
+    di.registerService<services::Logger, NullLogger>();
+
+    std::size_t nbVisible = 0;
+    bench::Stopwatch sw;
+    for (std::size_t i = 0; i < sNbLookups; ++i) {
+        services::Logger* logger = di.getService<services::Logger>();
+        nbVisible += logger->visible(services::Logger::Level::Debug) ? 1 : 0;
+    }
+    double elapsed = sw.elapsedNs();
+
+    bench::keep(nbVisible);
+    bench::report("DIContainer::getService", sNbLookups, elapsed, sw.nballocs());
+}
+
+
+// a service user keeps the service once it's found
+void bench__di__injected() {
+    DIContainer di;
+    di.registerService<services::Logger, NullLogger>();
+    const Injected<services::Logger> logger(di);
+
+    std::size_t nbVisible = 0;
+    bench::Stopwatch sw;
+    for (std::size_t i = 0; i < sNbLookups; ++i)
+        nbVisible += logger->visible(services::Logger::Level::Debug) ? 1 : 0;
+    double elapsed = sw.elapsedNs();
+
+    bench::keep(nbVisible);
+    bench::report("fontomas::Injected", sNbLookups, elapsed, sw.nballocs());
+}
+
+
+// an object with an injected field is made and used per glyph run
+void bench__di__inject_shared() {
+    std::size_t nbVisible = 0;
+    bench::Stopwatch sw;
+    for (std::size_t i = 0; i < sNbLookups; ++i) {
+        GlyphRun run;
+        run.nbGlyphs = int(i);
+        nbVisible += run.logger->visible(services::Logger::Level::Debug) ? 0 : std::size_t(run.nbGlyphs);
+    }
+    double elapsed = sw.elapsedNs();
+
+    bench::keep(nbVisible);
+    bench::report("fontomas__inject (provide_as_shared)", sNbLookups, elapsed, sw.nballocs());
+}
+
+
+// bench/bench_di.cpp
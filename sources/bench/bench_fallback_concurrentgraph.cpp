@@ -0,0 +1,143 @@
+#include "fontomas/fallback/concurrentgraph.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "benchglobals.h"
+
+
+void bench__fallback__concurrentgraph_mutex();
+void bench__fallback__concurrentgraph_snapshot();
+
+fontomas__bench_suit_begin(FallbackConcurrentGraph)
+    fontomas__bench(bench__fallback__concurrentgraph_mutex),
+    fontomas__bench(bench__fallback__concurrentgraph_snapshot),
+fontomas__bench_suit_end(FallbackConcurrentGraph);
+
+
+namespace {
+
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    constexpr nodeid_t sNbNodes = 2048;
+    constexpr tagid_t sNbTags = 8;
+    constexpr int sNbReaders = 8;
+    constexpr std::size_t sNbQueries = 1 << 18;
+    // the writer adds a font and publishes with this period
+    constexpr std::chrono::microseconds sWritePeriod(256);
+
+    // readers of a shaping pool make lookups, while the config thread adds a
+    // font now and then; time is measured by readers until all are done
+    template <typename Build, typename Read, typename Write>
+    void run(const char* name, Build build, Read read, Write write) {
+        build();
+
+        std::atomic<int> nbReady(0), nbDone(0);
+        std::atomic<bool> go(false);
+        std::atomic<std::size_t> total(0);
+
+        std::vector<std::thread> readers;
+        for (int r = 0; r < sNbReaders; ++r) {
+            readers.emplace_back([&, r]() {
+                std::mt19937 rng(r);
+                ++nbReady;
+                while (!go)
+                    std::this_thread::yield();
+
+                std::size_t found = 0;
+                for (std::size_t i = 0; i < sNbQueries; ++i)
+                    found += read(nodeid_t(rng() % sNbNodes), tagid_t(rng() % sNbTags));
+                total += found;
+                ++nbDone;
+            });
+        }
+
+        while (nbReady < sNbReaders)
+            std::this_thread::yield();
+
+        bench::Stopwatch sw;
+        go = true;
+
+        nodeid_t nodeId = sNbNodes;
+        while (nbDone < sNbReaders) {
+            write(nodeId++);
+            std::this_thread::sleep_for(sWritePeriod);
+        }
+        double elapsed = sw.elapsedNs();
+
+        for (std::thread& t : readers)
+            t.join();
+
+        bench::keep(total.load());
+        bench::report(name, sNbQueries * sNbReaders, elapsed, sw.nballocs());
+    }
+
+}
+
+
+// every lookup takes a global mutex, which is shared with the writer
+void bench__fallback__concurrentgraph_mutex() {
+    Graph g;
+    std::mutex mutex;
+
+    auto build = [&]() {
+        std::mt19937 rng(42);
+        for (nodeid_t n = 0; n < sNbNodes; ++n)
+            g.addNode(n, n % sNbTags);
+        for (nodeid_t n = 0; n + 1 < sNbNodes; ++n) {
+            for (tagid_t t = 0; t < sNbTags; ++t)
+                g.addRoute(n, nodeid_t(n + 1 + rng() % (sNbNodes - n - 1)), t);
+        }
+    };
+
+    auto read = [&](nodeid_t nodeId, tagid_t tagId) -> std::size_t {
+        std::lock_guard<std::mutex> lock(mutex);
+        return g.fallbacks(nodeId, tagId).size();
+    };
+
+    auto write = [&](nodeid_t nodeId) {
+        std::lock_guard<std::mutex> lock(mutex);
+        g.addNode(nodeId, 0);
+        g.addRoute(nodeId, 0, 0);
+    };
+
+    run("fallback::Graph 8 readers (mutex)", build, read, write);
+}
+
+
+// every reader pins the published version for each lookup
+void bench__fallback__concurrentgraph_snapshot() {
+    ConcurrentGraph g(sNbReaders);
+
+    auto build = [&]() {
+        std::mt19937 rng(42);
+        for (nodeid_t n = 0; n < sNbNodes; ++n)
+            g.addNode(n, n % sNbTags);
+        for (nodeid_t n = 0; n + 1 < sNbNodes; ++n) {
+            for (tagid_t t = 0; t < sNbTags; ++t)
+                g.addRoute(n, nodeid_t(n + 1 + rng() % (sNbNodes - n - 1)), t);
+        }
+        g.publish();
+    };
+
+    auto read = [&](nodeid_t nodeId, tagid_t tagId) -> std::size_t {
+        thread_local ConcurrentGraph::Reader reader = g.reader();
+        return reader.pin().fallbacks(nodeId, tagId).size();
+    };
+
+    auto write = [&](nodeid_t nodeId) {
+        g.addNode(nodeId, 0);
+        g.addRoute(nodeId, 0, 0);
+        g.publish();
+    };
+
+    run("fallback::ConcurrentGraph 8 readers (snapshot)", build, read, write);
+}
+
+
+// bench/bench_fallback_concurrentgraph.cpp
@@ -0,0 +1,640 @@
+#include "fontomas/fallback/graph.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "fontomas/allocator.h"
+
+#include "benchglobals.h"
+
+
+void bench__fallback__graph_fallbacks_copy();
+void bench__fallback__graph_fallbacks_view();
+void bench__fallback__graph_fallbacks_single();
+void bench__fallback__graph_fallbacks_batch16();
+void bench__fallback__graph_fallbacks_batch64();
+void bench__fallback__graph_fallbacks_batch256();
+void bench__fallback__graph_fallbacks_merge();
+void bench__fallback__graph_fallbacks_for_tags();
+void bench__fallback__graph_chain_first();
+void bench__fallback__graph_cheapest();
+void bench__fallback__graph_bulkload();
+void bench__fallback__graph_bulkload_batch();
+void bench__fallback__graph_bulkload_arena();
+void bench__fallback__graph_bulkload_pool();
+void bench__fallback__graph_bulkload_parallel();
+void bench__fallback__graph_bulkload_increments();
+void bench__fallback__graph_memory_tags();
+void bench__fallback__graph_uninstall_rebuild();
+void bench__fallback__graph_uninstall_remove();
+void bench__fallback__graph_startup();
+
+fontomas__bench_suit_begin(FallbackGraph)
+    fontomas__bench(bench__fallback__graph_fallbacks_copy),
+    fontomas__bench(bench__fallback__graph_fallbacks_view),
+    fontomas__bench(bench__fallback__graph_fallbacks_single),
+    fontomas__bench(bench__fallback__graph_fallbacks_batch16),
+    fontomas__bench(bench__fallback__graph_fallbacks_batch64),
+    fontomas__bench(bench__fallback__graph_fallbacks_batch256),
+    fontomas__bench(bench__fallback__graph_fallbacks_merge),
+    fontomas__bench(bench__fallback__graph_fallbacks_for_tags),
+    fontomas__bench(bench__fallback__graph_chain_first),
+    fontomas__bench(bench__fallback__graph_cheapest),
+    fontomas__bench(bench__fallback__graph_bulkload),
+    fontomas__bench(bench__fallback__graph_bulkload_batch),
+    fontomas__bench(bench__fallback__graph_bulkload_arena),
+    fontomas__bench(bench__fallback__graph_bulkload_pool),
+    fontomas__bench(bench__fallback__graph_bulkload_parallel),
+    fontomas__bench(bench__fallback__graph_bulkload_increments),
+    fontomas__bench(bench__fallback__graph_memory_tags),
+    fontomas__bench(bench__fallback__graph_uninstall_rebuild),
+    fontomas__bench(bench__fallback__graph_uninstall_remove),
+    fontomas__bench(bench__fallback__graph_startup),
+fontomas__bench_suit_end(FallbackGraph);
+
+
+namespace {
+
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    constexpr nodeid_t sNbNodes = 4096;
+    constexpr tagid_t sNbTags = 8;
+    constexpr nodeid_t sNbFallbacks = 8;
+    constexpr std::size_t sNbQueries = 1 << 20;
+    constexpr int sNbRounds = 8;
+
+    struct Query {
+        nodeid_t nodeId;
+        tagid_t tagId;
+    };
+
+    // every node falls back to a few nodes with greater ids, thus the graph
+    // is acyclic by construction
+    void build_graph(Graph& g) noexcept {
+        std::srand(42);
+        for (nodeid_t n = 0; n < sNbNodes; ++n)
+            g.addNode(n, n % sNbTags);
+
+        for (nodeid_t n = 0; n + 1 < sNbNodes; ++n) {
+            for (tagid_t t = 0; t < sNbTags; ++t) {
+                for (nodeid_t i = 0; i < sNbFallbacks; ++i) {
+                    nodeid_t fallbackId = n + 1 + std::rand() % (sNbNodes - n - 1);
+                    g.addRoute(n, fallbackId, t);
+                }
+            }
+        }
+    }
+
+    std::vector<Query> make_queries() {
+        std::vector<Query> queries(sNbQueries);
+        for (Query& q : queries) {
+            q.nodeId = std::rand() % sNbNodes;
+            q.tagId = std::rand() % sNbTags;
+        }
+        return queries;
+    }
+
+    // a run of text in a few scripts needs fallbacks of a few tags at once
+    struct MaskQuery {
+        nodeid_t nodeId;
+        uint64_t tagMask;
+    };
+
+    std::vector<MaskQuery> make_mask_queries() {
+        std::vector<MaskQuery> queries(sNbQueries / 4);
+        for (MaskQuery& q : queries) {
+            q.nodeId = std::rand() % sNbNodes;
+            q.tagMask = 0;
+            for (tagid_t nbtags = 0; nbtags < sNbTags / 2; ) {
+                const uint64_t bit = uint64_t(1) << (std::rand() % sNbTags);
+                nbtags += 0 == (q.tagMask & bit) ? 1 : 0;
+                q.tagMask |= bit;
+            }
+        }
+        return queries;
+    }
+
+    // a quarter of fonts is resident in the glyph cache, others have to be
+    // loaded; every 8th font has glyphs of the run
+    class ResidentCosts : public Costs {
+    public:
+        uint32_t cost(nodeid_t, nodeid_t fallbackId, tagid_t) noexcept override {
+            return 0 == fallbackId % 4 ? 1 : 100;
+        }
+        bool serves(nodeid_t nodeId, tagid_t) noexcept override {
+            return 0 == nodeId % 8;
+        }
+    };
+
+    Graph& shared_graph() noexcept {
+        static Graph sGraph;
+        if (sGraph.empty())
+            build_graph(sGraph);
+        return sGraph;
+    }
+
+    // queries of a batch are looked up by one call into one arena
+    void run_batches(const char* name, std::size_t szbatch) {
+        const Graph& g = shared_graph();
+        std::vector<Query> random = make_queries();
+
+        std::vector<Graph::Query> queries(random.size());
+        for (std::size_t i = 0; i < random.size(); ++i)
+            queries[i] = Graph::Query{ random[i].nodeId, random[i].tagId };
+
+        std::vector<Graph::Found> found(szbatch);
+        std::vector<nodeid_t> arena(szbatch * sNbFallbacks);
+        std::size_t checksum = 0;
+
+        bench::Stopwatch sw;
+        for (int r = 0; r < sNbRounds; ++r) {
+            for (std::size_t i = 0; i < queries.size(); i += szbatch) {
+                const std::size_t nb = std::min(szbatch, queries.size() - i);
+                const uint32_t nbfound = g.fallbacks(span_t<const Graph::Query>(queries.data() + i, nb),
+                                                     found.data(), arena.data(), uint32_t(arena.size()));
+                for (uint32_t k = 0; k < nbfound && k < arena.size(); ++k)
+                    checksum += arena[k];
+            }
+        }
+        double elapsed = sw.elapsedNs();
+
+        bench::keep(checksum);
+        bench::report(name, sNbRounds * queries.size(), elapsed, sw.nballocs());
+    }
+
+}
+
+
+void bench__fallback__graph_fallbacks_copy() {
+    const Graph& g = shared_graph();
+    std::vector<Query> queries = make_queries();
+
+    nodeid_t buffer[sNbFallbacks];
+    std::size_t checksum = 0;
+
+    bench::Stopwatch sw;
+    for (int r = 0; r < sNbRounds; ++r) {
+        for (const Query& q : queries) {
+            uint16_t nb = g.fallbacks(q.nodeId, q.tagId, buffer, sNbFallbacks);
+            for (uint16_t i = 0; i < nb; ++i)
+                checksum += buffer[i];
+        }
+    }
+    double elapsed = sw.elapsedNs();
+
+    bench::keep(checksum);
+    bench::report("fallback::Graph::fallbacks (copy)", sNbRounds * queries.size(), elapsed, sw.nballocs());
+}
+
+
+void bench__fallback__graph_fallbacks_view() {
+    const Graph& g = shared_graph();
+    std::vector<Query> queries = make_queries();
+
+    std::size_t checksum = 0;
+
+    bench::Stopwatch sw;
+    for (int r = 0; r < sNbRounds; ++r) {
+        for (const Query& q : queries) {
+            for (nodeid_t fallbackId : g.fallbacks(q.nodeId, q.tagId))
+                checksum += fallbackId;
+        }
+    }
+    double elapsed = sw.elapsedNs();
+
+    bench::keep(checksum);
+    bench::report("fallback::Graph::fallbacks (view)", sNbRounds * queries.size(), elapsed, sw.nballocs());
+}
+
+
+namespace {
+
+    constexpr nodeid_t sNbLoadNodes = 10000;
+    constexpr tagid_t sNbLoadTags = 50;
+    constexpr int sNbRoutesPerNode = 2;
+
+    // each tag is a random DAG: routes go forward in a random permutation of
+    // nodes, and are inserted in a random order
+    std::vector<Graph::Route> make_load_routes() {
+        std::mt19937 rng(42);
+        std::vector<Graph::Route> routes;
+        routes.reserve(std::size_t(sNbLoadNodes) * sNbLoadTags * sNbRoutesPerNode);
+
+        std::vector<nodeid_t> permutation(sNbLoadNodes);
+        std::iota(permutation.begin(), permutation.end(), nodeid_t(0));
+        for (tagid_t t = 0; t < sNbLoadTags; ++t) {
+            std::shuffle(permutation.begin(), permutation.end(), rng);
+            for (nodeid_t i = 0; i + 1 < sNbLoadNodes; ++i) {
+                for (int j = 0; j < sNbRoutesPerNode; ++j) {
+                    nodeid_t k = i + 1 + rng() % (sNbLoadNodes - i - 1);
+                    routes.push_back(Graph::Route{permutation[i], permutation[k], t});
+                }
+            }
+        }
+        std::shuffle(routes.begin(), routes.end(), rng);
+
+        return routes;
+    }
+
+
+    // nbThreads 0 loads by addRoutes(), others - by addRoutesParallel()
+    void batch_load(const char* name, Allocator& allocator, uint32_t nbThreads = 0) {
+        std::vector<Graph::Route> routes = make_load_routes();
+
+        Graph g(allocator);
+
+        bench::Stopwatch sw;
+        for (nodeid_t n = 0; n < sNbLoadNodes; ++n)
+            g.addNode(n, n % sNbLoadTags);
+        const span_t<const Graph::Route> view(routes.data(), routes.size());
+        Graph::Result res = nbThreads > 0 ? g.addRoutesParallel(view, nbThreads) : g.addRoutes(view);
+        double elapsed = sw.elapsedNs();
+
+        bench::keep(res);
+        bench::report(name, routes.size(), elapsed, sw.nballocs());
+
+        const MemoryStats stats = allocator.stats();
+        bench::report_memory(name, stats.reserved, stats.used);
+    }
+
+}
+
+
+// the same queries as batches, but one call per query
+void bench__fallback__graph_fallbacks_single() {
+    const Graph& g = shared_graph();
+    std::vector<Query> queries = make_queries();
+
+    nodeid_t arena[sNbFallbacks];
+    std::size_t checksum = 0;
+
+    bench::Stopwatch sw;
+    for (int r = 0; r < sNbRounds; ++r) {
+        for (const Query& q : queries) {
+            uint16_t nb = g.fallbacks(q.nodeId, q.tagId, arena, sNbFallbacks);
+            for (uint16_t i = 0; i < nb; ++i)
+                checksum += arena[i];
+        }
+    }
+    double elapsed = sw.elapsedNs();
+
+    bench::keep(checksum);
+    bench::report("fallback::Graph::fallbacks (single)", sNbRounds * queries.size(), elapsed, sw.nballocs());
+}
+
+
+void bench__fallback__graph_fallbacks_batch16() {
+    run_batches("fallback::Graph::fallbacks (batch of 16)", 16);
+}
+
+
+void bench__fallback__graph_fallbacks_batch64() {
+    run_batches("fallback::Graph::fallbacks (batch of 64)", 64);
+}
+
+
+void bench__fallback__graph_fallbacks_batch256() {
+    run_batches("fallback::Graph::fallbacks (batch of 256)", 256);
+}
+
+
+// fallbacks of each tag are merged by the caller
+void bench__fallback__graph_fallbacks_merge() {
+    const Graph& g = shared_graph();
+    std::vector<MaskQuery> queries = make_mask_queries();
+
+    nodeid_t buffer[sNbTags * sNbFallbacks];
+    std::size_t checksum = 0;
+
+    bench::Stopwatch sw;
+    for (int r = 0; r < sNbRounds; ++r) {
+        for (const MaskQuery& q : queries) {
+            uint16_t nb = 0;
+            for (tagid_t t = 0; t < sNbTags; ++t) {
+                if (0 == (q.tagMask & (uint64_t(1) << t)))
+                    continue;
+
+                for (nodeid_t fallbackId : g.fallbacks(q.nodeId, t)) {
+                    if (buffer + nb == std::find(buffer, buffer + nb, fallbackId))
+                        buffer[nb++] = fallbackId;
+                }
+            }
+            for (uint16_t i = 0; i < nb; ++i)
+                checksum += buffer[i];
+        }
+    }
+    double elapsed = sw.elapsedNs();
+
+    bench::keep(checksum);
+    bench::report("fallback::Graph::fallbacks (merged tags)", sNbRounds * queries.size(),
+                  elapsed, sw.nballocs());
+}
+
+
+void bench__fallback__graph_fallbacks_for_tags() {
+    Graph& g = shared_graph();
+    std::vector<MaskQuery> queries = make_mask_queries();
+
+    nodeid_t buffer[sNbTags * sNbFallbacks];
+    std::size_t checksum = 0;
+
+    bench::Stopwatch sw;
+    for (int r = 0; r < sNbRounds; ++r) {
+        for (const MaskQuery& q : queries) {
+            uint16_t nb = g.fallbacksForTags(q.nodeId, span_t<const uint64_t>(&q.tagMask, 1),
+                                             buffer, sNbTags * sNbFallbacks);
+            for (uint16_t i = 0; i < nb; ++i)
+                checksum += buffer[i];
+        }
+    }
+    double elapsed = sw.elapsedNs();
+
+    bench::keep(checksum);
+    bench::report("fallback::Graph::fallbacksForTags", sNbRounds * queries.size(), elapsed, sw.nballocs());
+}
+
+
+// the first font of the chain, which serves, regardless of its cost
+void bench__fallback__graph_chain_first() {
+    Graph& g = shared_graph();
+    std::vector<Query> queries = make_queries();
+    queries.resize(queries.size() / 16);
+
+    ResidentCosts costs;
+    std::size_t checksum = 0;
+
+    bench::Stopwatch sw;
+    for (int r = 0; r < sNbRounds; ++r) {
+        for (const Query& q : queries) {
+            for (nodeid_t fallbackId : g.chain(q.nodeId, q.tagId)) {
+                if (costs.serves(fallbackId, q.tagId)) {
+                    checksum += fallbackId;
+                    break;
+                }
+            }
+        }
+    }
+    double elapsed = sw.elapsedNs();
+
+    bench::keep(checksum);
+    bench::report("fallback::Graph::chain (first, which serves)", sNbRounds * queries.size(),
+                  elapsed, sw.nballocs());
+}
+
+
+void bench__fallback__graph_cheapest() {
+    Graph& g = shared_graph();
+    std::vector<Query> queries = make_queries();
+    queries.resize(queries.size() / 16);
+
+    ResidentCosts costs;
+    std::size_t checksum = 0;
+
+    bench::Stopwatch sw;
+    for (int r = 0; r < sNbRounds; ++r) {
+        for (const Query& q : queries)
+            checksum += g.cheapest(q.nodeId, q.tagId, costs).nodeId;
+    }
+    double elapsed = sw.elapsedNs();
+
+    bench::keep(checksum);
+    bench::report("fallback::Graph::cheapest", sNbRounds * queries.size(), elapsed, sw.nballocs());
+}
+
+
+void bench__fallback__graph_bulkload() {
+    std::vector<Graph::Route> routes = make_load_routes();
+
+    Graph g;
+    std::size_t nbAdded = 0;
+
+    bench::Stopwatch sw;
+    for (nodeid_t n = 0; n < sNbLoadNodes; ++n)
+        g.addNode(n, n % sNbLoadTags);
+    for (const Graph::Route& r : routes)
+        nbAdded += Graph::eOk == g.addRoute(r.nodeId, r.fallbackId, r.tagId) ? 1 : 0;
+    double elapsed = sw.elapsedNs();
+
+    bench::keep(nbAdded);
+    bench::report("fallback::Graph bulk load 10k nodes x 50 tags", routes.size(), elapsed, sw.nballocs());
+
+    MemoryStats stats = g.memory();
+    bench::report_memory("fallback::Graph bulk load 10k nodes x 50 tags", stats.reserved, stats.used);
+
+    g.shrink_to_fit();
+    stats = g.memory();
+    bench::report_memory("fallback::Graph bulk load (shrink_to_fit)", stats.reserved, stats.used);
+}
+
+
+void bench__fallback__graph_bulkload_batch() {
+    HeapAllocator heap;
+    batch_load("fallback::Graph batch load 10k nodes x 50 tags", heap);
+}
+
+
+void bench__fallback__graph_bulkload_arena() {
+    ArenaAllocator arena;
+    batch_load("fallback::Graph batch load (arena)", arena);
+}
+
+
+void bench__fallback__graph_bulkload_pool() {
+    PoolAllocator pool;
+    batch_load("fallback::Graph batch load (pool)", pool);
+}
+
+
+// scaling of the parallel load: thread counts are doubled up to all cores;
+// with one thread it shows the overhead of the parallel path itself
+void bench__fallback__graph_bulkload_parallel() {
+    const uint32_t nbCores = std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<uint32_t> counts;
+    for (uint32_t nbThreads = 1; nbThreads < nbCores; nbThreads *= 2)
+        counts.push_back(nbThreads);
+    counts.push_back(nbCores);
+
+    for (uint32_t nbThreads : counts) {
+        char name[64];
+        std::snprintf(name, sizeof(name), "fallback::Graph parallel load (%u threads)", nbThreads);
+
+        HeapAllocator heap;
+        batch_load(name, heap, nbThreads);
+    }
+}
+
+
+// a loaded graph gets small tables of routes, e.g. of installed fonts: each
+// table moves only nodes between ends of its routes and reuses the threads
+void bench__fallback__graph_bulkload_increments() {
+    constexpr std::size_t sNbIncrements = 1000;
+    constexpr std::size_t sNbIncrementRoutes = 64;
+
+    const uint32_t nbCores = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<Graph::Route> routes = make_load_routes();
+    const std::size_t nbLoaded = routes.size() - sNbIncrements * sNbIncrementRoutes;
+
+    for (uint32_t nbThreads : { 1u, nbCores }) {
+        Graph g;
+        for (nodeid_t n = 0; n < sNbLoadNodes; ++n)
+            g.addNode(n, n % sNbLoadTags);
+        g.addRoutesParallel(span_t<const Graph::Route>(routes.data(), nbLoaded), nbThreads);
+
+        std::size_t nbAdded = 0;
+        bench::Stopwatch sw;
+        for (std::size_t i = nbLoaded; i < routes.size(); i += sNbIncrementRoutes) {
+            std::vector<Graph::Result> results(sNbIncrementRoutes);
+            g.addRoutesParallel(span_t<const Graph::Route>(routes.data() + i, sNbIncrementRoutes), nbThreads,
+                                results.data());
+            for (Graph::Result res : results)
+                nbAdded += Graph::eOk == res ? 1 : 0;
+        }
+        double elapsed = sw.elapsedNs();
+
+        char name[80];
+        std::snprintf(name, sizeof(name), "fallback::Graph incremental load by %zu (%u threads)",
+                      sNbIncrementRoutes, nbThreads);
+
+        bench::keep(nbAdded);
+        bench::report(name, sNbIncrements * sNbIncrementRoutes, elapsed, sw.nballocs());
+    }
+}
+
+
+// memory of routes and lookup time with few scattered tags per node (the
+// case of script x language x style tag ids), with a whole range of close
+// tags and with many scattered tags
+void bench__fallback__graph_memory_tags() {
+    constexpr nodeid_t sNbFonts = 2000;
+    constexpr tagid_t sMaxTagId = 8000;
+
+    struct Workload {
+        const char* name;
+        tagid_t nbtags;
+        tagid_t stride;
+    };
+
+    static const Workload sWorkloads[] = {
+        { "fallback::Graph 2k nodes x 4 scattered tags", 4, 1999 },
+        { "fallback::Graph 2k nodes x 64 close tags", 64, 1 },
+        { "fallback::Graph 2k nodes x 64 scattered tags", 64, 97 },
+    };
+
+    for (const Workload& w : sWorkloads) {
+        std::mt19937 rng(42);
+
+        std::vector<Query> queries;
+        Graph g;
+        for (nodeid_t n = 0; n < sNbFonts; ++n) {
+            const tagid_t first = tagid_t(rng() % sMaxTagId);
+            for (tagid_t i = 0; i < w.nbtags; ++i) {
+                const tagid_t tagId = tagid_t((first + i * w.stride) % sMaxTagId);
+                if (0 == i)
+                    g.addNode(n, tagId);
+                if (n > 0)
+                    g.addRoute(n, nodeid_t(rng() % n), tagId);
+                queries.push_back(Query{n, tagId});
+            }
+        }
+        std::shuffle(queries.begin(), queries.end(), rng);
+
+        const MemoryStats stats = g.memory();
+        bench::report_memory(w.name, stats.reserved, stats.used);
+
+        std::size_t total = 0;
+        bench::Stopwatch sw;
+        for (int round = 0; round < sNbRounds; ++round) {
+            for (const Query& q : queries)
+                total += g.fallbacks(q.nodeId, q.tagId).size();
+        }
+        double elapsed = sw.elapsedNs();
+
+        bench::keep(total);
+        bench::report(w.name, queries.size() * sNbRounds, elapsed, sw.nballocs());
+    }
+}
+
+
+// a process gets a frozen graph ready for lookups: by building it from the
+// table of routes or by mapping a saved one
+// a font is uninstalled and the graph is built again without it
+void bench__fallback__graph_uninstall_rebuild() {
+    constexpr int sNbUninstalls = 4;
+
+    bench::Stopwatch sw;
+    for (int i = 0; i < sNbUninstalls; ++i) {
+        Graph g;
+        build_graph(g);
+        bench::keep(g.fallbacks(0, 0).size());
+    }
+    double elapsed = sw.elapsedNs();
+
+    bench::report("fallback::Graph uninstall (rebuild)", sNbUninstalls, elapsed, sw.nballocs());
+}
+
+
+// fonts are removed from the loaded graph, which is compacted by short steps
+void bench__fallback__graph_uninstall_remove() {
+    constexpr int sNbUninstalls = 256;
+
+    Graph g;
+    build_graph(g);
+
+    std::mt19937 rng(42);
+    bench::Stopwatch sw;
+    for (int i = 0; i < sNbUninstalls; ++i) {
+        g.removeNode(nodeid_t(rng() % sNbNodes));
+        g.compactStep(64);
+    }
+    double elapsed = sw.elapsedNs();
+
+    bench::keep(g.fallbacks(0, 0).size());
+    bench::report("fallback::Graph uninstall (removeNode)", sNbUninstalls, elapsed, sw.nballocs());
+}
+
+
+void bench__fallback__graph_startup() {
+    static const char* sPath = "fontomasbench.fgraph";
+
+    std::vector<Graph::Route> routes = make_load_routes();
+
+    std::size_t total = 0;
+    bench::Stopwatch sw;
+    {
+        Graph g;
+        for (nodeid_t n = 0; n < sNbLoadNodes; ++n)
+            g.addNode(n, n % sNbLoadTags);
+        g.addRoutes(span_t<const Graph::Route>(routes.data(), routes.size()));
+
+        FrozenGraph frozen = g.freeze();
+        total += frozen.fallbacks(0, 0).size();
+        frozen.save(sPath);
+    }
+    double elapsed = sw.elapsedNs();
+    bench::report("fallback::FrozenGraph build 10k nodes x 50 tags", 1, elapsed, sw.nballocs());
+
+    for (bool verify : { true, false }) {
+        sw = bench::Stopwatch();
+        FrozenGraph frozen;
+        FrozenGraph::Result res = frozen.load(sPath, verify);
+        total += frozen.fallbacks(0, 0).size();
+        elapsed = sw.elapsedNs();
+
+        bench::keep(res);
+        bench::report(verify ? "fallback::FrozenGraph load (checksum)" : "fallback::FrozenGraph load (trusted)",
+                      1, elapsed, sw.nballocs());
+    }
+
+    bench::keep(total);
+    std::remove(sPath);
+}
+
+
+// bench/bench_fallback_graph.cpp
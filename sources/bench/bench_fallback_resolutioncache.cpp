@@ -0,0 +1,98 @@
+#include "fontomas/fallback/resolutioncache.h"
+
+#include <random>
+#include <vector>
+
+#include "benchglobals.h"
+
+
+void bench__fallback__resolutioncache_direct();
+void bench__fallback__resolutioncache_cached();
+
+fontomas__bench_suit_begin(FallbackResolutionCache)
+    fontomas__bench(bench__fallback__resolutioncache_direct),
+    fontomas__bench(bench__fallback__resolutioncache_cached),
+fontomas__bench_suit_end(FallbackResolutionCache);
+
+
+namespace {
+
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    constexpr nodeid_t sNbNodes = 256;
+    constexpr nodeid_t sNbPrimaries = 4;
+    constexpr std::size_t sNbLookups = 1 << 20;
+    // distinct codepoints of the text, e.g. a cjk page with some latin
+    constexpr codepoint_t sNbDistinct = 512;
+
+    // each node covers one of 64 blocks of 256 codepoints, so a codepoint
+    // is found after about a half of a chain of a primary node
+    void build(Graph& g) {
+        std::mt19937 rng(42);
+        for (nodeid_t n = 0; n < sNbNodes; ++n) {
+            g.addNode(n, 0);
+
+            Coverage coverage;
+            const codepoint_t block = 0x4E00 + (rng() % 64) * 256;
+            coverage.add(block, block + 255);
+            g.setCoverage(n, std::move(coverage));
+        }
+        for (nodeid_t n = 0; n + 1 < sNbNodes; ++n)
+            g.addRoute(n, nodeid_t(n + 1), 0);
+    }
+
+    // real text repeats its codepoints, which are distributed unevenly
+    std::vector<codepoint_t> text() {
+        std::mt19937 rng(7);
+        std::vector<codepoint_t> cps(sNbLookups);
+        for (codepoint_t& cp : cps) {
+            const codepoint_t r = rng() % sNbDistinct;
+            cp = 0x4E00 + (r * r / sNbDistinct) * 32;
+        }
+        return cps;
+    }
+
+    template <typename Resolve>
+    void run(const char* name, Resolve resolve) {
+        const std::vector<codepoint_t> cps = text();
+
+        std::size_t found = 0;
+        bench::Stopwatch sw;
+        for (std::size_t i = 0; i < cps.size(); ++i)
+            found += resolve(nodeid_t(i % sNbPrimaries), cps[i]);
+        const double elapsed = sw.elapsedNs();
+
+        bench::keep(found);
+        bench::report(name, cps.size(), elapsed, sw.nballocs());
+    }
+
+}
+
+
+void bench__fallback__resolutioncache_direct() {
+    Graph g;
+    build(g);
+
+    run("fallback::Graph firstCovering", [&](nodeid_t nodeId, codepoint_t cp) {
+        return g.firstCovering(nodeId, 0, cp);
+    });
+}
+
+
+void bench__fallback__resolutioncache_cached() {
+    Graph g;
+    build(g);
+    ResolutionCache cache(g);
+
+    run("fallback::ResolutionCache resolve", [&](nodeid_t nodeId, codepoint_t cp) {
+        return cache.resolve(nodeId, 0, cp);
+    });
+
+    const ResolutionCache::Stats stats = cache.stats();
+    bench::keep(stats.hits);
+    bench::report_memory("fallback::ResolutionCache tables", cache.memory().reserved, cache.memory().used);
+}
+
+
+// bench/bench_fallback_resolutioncache.cpp
@@ -0,0 +1,184 @@
+#include "fontomas/fallback/graph.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "benchglobals.h"
+
+
+void bench__fallback__workloads_1k();
+void bench__fallback__workloads_16k();
+
+fontomas__bench_suit_begin(FallbackWorkloads)
+    fontomas__bench(bench__fallback__workloads_1k),
+    fontomas__bench(bench__fallback__workloads_16k),
+fontomas__bench_suit_end(FallbackWorkloads);
+
+
+/*
+ * A grid of workloads, so a change can be seen across shapes of configurations
+ * rather than at one point: graph sizes, tags per node (of sNbTags), depths of
+ * chains and sequential versus random streams of queries. Names of results
+ * are "workload n<nodes> t<tags per node> d<depth> <stream> <operation>".
+ */
+namespace {
+
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    constexpr tagid_t sNbTags = 64;
+    // fallbacks of a node per tag
+    constexpr nodeid_t sNbFallbacks = 3;
+    constexpr std::size_t sNbQueries = 1 << 18;
+    constexpr int sNbRounds = 4;
+
+    constexpr tagid_t sDensities[] = { 1, 8 };
+    constexpr nodeid_t sDepths[] = { 4, 32 };
+
+    struct Workload {
+        nodeid_t nbNodes;
+        tagid_t density;
+        nodeid_t depth;
+
+        nodeid_t layer() const noexcept { return nodeid_t(nbNodes / depth); }
+
+        // tags of a node are spread over all tags
+        tagid_t tag(nodeid_t nodeId, tagid_t i) const noexcept {
+            return tagid_t((nodeId + i * (sNbTags / density)) % sNbTags);
+        }
+    };
+
+    struct Query {
+        nodeid_t nodeId;
+        tagid_t tagId;
+    };
+
+
+    //
+    // Nodes are split into depth layers, so chains of the first layer go
+    // through all of them. Each node falls back to a few neighbouring nodes of
+    // the next layer, thus chains grow by a couple of nodes per layer, like
+    // fonts fall back to similar fonts.
+    //
+    std::vector<Graph::Route> make_routes(const Workload& w) {
+        const nodeid_t layer = w.layer();
+
+        std::vector<Graph::Route> routes;
+        routes.reserve(std::size_t(layer) * (w.depth - 1) * w.density * sNbFallbacks);
+        for (nodeid_t l = 0; l + 1 < w.depth; ++l) {
+            for (nodeid_t k = 0; k < layer; ++k) {
+                const nodeid_t nodeId = nodeid_t(l * layer + k);
+                for (tagid_t i = 0; i < w.density; ++i) {
+                    for (nodeid_t j = 0; j < sNbFallbacks; ++j) {
+                        const nodeid_t fallbackId = nodeid_t((l + 1) * layer + (k + j) % layer);
+                        routes.push_back(Graph::Route{ nodeId, fallbackId, w.tag(nodeId, i) });
+                    }
+                }
+            }
+        }
+        return routes;
+    }
+
+
+    // queries of nodes in order of ids, each node with all its tags, or
+    // the same queries shuffled
+    std::vector<Query> make_queries(const Workload& w, nodeid_t nbNodes, bool random) {
+        std::vector<Query> queries(sNbQueries);
+        for (std::size_t i = 0; i < queries.size(); ++i) {
+            const std::size_t pair = i % (std::size_t(nbNodes) * w.density);
+            queries[i].nodeId = nodeid_t(pair / w.density);
+            queries[i].tagId = w.tag(queries[i].nodeId, tagid_t(pair % w.density));
+        }
+
+        if (random)
+            std::shuffle(queries.begin(), queries.end(), std::mt19937(42));
+        return queries;
+    }
+
+
+    void run(const Workload& w) {
+        char prefix[64];
+        std::snprintf(prefix, sizeof(prefix), "workload n%u t%u d%u",
+                      unsigned(w.nbNodes), unsigned(w.density), unsigned(w.depth));
+
+        char name[128];
+        const std::vector<Graph::Route> routes = make_routes(w);
+
+        Graph g;
+        {
+            bench::Stopwatch sw;
+            for (nodeid_t n = 0; n < w.nbNodes; ++n) {
+                for (tagid_t i = 0; i < w.density; ++i)
+                    g.addNode(n, w.tag(n, i));
+            }
+            const Graph::Result res = g.addRoutes(span_t<const Graph::Route>(routes.data(), routes.size()));
+            const double elapsed = sw.elapsedNs();
+
+            bench::keep(res);
+            std::snprintf(name, sizeof(name), "%s build", prefix);
+            bench::report(name, routes.size(), elapsed, sw.nballocs());
+
+            const MemoryStats stats = g.memory();
+            std::snprintf(name, sizeof(name), "%s memory", prefix);
+            bench::report_memory(name, stats.reserved, stats.used);
+        }
+
+        for (bool random : { false, true }) {
+            const char* stream = random ? "random" : "sequential";
+
+            std::vector<Query> queries = make_queries(w, w.nbNodes, random);
+            std::size_t checksum = 0;
+
+            bench::Stopwatch sw;
+            for (int r = 0; r < sNbRounds; ++r) {
+                for (const Query& q : queries)
+                    checksum += g.fallbacks(q.nodeId, q.tagId).size();
+            }
+            double elapsed = sw.elapsedNs();
+
+            bench::keep(checksum);
+            std::snprintf(name, sizeof(name), "%s %s fallbacks", prefix, stream);
+            bench::report(name, sNbRounds * queries.size(), elapsed, sw.nballocs());
+
+            // chains of primary fonts, i.e. the first layer, go through all
+            // layers; the first round resolves them, others hit the cache
+            queries = make_queries(w, w.layer(), random);
+            checksum = 0;
+
+            sw = bench::Stopwatch();
+            for (int r = 0; r < sNbRounds; ++r) {
+                for (const Query& q : queries)
+                    checksum += g.chain(q.nodeId, q.tagId).size();
+            }
+            elapsed = sw.elapsedNs();
+
+            bench::keep(checksum);
+            std::snprintf(name, sizeof(name), "%s %s chain", prefix, stream);
+            bench::report(name, sNbRounds * queries.size(), elapsed, sw.nballocs());
+        }
+    }
+
+
+    void run_grid(nodeid_t nbNodes) {
+        for (tagid_t density : sDensities) {
+            for (nodeid_t depth : sDepths)
+                run(Workload{ nbNodes, density, depth });
+        }
+    }
+
+}
+
+
+void bench__fallback__workloads_1k() {
+    run_grid(1024);
+}
+
+
+void bench__fallback__workloads_16k() {
+    run_grid(16384);
+}
+
+
+// bench/bench_fallback_workloads.cpp
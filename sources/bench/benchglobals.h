@@ -0,0 +1,112 @@
+#pragma once
+#ifndef FONTOMAS_BENCH_BENCHGLOBALS_H_
+#define FONTOMAS_BENCH_BENCHGLOBALS_H_
+
+
+#include <chrono>
+#include <cinttypes>
+#include <cstddef>
+#include <list>
+
+
+namespace fontomas { ;
+namespace bench { ;
+
+
+
+struct Bench {
+    typedef void (*bench_func_t)();
+
+    bench_func_t func;
+    char name[256];
+};
+
+
+/*
+ * Number of heap allocations, which were made by all threads so far. The
+ * global operator new is replaced in the bench (see allocations.cpp), so
+ * allocations of the library are counted too.
+ */
+uint64_t allocations() noexcept;
+
+
+class Stopwatch final {
+public:
+    Stopwatch() noexcept
+        : _start(std::chrono::steady_clock::now()), _allocations(allocations())
+    {}
+
+    double elapsedNs() const noexcept {
+        return double(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - _start).count());
+    }
+
+    // heap allocations of all threads since the stopwatch was started
+    uint64_t nballocs() const noexcept { return allocations() - _allocations; }
+
+private:
+    std::chrono::steady_clock::time_point _start;
+    uint64_t _allocations;
+};
+
+
+/*
+ * Keeps the value alive, so the compiler can't throw away the computation,
+ * which produced it.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+template <typename T>
+inline void keep(const T& value) noexcept {
+    // the value escapes into an empty asm, which may read any memory
+    asm volatile("" : : "g"(&value) : "memory");
+}
+#else
+// defined in main.cpp
+extern const void* volatile sKeptValue;
+
+template <typename T>
+inline void keep(const T& value) noexcept {
+    sKeptValue = &value;
+}
+#endif
+
+
+/*
+ * Prints time and heap allocations per operation and the peak resident set
+ * size since the benchmark function was started. With --json the result is
+ * written to the file too.
+ */
+void report(const char* name, std::size_t nbops, double elapsedNs, uint64_t nballocs) noexcept;
+
+/*
+ * Prints memory taken by the benchmarked structure: reserved and used bytes.
+ */
+void report_memory(const char* name, std::size_t reserved, std::size_t used) noexcept;
+
+
+
+}
+}
+
+
+#define fontomas__bench(BenchFunc) fontomas::bench::Bench{ BenchFunc, #BenchFunc }
+
+
+#define fontomas__bench_suit_begin(SuitName)                                    \
+void add_bench_suit_ ## SuitName (std::list< fontomas::bench::Bench >& all);    \
+namespace { static const fontomas::bench::Bench s_ ## SuitName ## Benches[] = {
+
+#define fontomas__bench_suit_end(SuitName)                                      \
+};}                                                                             \
+void add_bench_suit_ ## SuitName (std::list< fontomas::bench::Bench >& all) {   \
+    for (const auto& b : s_ ## SuitName ## Benches)                             \
+        all.push_back(b);                                                       \
+}
+
+
+#define fontomas__enable_bench_suit(SuitName, BenchesList)                      \
+    extern void add_bench_suit_ ## SuitName (std::list< fontomas::bench::Bench >&); \
+    add_bench_suit_ ## SuitName (BenchesList)
+
+
+#endif//FONTOMAS_BENCH_BENCHGLOBALS_H_
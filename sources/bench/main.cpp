@@ -0,0 +1,156 @@
+#include <cstdio>
+#include <cstring>
+#include <list>
+#include <string>
+#include <vector>
+
+#include <fontomas/debug.h>
+#include <fontomas/macros.h>
+#include <fontomas/version.h>
+
+#include "benchglobals.h"
+
+
+namespace fontomas::bench { ;
+namespace platform { ;
+
+extern std::size_t peak_rss() noexcept;
+extern void reset_peak_rss() noexcept;
+
+}
+}
+
+
+using namespace fontomas::bench;
+
+
+#if !defined(__GNUC__) && !defined(__clang__)
+const void* volatile fontomas::bench::sKeptValue = nullptr;
+#endif
+
+
+namespace {
+
+
+    // a result of report() or report_memory(), which is kept for --json
+    struct Record {
+        std::string name;
+        bool memory;
+        std::size_t nbops;
+        double nsPerOp;
+        double allocsPerOp;
+        std::size_t peakRss;
+        std::size_t reserved, used;
+    };
+
+    std::vector<Record> s_Records;
+
+
+    void write_string(std::FILE* file, const std::string& value) noexcept {
+        std::fputc('"', file);
+        for (char c : value) {
+            if ('"' == c || '\\' == c)
+                std::fputc('\\', file);
+            if (static_cast<unsigned char>(c) >= 0x20)
+                std::fputc(c, file);
+        }
+        std::fputc('"', file);
+    }
+
+
+    /*
+     * Writes all results as
+     *   { "version": "...",
+     *     "results": [ { "name": "...", "ops": N, "ns_per_op": X, "allocs_per_op": Y, "peak_rss": B },
+     *                  { "name": "...", "reserved": B, "used": B }, ... ] }
+     * so runs of different commits can be compared by a script.
+     */
+    bool write_json(const char* path) noexcept {
+        std::FILE* file = std::fopen(path, "w");
+        if (!file)
+            return false;
+
+        std::fprintf(file, "{\n  \"version\": ");
+        write_string(file, fontomas::VersionInfo::toString());
+        std::fprintf(file, ",\n  \"results\": [");
+
+        for (std::size_t i = 0; i < s_Records.size(); ++i) {
+            const Record& r = s_Records[i];
+            std::fprintf(file, "%s\n    { \"name\": ", i > 0 ? "," : "");
+            write_string(file, r.name);
+            if (r.memory) {
+                std::fprintf(file, ", \"reserved\": %zu, \"used\": %zu }", r.reserved, r.used);
+            } else {
+                std::fprintf(file, ", \"ops\": %zu, \"ns_per_op\": %.3f, \"allocs_per_op\": %.3f, \"peak_rss\": %zu }",
+                             r.nbops, r.nsPerOp, r.allocsPerOp, r.peakRss);
+            }
+        }
+
+        std::fprintf(file, "\n  ]\n}\n");
+        return 0 == std::fclose(file);
+    }
+
+
+}
+
+
+void fontomas::bench::report(const char* name, std::size_t nbops, double elapsedNs, uint64_t nballocs) noexcept {
+    const double nsPerOp = nbops > 0 ? elapsedNs / double(nbops) : 0.0;
+    const double allocsPerOp = nbops > 0 ? double(nballocs) / double(nbops) : 0.0;
+    const std::size_t peakRss = platform::peak_rss();
+    std::printf("%-48s %12zu ops %12.2f ns/op %10.2f allocs/op %8zu KB peak\n",
+                name, nbops, nsPerOp, allocsPerOp, peakRss / 1024);
+
+    fontomas__safe_call(s_Records.push_back(Record{ name, false, nbops, nsPerOp, allocsPerOp, peakRss, 0, 0 }));
+}
+
+
+void fontomas::bench::report_memory(const char* name, std::size_t reserved, std::size_t used) noexcept {
+    std::printf("%-48s %12zu B reserved %12zu B used\n", name, reserved, used);
+
+    fontomas__safe_call(s_Records.push_back(Record{ name, true, 0, 0.0, 0.0, 0, reserved, used }));
+}
+
+
+/*
+ * fontomasbench [filter] [--json path]
+ *
+ * Runs benchmarks, which names contain the filter, and writes their results to
+ * the path as JSON, if it's given.
+ */
+int main(int argc, char** argv) {
+    std::list<Bench> allBenches;
+    fontomas__enable_bench_suit(FallbackGraph, allBenches);
+    fontomas__enable_bench_suit(FallbackConcurrentGraph, allBenches);
+    fontomas__enable_bench_suit(FallbackResolutionCache, allBenches);
+    fontomas__enable_bench_suit(FallbackWorkloads, allBenches);
+    fontomas__enable_bench_suit(DI, allBenches);
+
+    const char* filter = nullptr;
+    const char* jsonPath = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (0 == std::strcmp(argv[i], "--json") && i + 1 < argc)
+            jsonPath = argv[++i];
+        else
+            filter = argv[i];
+    }
+
+    std::printf("----------------------------------------\n");
+    std::printf("fontomas v%s benchmarks\n", fontomas::VersionInfo::toString().c_str());
+    std::printf("----------------------------------------\n");
+
+    for (const Bench& b : allBenches) {
+        if (filter && !std::strstr(b.name, filter))
+            continue;
+        // peaks are reported for each function on its own
+        platform::reset_peak_rss();
+        b.func();
+    }
+
+    if (jsonPath && !write_json(jsonPath)) {
+        std::fprintf(stderr, "can't write %s\n", jsonPath);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include <sys/resource.h>
+
+#include <cstdio>
+#include <cstring>
+
+#include "benchglobals.h"
+
+
+namespace fontomas::bench { ;
+namespace platform { ;
+
+
+std::size_t peak_rss() noexcept;
+void reset_peak_rss() noexcept;
+
+
+}
+}
+
+
+using namespace fontomas::bench;
+
+
+std::size_t platform::peak_rss() noexcept {
+    // VmHWM follows resets by clear_refs, while ru_maxrss doesn't
+    if (std::FILE* file = std::fopen("/proc/self/status", "r")) {
+        char line[256];
+        unsigned long long kb = 0;
+        bool found = false;
+        while (!found && std::fgets(line, sizeof(line), file))
+            found = 0 == std::strncmp(line, "VmHWM:", 6) && 1 == std::sscanf(line + 6, "%llu", &kb);
+        std::fclose(file);
+
+        if (found)
+            return std::size_t(kb) * 1024;
+    }
+
+    struct rusage usage;
+    if (0 != getrusage(RUSAGE_SELF, &usage))
+        return 0;
+    return std::size_t(usage.ru_maxrss) * 1024;
+}
+
+
+void platform::reset_peak_rss() noexcept {
+    // it may be not allowed, then the peak is kept since the start
+    if (std::FILE* file = std::fopen("/proc/self/clear_refs", "w")) {
+        std::fputs("5", file);
+        std::fclose(file);
+    }
+}
+
+
+// bench/platform/linux/linux.cpp
@@ -0,0 +1,35 @@
+#include <sys/resource.h>
+
+#include "benchglobals.h"
+
+
+namespace fontomas::bench { ;
+namespace platform { ;
+
+
+std::size_t peak_rss() noexcept;
+void reset_peak_rss() noexcept;
+
+
+}
+}
+
+
+using namespace fontomas::bench;
+
+
+std::size_t platform::peak_rss() noexcept {
+    struct rusage usage;
+    if (0 != getrusage(RUSAGE_SELF, &usage))
+        return 0;
+    // bytes, unlike Linux
+    return std::size_t(usage.ru_maxrss);
+}
+
+
+void platform::reset_peak_rss() noexcept {
+    // the peak can't be reset, so it's kept since the start
+}
+
+
+// bench/platform/macos/macos.cpp
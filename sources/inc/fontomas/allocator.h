@@ -0,0 +1,156 @@
+#pragma once
+#ifndef FONTOMAS_ALLOCATOR_H_
+#define FONTOMAS_ALLOCATOR_H_
+
+
+#include <atomic>
+#include <cinttypes>
+#include <cstddef>
+
+#include <fontomas/exports.h>
+
+
+namespace fontomas { ;
+
+
+
+struct MemoryStats {
+    // bytes taken from the system
+    std::size_t reserved = 0;
+    // bytes, which are actually occupied, always not greater than reserved
+    std::size_t used = 0;
+};
+
+
+/*
+ * A source of raw memory for containers of the library. Every block is
+ * aligned for any fundamental type and must be returned to the allocator,
+ * which gave it, with the same size. Implementations are not thread-safe,
+ * except for HeapAllocator, which is shared by default (see heap).
+ */
+class fontomas_public Allocator {
+public:
+    virtual ~Allocator() noexcept {}
+
+    /*
+     * @return a block of at least size bytes or nullptr if memory is over;
+     *         nullptr if size is 0.
+     */
+    virtual void* allocate(std::size_t size) noexcept = 0;
+    virtual void deallocate(void* block, std::size_t size) noexcept = 0;
+
+    /*
+     * @return reserved bytes and bytes of the blocks, which are not returned
+     *         yet.
+     */
+    virtual MemoryStats stats() const noexcept = 0;
+
+    /*
+     * @return an allocator, which takes each block from the global heap; it is
+     *         used by default.
+     */
+    static Allocator& heap() noexcept;
+};
+
+
+/*
+ * Takes each block from the global heap. It may be used by many threads at
+ * once, so containers of different threads can share it; its statistics are
+ * counted by relaxed atomics, so they are exact only when no thread changes
+ * them.
+ */
+class fontomas_public HeapAllocator final : public Allocator {
+public:
+    HeapAllocator() noexcept : _used(0) {}
+
+    HeapAllocator(const HeapAllocator&) = delete;
+    HeapAllocator& operator = (const HeapAllocator&) = delete;
+
+    void* allocate(std::size_t size) noexcept override;
+    void deallocate(void* block, std::size_t size) noexcept override;
+    MemoryStats stats() const noexcept override;
+
+private:
+    // every block is taken from the heap, so reserved bytes are used ones
+    std::atomic<std::size_t> _used;
+};
+
+
+/*
+ * A monotonic arena for data, which is built once: blocks are cut one after
+ * another from big chunks, which are freed only all together by release() or
+ * by the destructor. Only the last block can be taken back (e.g. when it is
+ * resized), other returned blocks stay reserved.
+ */
+class fontomas_public ArenaAllocator final : public Allocator {
+public:
+    static constexpr std::size_t sDefaultChunkSize = 64 * 1024;
+
+    explicit ArenaAllocator(std::size_t chunkSize = sDefaultChunkSize) noexcept;
+    ~ArenaAllocator() noexcept override;
+
+    ArenaAllocator(const ArenaAllocator&) = delete;
+    ArenaAllocator& operator = (const ArenaAllocator&) = delete;
+
+    void* allocate(std::size_t size) noexcept override;
+    void deallocate(void* block, std::size_t size) noexcept override;
+    MemoryStats stats() const noexcept override { return _stats; }
+
+    // frees all chunks; all blocks, which were given, become invalid
+    void release() noexcept;
+
+private:
+    struct Chunk;
+
+    Chunk* _chunks; // the current chunk goes first
+    uint8_t* _top; // free space of the current chunk
+    uint8_t* _end;
+    uint8_t* _last; // the last given block
+    std::size_t _chunkSize;
+    MemoryStats _stats;
+};
+
+
+/*
+ * A pool for data, which changes: blocks are rounded up to one of the power of
+ * two size classes, each class reuses its returned blocks and cuts new ones
+ * from its own chunks. Blocks bigger than the biggest class are taken from the
+ * global heap. Chunks are freed only by the destructor.
+ */
+class fontomas_public PoolAllocator final : public Allocator {
+public:
+    static constexpr std::size_t sMinBlockSize = 16;
+    static constexpr std::size_t sMaxBlockSize = 4096;
+    static constexpr std::size_t sChunkSize = 64 * 1024;
+
+    PoolAllocator() noexcept;
+    ~PoolAllocator() noexcept override;
+
+    PoolAllocator(const PoolAllocator&) = delete;
+    PoolAllocator& operator = (const PoolAllocator&) = delete;
+
+    void* allocate(std::size_t size) noexcept override;
+    void deallocate(void* block, std::size_t size) noexcept override;
+    MemoryStats stats() const noexcept override { return _stats; }
+
+private:
+    static constexpr std::size_t sNbClasses = 9; // 16, 32, ..., 4096
+
+    struct Chunk;
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    static std::size_t size_class(std::size_t size) noexcept;
+
+    Chunk* _chunks;
+    FreeBlock* _free[sNbClasses];
+    MemoryStats _stats;
+};
+
+
+
+}
+
+
+#endif//FONTOMAS_ALLOCATOR_H_
@@ -3,49 +3,158 @@
 #define FONTOMAS_DI_H_
 
 
+#include <atomic>
+#include <cinttypes>
 #include <memory>
-#include <unordered_map>
 #include <mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
 
 #include <fontomas/debug.h>
 #include <fontomas/exports.h>
+#include <fontomas/macros.h>
 
 
 namespace fontomas { ;
 
 
 
+/*
+ * An id of a service: a 64 bit FNV-1a hash of its name. It depends on the
+ * content of the name only, so it's the same in all shared objects, and it's
+ * computed at compile time for Interface::sServiceName.
+ */
+constexpr uint64_t service_id(const char* name) noexcept {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (; *name; ++name) {
+        hash ^= static_cast<unsigned char>(*name);
+        hash *= 0x100000001B3ull;
+    }
+    // 0 marks a free slot of the table
+    return 0 != hash ? hash : 1;
+}
+
+
+/*
+ * Keeps services by ids of their interfaces (see service_id) in a flat open
+ * addressing table, so a lookup is a probe or two by a constant key rather
+ * than hashing of the name, and containers work the same when fontomas is
+ * linked into several shared objects of a process. resolveService() shares
+ * ownership of a service, while getService() only points to it and doesn't
+ * touch its reference counter, which suits hot paths.
+ *
+ * Slots are kept in an immutable table, which is published by an atomic
+ * pointer: lookups never lock, while a registration copies the table under
+ * a mutex, changes the copy and swaps it in. Registrations are rare, so
+ * copying is cheap enough. A replaced table is deleted by a registration,
+ * once no lookup may read it: like ConcurrentGraph, lookups store an epoch
+ * in slots of their own, so they don't write one shared line (see Mode).
+ *
+ * Registrations and lookups may run in different threads at once only in
+ * an eConcurrent container; the default eSingleThreaded one is for setups,
+ * which register all services before other threads use them.
+ */
 class fontomas_public DIContainer final {
 public:
+    enum Mode : uint8_t {
+        // a service must not be registered, while any other thread looks
+        // up a service of the container or makes a Scope of it: a replaced
+        // table is deleted at once, so lookups don't pin tables. Debug
+        // builds break, if services are registered by more than one thread
+        eSingleThreaded = 0,
+        // services may be registered, while other threads look them up;
+        // each lookup pins the epoch, when it started, in a slot, which is
+        // free, so a replaced table is deleted by a later registration, once
+        // all lookups, which may read it, are gone. A thread takes the slot
+        // of its last lookup again; if all slots are taken, e.g. by nested
+        // lookups, one is added, so lookups never wait for each other.
+        // Replaced services are kept until the container is destroyed, so
+        // pointers of getService() stay valid
+        eConcurrent
+    };
+
+    explicit DIContainer(Mode mode = eSingleThreaded) noexcept;
+    ~DIContainer() noexcept;
+
+    DIContainer(const DIContainer&) = delete;
+    DIContainer& operator = (const DIContainer&) = delete;
+
+    class Scope;
+
+    /*
+     * Registers a service, which is made at once, or replaces the one, which
+     * was registered before. Only an eConcurrent container may be looked up
+     * by other threads meanwhile (see Mode).
+     */
     template <class Interface, typename Impl, typename... Args>
     void registerService(Args &&... args) noexcept {
-        auto foundIt = _serviceTable.find(Interface::sServiceName);
-        if (foundIt != _serviceTable.end()) {
-            _serviceTable.erase(foundIt);
-        }
+        // the service is made out of the lock
+        std::shared_ptr<BaseHolder> holder = ServiceHolder<Interface>::template New<Impl>(std::forward<Args>(args)...);
+        Interface* service = static_cast<ServiceHolder<Interface>*>(holder.get())->pService.get();
 
-        auto res = _serviceTable.insert(std::make_pair(Interface::sServiceName,
-            ServiceHolder<Interface>::template New<Impl>(std::forward<Args>(args)...)));
-        if (!res.second) {
-            // failed to register - just break the execution
-            fontomas__hardbreak;
-        }
+        // a service, which was registered before, is replaced
+        publish(Slot{ sServiceId<Interface>, std::move(holder), Interface::sServiceName, service, eShared });
+    }
+
+    /*
+     * Registers a service, which is made on its first lookup, so services,
+     * which a process never uses, cost nothing. It's made exactly once, even
+     * if many threads look it up at once. Arguments are kept until then.
+     */
+    template <class Interface, typename Impl, typename... Args>
+    void registerLazyService(Args &&... args) noexcept {
+        publish(Slot{ sServiceId<Interface>, FactoryHolder<Interface, Impl, Args...>::New(std::forward<Args>(args)...),
+                      Interface::sServiceName, nullptr, eLazy });
     }
 
+    /*
+     * Registers a service, which is made once per Scope on its first lookup
+     * in the scope and is destroyed with the scope, e.g. a cache of a render
+     * job. It's not found by lookups of the container itself.
+     */
+    template <class Interface, typename Impl, typename... Args>
+    void registerScopedService(Args &&... args) noexcept {
+        publish(Slot{ sServiceId<Interface>, FactoryHolder<Interface, Impl, Args...>::New(std::forward<Args>(args)...),
+                      Interface::sServiceName, nullptr, eScoped });
+    }
+
+    /*
+     * Shares ownership of the service. It may run in many threads at once,
+     * but only an eConcurrent container may be changed meanwhile (see Mode).
+     *
+     * @return an empty pointer if the service was not registered.
+     */
     template <class Interface>
-    std::shared_ptr<Interface> resolveService() noexcept {
-        auto foundIt = _serviceTable.find(Interface::sServiceName);
-        if (foundIt == _serviceTable.end())
+    std::shared_ptr<Interface> resolveService() const noexcept {
+        Lookup lookup(*this);
+        const Slot* slot = find(sServiceId<Interface>);
+        if (!slot || !instance<Interface>(*slot))
             // let the callee to decide, what to do if service was not found
             return std::shared_ptr<Interface>();
 
-        return static_cast<ServiceHolder<Interface>*>(foundIt->second.get())->pService;
+        return static_cast<ServiceHolder<Interface>*>(slot->holder.get())->pService;
+    }
+
+    /*
+     * Gets the service without sharing its ownership. The pointer is valid
+     * while the service is registered, i.e. until it's replaced (unless the
+     * container is eConcurrent) or the container is destroyed.
+     *
+     * @return nullptr if the service was not registered.
+     */
+    template <class Interface>
+    Interface* getService() const noexcept {
+        Lookup lookup(*this);
+        const Slot* slot = find(sServiceId<Interface>);
+        return slot ? instance<Interface>(*slot) : nullptr;
     }
 
     template <typename ServiceUser, typename... Args>
     typename ServiceUser::Ptr resolve(Args &&... args) noexcept {
         using ServiceUserPtr = typename ServiceUser::Ptr;
-        return ServiceUserPtr(new ServiceUser(*this, std::forward<typename std::remove_reference<Args>::type>(args)...));
+        return ServiceUserPtr(new ServiceUser(*this, std::forward<Args>(args)...));
     }
 
     template <typename ServiceUser>
@@ -56,6 +165,15 @@ public:
 private:
     friend class DITester;
 
+    enum Lifetime : uint8_t {
+        // made by registration, shared by all lookups
+        eShared = 0,
+        // made by the first lookup, shared by all lookups
+        eLazy,
+        // made by the first lookup in a scope, shared by lookups of the scope
+        eScoped
+    };
+
     struct BaseHolder {
         using Ptr = std::unique_ptr<BaseHolder>;
 
@@ -75,9 +193,260 @@ private:
         explicit ServiceHolder(Service* pImpl)
             : pService(pImpl)
         {}
+
+        // makes a new service of a lazy or scoped registration
+        virtual Service* make() const noexcept { return nullptr; }
+
+        // the service of a lazy registration, which is made once
+        Service* lazy() noexcept {
+            std::call_once(made, [this]() { pService.reset(make()); });
+            return pService.get();
+        }
+
+        std::once_flag made;
+    };
+
+    template <class Service, class Impl, typename... Args>
+    struct FactoryHolder final : ServiceHolder<Service> {
+        // arguments are copied into each service, which is made
+        std::tuple<typename std::decay<Args>::type...> args;
+
+        static BaseHolder::Ptr New(Args &&... args) noexcept {
+            return BaseHolder::Ptr(new FactoryHolder(std::forward<Args>(args)...));
+        }
+
+        explicit FactoryHolder(Args &&... args)
+            : ServiceHolder<Service>(nullptr)
+            , args(std::forward<Args>(args)...)
+        {}
+
+        Service* make() const noexcept override {
+            return std::apply([](const auto&... a) -> Service* { return new Impl(a...); }, args);
+        }
+    };
+
+    struct Slot {
+        // 0 if the slot is free
+        uint64_t id = 0;
+        // shared by tables, which were copied from each other
+        std::shared_ptr<BaseHolder> holder;
+        const char* name = nullptr;
+        // the service as its interface, so it's got without the holder; it's
+        // nullptr for lazy and scoped services
+        void* service = nullptr;
+        Lifetime lifetime = eShared;
+    };
+
+    // a power of two slots, which are at most half taken, so probes are short
+    using Table = std::vector<Slot>;
+
+    static constexpr std::size_t sMinCapacity = 8;
+
+    template <class Interface>
+    static constexpr uint64_t sServiceId = service_id(Interface::sServiceName);
+
+    struct alignas(64) LookupSlot {
+        // an epoch, when the lookup started, or 0 if the slot is free
+        std::atomic<uint64_t> epoch;
+        // slots are only added, so it's set once, before the slot is seen
+        LookupSlot* next;
+    };
+
+    struct Retired {
+        std::unique_ptr<const Table> table;
+        // the table may be read by lookups, which have older epochs
+        uint64_t epoch;
+    };
+
+    // keeps tables, which a lookup may read, while it lasts; find() must be
+    // called under it
+    class Lookup final {
+    public:
+        explicit Lookup(const DIContainer& di) noexcept
+            : _slot(eConcurrent == di._mode ? di.pin() : nullptr)
+        {}
+        ~Lookup() noexcept {
+            if (_slot)
+                _slot->epoch.store(0, std::memory_order_release);
+        }
+
+        Lookup(const Lookup&) = delete;
+        Lookup& operator = (const Lookup&) = delete;
+
+    private:
+        LookupSlot* _slot;
+    };
+
+    // takes a free slot or adds one and stores the current epoch in it
+    LookupSlot* pin() const noexcept;
+
+    inline const Slot* find(uint64_t id) const noexcept;
+
+    template <class Interface>
+    static Interface* instance(const Slot& slot) noexcept {
+        if (slot.service)
+            return static_cast<Interface*>(slot.service);
+        if (eLazy != slot.lifetime)
+            return nullptr;
+        return static_cast<ServiceHolder<Interface>*>(slot.holder.get())->lazy();
+    }
+
+    // copies the current table with the slot set and swaps the copy in
+    void publish(Slot&& slot) noexcept;
+
+    // deletes replaced tables, which no lookup may read anymore
+    void reclaim() noexcept;
+
+    const Mode _mode;
+    // never reused, so a thread knows, if its last slot is of the container
+    const uint64_t _id;
+    std::atomic<const Table*> _table;
+    // a list of slots of lookups, which were at once at most
+    mutable std::atomic<LookupSlot*> _slots;
+    std::atomic<uint64_t> _epoch;
+
+    // the writer side
+    std::mutex _writer;
+    // a thread, which registered services first, if it's eSingleThreaded
+    std::thread::id _registrar;
+    // replaced tables, which lookups may still read
+    std::vector<Retired> _retired;
+    // services, which were replaced in an eConcurrent container
+    std::vector<std::shared_ptr<BaseHolder>> _replaced;
+};
+
+
+/*
+ * A lifetime of scoped services (see DIContainer::registerScopedService): each
+ * scope makes its own services on their first lookups in the scope and
+ * destroys them with itself. Other services are looked up in the container.
+ * A scope knows scoped services, which were registered before it was made;
+ * it may be used by many threads and must not outlive the container.
+ */
+class fontomas_public DIContainer::Scope final {
+public:
+    explicit Scope(DIContainer& di) noexcept;
+    ~Scope() noexcept;
+
+    Scope(const Scope&) = delete;
+    Scope& operator = (const Scope&) = delete;
+
+    template <class Interface>
+    std::shared_ptr<Interface> resolveService() noexcept {
+        Entry* entry = find(sServiceId<Interface>);
+        if (!entry)
+            return _di.resolveService<Interface>();
+
+        return std::static_pointer_cast<Interface>(instance<Interface>(*entry));
+    }
+
+    template <class Interface>
+    Interface* getService() noexcept {
+        Entry* entry = find(sServiceId<Interface>);
+        if (!entry)
+            return _di.getService<Interface>();
+
+        return static_cast<Interface*>(instance<Interface>(*entry).get());
+    }
+
+private:
+    friend class DITester;
+
+    struct Entry {
+        uint64_t id;
+        std::shared_ptr<BaseHolder> holder;
+        std::once_flag made;
+        std::shared_ptr<void> service;
     };
 
-    std::unordered_map<const char*, BaseHolder::Ptr> _serviceTable;
+    inline Entry* find(uint64_t id) noexcept;
+
+    template <class Interface>
+    static const std::shared_ptr<void>& instance(Entry& entry) noexcept {
+        std::call_once(entry.made, [&entry]() {
+            entry.service = std::shared_ptr<Interface>(
+                static_cast<ServiceHolder<Interface>*>(entry.holder.get())->make());
+        });
+        return entry.service;
+    }
+
+    DIContainer& _di;
+
+    std::unique_ptr<Entry[]> _entries;
+    uint32_t _nbEntries;
+};
+
+
+// DICONTAINER INLINES
+
+
+/*inline*/
+const DIContainer::Slot* DIContainer::find(uint64_t id) const noexcept {
+    // ordered after the epoch of the lookup, so a registration either sees
+    // the lookup or the lookup sees the table of the registration
+    const Table* table = _table.load();
+    if (!table)
+        return nullptr;
+
+    const std::size_t mask = table->size() - 1;
+    for (std::size_t i = std::size_t(id) & mask; ; i = (i + 1) & mask) {
+        const Slot& slot = (*table)[i];
+        if (id == slot.id)
+            return &slot;
+        if (0 == slot.id)
+            return nullptr;
+    }
+}
+
+
+/*inline*/
+DIContainer::Scope::Entry* DIContainer::Scope::find(uint64_t id) noexcept {
+    // scoped services are few, so they are searched in a row
+    for (uint32_t i = 0; i < _nbEntries; ++i) {
+        if (id == _entries[i].id)
+            return &_entries[i];
+    }
+    return nullptr;
+}
+
+
+/*
+ * A service of the container, which is looked up once and then kept by the
+ * object: its pointer is cached by an atomic, so later uses are a load, and
+ * neither making nor using the object takes a lock. Threads, which use it
+ * first at once, may both look it up, but they get the same service. The
+ * service must not be replaced, while the object lives, unless the container
+ * is DIContainer::eConcurrent.
+ */
+template <class Interface>
+class Injected final {
+public:
+    explicit Injected(const DIContainer& di) noexcept
+        : _di(di), _service(nullptr)
+    {}
+
+    Injected(const Injected& other) noexcept
+        : _di(other._di), _service(other._service.load(std::memory_order_relaxed))
+    {}
+
+    Injected& operator = (const Injected&) = delete;
+
+    // nullptr if the service isn't registered
+    Interface* get() const noexcept {
+        Interface* service = _service.load(std::memory_order_acquire);
+        if (!service) {
+            service = _di.getService<Interface>();
+            _service.store(service, std::memory_order_release);
+        }
+        return service;
+    }
+
+    Interface* operator ->() const noexcept { return get(); }
+    explicit operator bool() const noexcept { return nullptr != get(); }
+
+private:
+    const DIContainer& _di;
+    mutable std::atomic<Interface*> _service;
 };
 
 
@@ -85,6 +454,13 @@ private:
 }
 
 
+/*
+ * Factories of the macros below are empty, so objects with injected fields
+ * are made for free; get() is static and, once the service exists, it costs
+ * a load of an atomic pointer.
+ */
+
+
 #define fontomas__provide_as_singleton(Interface, T, ...)                       \
     namespace fontomas_client {                                                 \
         namespace Interface##DI {                                               \
@@ -93,8 +469,17 @@ private:
                 return sInstance;                                               \
             }                                                                   \
             struct Factory {                                                    \
-                Interface& get() noexcept { return GetInstance(); }             \
+                static Interface& get() noexcept {                              \
+                    Interface* p = sCached.load(std::memory_order_acquire);     \
+                    if (!p) {                                                   \
+                        p = &GetInstance();                                     \
+                        sCached.store(p, std::memory_order_release);            \
+                    }                                                           \
+                    return *p;                                                  \
+                }                                                               \
+                static std::atomic<Interface*> sCached;                         \
             };                                                                  \
+            std::atomic<Interface*> Factory::sCached(nullptr);                  \
         }                                                                       \
     }
 
@@ -103,16 +488,23 @@ private:
     namespace fontomas_client {                                                 \
         namespace Interface##DI {                                               \
             struct Factory {                                                    \
-                Factory() {                                                     \
+                static Interface& get() noexcept {                              \
+                    Interface* p = sCached.load(std::memory_order_acquire);     \
+                    return p ? *p : make();                                     \
+                }                                                               \
+                static Interface& make() noexcept {                             \
                     std::unique_lock<std::mutex> lock(sObjectM);                \
                     if (!sObject) sObject.reset(new T(__VA_ARGS__));            \
+                    sCached.store(sObject.get(), std::memory_order_release);    \
+                    return *sObject;                                            \
                 }                                                               \
-                Interface& get() noexcept { return *sObject; }                  \
                 static std::shared_ptr<T> sObject;                              \
                 static std::mutex sObjectM;                                     \
+                static std::atomic<Interface*> sCached;                         \
             };                                                                  \
             std::shared_ptr<T> Factory::sObject;                                \
             std::mutex Factory::sObjectM;                                       \
+            std::atomic<Interface*> Factory::sCached(nullptr);                  \
         }                                                                       \
     }
 
@@ -121,20 +513,22 @@ private:
     namespace fontomas_client {                                                 \
         namespace Interface##DI {                                               \
             struct Factory {                                                    \
-                Interface& get() noexcept { return *sObject; }                  \
-                static Interface* sObject;                                      \
+                static Interface& get() noexcept {                              \
+                    return *sObject.load(std::memory_order_acquire);            \
+                }                                                               \
+                static std::atomic<Interface*> sObject;                         \
             };                                                                  \
-            Interface* Factory::sObject = 0;                                    \
+            std::atomic<Interface*> Factory::sObject(nullptr);                  \
         }                                                                       \
     }
 
 #define fontomas__provide(Interface, Object)                                    \
-    fontomas_client:: Interface##DI::Factory::sObject = Object;
+    fontomas_client:: Interface##DI::Factory::sObject.store(Object, std::memory_order_release);
 
 
 #define fontomas__inject(Interface, Field)                                      \
     struct Interface##Proxy {                                                   \
-        Interface* operator ->() noexcept { return &factory.get(); }            \
+        Interface* operator ->() const noexcept { return &factory.get(); }      \
         fontomas_client:: Interface##DI::Factory factory;                       \
     } Field;
 
@@ -0,0 +1,222 @@
+#pragma once
+#ifndef FONTOMAS_FALLBACK_CONCURRENTGRAPH_H_
+#define FONTOMAS_FALLBACK_CONCURRENTGRAPH_H_
+
+
+#include <atomic>
+#include <cinttypes>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <fontomas/allocator.h>
+#include <fontomas/exports.h>
+#include <fontomas/types.h>
+#include <fontomas/fallback/frozengraph.h>
+#include <fontomas/fallback/graph.h>
+
+
+namespace fontomas { ;
+namespace fallback { ;
+
+
+
+/*
+ * A fallback graph for many reading threads and rare changes. Writers change
+ * a private Graph under a mutex and publish() makes their changes visible:
+ * it freezes the graph into a new version and swaps it in by an atomic
+ * pointer. Readers never lock: each reading thread takes a Reader once, and
+ * the Reader pins the current version by two atomic operations, so lookups
+ * are wait-free. Replaced versions are reclaimed by epochs: a version is
+ * deleted, once no reader can hold it anymore. It wraps Graph, i.e. 16 bit
+ * ids only (see BasicGraph).
+ */
+class fontomas_public ConcurrentGraph final {
+    struct ReaderSlot;
+
+public:
+    static constexpr uint32_t sDefaultMaxReaders = 64;
+
+    /*
+     * A pinned version of the graph: it stays alive while the snapshot
+     * lives, so views of its fallbacks are valid all that time.
+     */
+    class Snapshot final {
+    public:
+        Snapshot(Snapshot&& other) noexcept
+            : _slot(other._slot), _graph(other._graph)
+        {
+            other._slot = nullptr;
+        }
+
+        ~Snapshot() noexcept { unpin(); }
+
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator = (const Snapshot&) = delete;
+        Snapshot& operator = (Snapshot&&) = delete;
+
+        // false if it was pinned by an invalid reader; graph() mustn't be
+        // called then, fallbacks() are empty
+        bool valid() const noexcept { return nullptr != _graph; }
+
+        const FrozenGraph& graph() const noexcept { return *_graph; }
+
+        span_t<const nodeid_t> fallbacks(nodeid_t nodeId, tagid_t tagId) const noexcept {
+            if (!_graph)
+                return span_t<const nodeid_t>();
+            return _graph->fallbacks(nodeId, tagId);
+        }
+
+    private:
+        friend class ConcurrentGraph;
+
+        Snapshot(ReaderSlot* slot, const FrozenGraph* graph) noexcept
+            : _slot(slot), _graph(graph)
+        {}
+
+        inline void unpin() noexcept;
+
+        ReaderSlot* _slot;
+        const FrozenGraph* _graph;
+    };
+
+    /*
+     * A registration of a reading thread. It must be used by one thread at a
+     * time, which also releases its snapshots. Snapshots may be nested: the
+     * epoch of the first one protects all of them, until the last is gone.
+     */
+    class Reader final {
+    public:
+        Reader(Reader&& other) noexcept
+            : _owner(other._owner), _slot(other._slot)
+        {
+            other._slot = nullptr;
+        }
+
+        ~Reader() noexcept;
+
+        Reader(const Reader&) = delete;
+        Reader& operator = (const Reader&) = delete;
+        Reader& operator = (Reader&&) = delete;
+
+        // false if all reader slots were taken
+        bool valid() const noexcept { return nullptr != _slot; }
+
+        // an invalid reader gives an invalid snapshot
+        inline Snapshot pin() const noexcept;
+
+    private:
+        friend class ConcurrentGraph;
+
+        Reader(const ConcurrentGraph* owner, ReaderSlot* slot) noexcept
+            : _owner(owner), _slot(slot)
+        {}
+
+        const ConcurrentGraph* _owner;
+        ReaderSlot* _slot;
+    };
+
+    /*
+     * @param maxReaders number of readers, which can exist at once.
+     * @param allocator gives memory for routes of the writable graph; it must
+     *        outlive the graph.
+     */
+    explicit ConcurrentGraph(uint32_t maxReaders = sDefaultMaxReaders,
+                             Allocator& allocator = Allocator::heap()) noexcept;
+    // all readers must be gone
+    ~ConcurrentGraph() noexcept;
+
+    ConcurrentGraph(const ConcurrentGraph&) = delete;
+    ConcurrentGraph& operator = (const ConcurrentGraph&) = delete;
+
+    /*
+     * Registers a reading thread.
+     *
+     * @return an invalid reader if maxReaders readers exist already.
+     */
+    Reader reader() const noexcept;
+
+    // changes are not visible to readers until they are published
+
+    Graph::Result addNode(nodeid_t nodeId, tagid_t tagId) noexcept;
+    Graph::Result addRoute(nodeid_t nodeId, nodeid_t fallbackId, tagid_t tagId) noexcept;
+    Graph::Result addRoutes(span_t<const Graph::Route> routes, Graph::Result* results = nullptr) noexcept;
+    Graph::Result removeRoute(nodeid_t nodeId, nodeid_t fallbackId, tagid_t tagId) noexcept;
+    Graph::Result detachTag(nodeid_t nodeId, tagid_t tagId) noexcept;
+    Graph::Result removeNode(nodeid_t nodeId) noexcept;
+
+    /*
+     * Compacts the writable graph by a step (see Graph::compactStep). Readers
+     * never wait for it; only writers do, and only for one step.
+     */
+    bool compactStep(uint32_t nbNodes) noexcept;
+
+    /*
+     * Makes all changes visible to readers, which pin a snapshot after it,
+     * and deletes replaced versions, which are not pinned anymore.
+     */
+    void publish() noexcept;
+
+private:
+    friend class Tester;
+
+    struct alignas(64) ReaderSlot {
+        // an epoch, when the current version was pinned, or 0 if the reader
+        // holds no version
+        std::atomic<uint64_t> epoch;
+        std::atomic<bool> taken;
+        // number of live snapshots of the reader; only its thread uses it
+        uint32_t depth;
+    };
+
+    struct Retired {
+        const FrozenGraph* graph;
+        // the version may be pinned by readers, which have older epochs
+        uint64_t epoch;
+    };
+
+    void reclaim() noexcept;
+
+    std::unique_ptr<ReaderSlot[]> _slots;
+    uint32_t _nbSlots;
+
+    std::atomic<const FrozenGraph*> _current;
+    std::atomic<uint64_t> _epoch;
+
+    // the writer side
+    std::mutex _writer;
+    Graph _graph;
+    std::vector<Retired> _retired;
+};
+
+
+// CONCURRENTGRAPH INLINES
+
+
+/*inline*/
+ConcurrentGraph::Snapshot ConcurrentGraph::Reader::pin() const noexcept {
+    if (!_slot)
+        return Snapshot(nullptr, nullptr);
+
+    // the epoch is stored before the version is loaded, so a writer, which
+    // replaces the version later, sees the epoch and keeps the version; a
+    // nested snapshot keeps the older epoch, which protects later versions
+    if (0 == _slot->depth++)
+        _slot->epoch.store(_owner->_epoch.load());
+    return Snapshot(_slot, _owner->_current.load());
+}
+
+
+/*inline*/
+void ConcurrentGraph::Snapshot::unpin() noexcept {
+    if (_slot && 0 == --_slot->depth)
+        _slot->epoch.store(0, std::memory_order_release);
+}
+
+
+
+}
+}
+
+
+#endif//FONTOMAS_FALLBACK_CONCURRENTGRAPH_H_
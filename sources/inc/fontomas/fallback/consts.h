@@ -3,6 +3,8 @@
 #define FONTOMAS_FALLBACK_CONSTS_H_
 
 
+#include <limits>
+
 #include <fontomas/types.h>
 
 
@@ -0,0 +1,58 @@
+#pragma once
+#ifndef FONTOMAS_FALLBACK_COSTS_H_
+#define FONTOMAS_FALLBACK_COSTS_H_
+
+
+#include <cinttypes>
+
+#include <fontomas/exports.h>
+#include <fontomas/types.h>
+
+
+namespace fontomas { ;
+namespace fallback { ;
+
+
+
+/*
+ * Costs of fallback routes, which are asked by Graph::cheapest() while it
+ * searches, e.g. a font, which is resident in the glyph cache, is cheap and
+ * one, which has to be loaded first, is expensive. Costs are asked only for
+ * routes, which the search reaches, so they may reflect the current state of
+ * the renderer. Ids are as wide as ids of the graph (see GraphTraits).
+ */
+template <typename NodeId, typename TagId>
+class fontomas_public BasicCosts {
+public:
+    using nodeid_t = NodeId;
+    using tagid_t = TagId;
+
+    virtual ~BasicCosts() noexcept {}
+
+    /*
+     * @return cost of falling back from the node to the fallback for the tag;
+     *         by default each route costs 1, so the path with fewest routes
+     *         is the cheapest.
+     */
+    virtual uint32_t cost(nodeid_t nodeId, nodeid_t fallbackId, tagid_t tagId) noexcept {
+        (void)nodeId; (void)fallbackId; (void)tagId;
+        return 1;
+    }
+
+    /*
+     * @return true if the node can serve the tag, e.g. the font has glyphs
+     *         of the script.
+     */
+    virtual bool serves(nodeid_t nodeId, tagid_t tagId) noexcept = 0;
+};
+
+
+using Costs = BasicCosts<nodeid_t, tagid_t>;
+
+
+
+}
+}
+
+
+#endif//FONTOMAS_FALLBACK_COSTS_H_
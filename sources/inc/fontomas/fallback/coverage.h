@@ -0,0 +1,96 @@
+#pragma once
+#ifndef FONTOMAS_FALLBACK_COVERAGE_H_
+#define FONTOMAS_FALLBACK_COVERAGE_H_
+
+
+#include <cinttypes>
+
+#include <fontomas/allocator.h>
+#include <fontomas/exports.h>
+#include <fontomas/types.h>
+
+
+namespace fontomas { ;
+namespace fallback { ;
+
+
+
+/*
+ * A set of Unicode codepoints, which a font covers, e.g. taken from its cmap.
+ * It's a two-level bitmap: codepoints are split into blocks of 256, and each
+ * block up to the last covered one refers to a page of 256 bits. Empty and
+ * full blocks share constant pages, so only blocks, which are covered partly,
+ * take memory for their bits. A lookup is two loads.
+ */
+class fontomas_public Coverage final {
+public:
+    static constexpr codepoint_t sMaxCodepoint = 0x10FFFF;
+
+    /*
+     * @param allocator gives memory for the bitmap; it must outlive the
+     *        coverage.
+     */
+    explicit Coverage(Allocator& allocator = Allocator::heap()) noexcept;
+    Coverage(Coverage&& other) noexcept;
+    ~Coverage() noexcept;
+
+    Coverage& operator = (Coverage&& other) noexcept;
+
+    Coverage(const Coverage&) = delete;
+    Coverage& operator = (const Coverage&) = delete;
+
+    bool empty() const noexcept { return 0 == _nbBlocks; }
+
+    /*
+     * Adds codepoints from first to last, both inclusive.
+     *
+     * @return false if the range is reversed or goes beyond sMaxCodepoint,
+     *         or if memory is over.
+     */
+    bool add(codepoint_t first, codepoint_t last) noexcept;
+    bool add(codepoint_t codepoint) noexcept { return add(codepoint, codepoint); }
+
+    bool covers(codepoint_t codepoint) const noexcept {
+        const uint32_t block = codepoint >> sBlockBits;
+        if (block >= _nbBlocks)
+            return false;
+
+        const uint16_t page = _blocks[block];
+        if (page < sFirstPage)
+            return sFullPage == page;
+
+        const uint64_t* bits = _pages + uint32_t(page - sFirstPage) * sWordsPerPage;
+        return 0 != ((bits[(codepoint & sBlockMask) / 64] >> (codepoint % 64)) & 1);
+    }
+
+    // gives back memory, which is reserved for blocks and pages to be added
+    void shrink_to_fit() noexcept;
+
+    MemoryStats memory() const noexcept;
+
+private:
+    static constexpr uint32_t sBlockBits = 8;
+    static constexpr uint32_t sBlockMask = (1u << sBlockBits) - 1;
+    static constexpr uint32_t sWordsPerPage = (1u << sBlockBits) / 64;
+    static constexpr uint32_t sMaxBlocks = (sMaxCodepoint >> sBlockBits) + 1;
+    // pages of blocks: 0 and 1 are the empty and the full one, others are
+    // indices in the pages array plus sFirstPage
+    static constexpr uint16_t sEmptyPage = 0, sFullPage = 1, sFirstPage = 2;
+
+    void release() noexcept;
+
+    Allocator* _allocator;
+    uint16_t* _blocks;
+    uint32_t _nbBlocks, _szBlocks;
+    // sWordsPerPage words per page
+    uint64_t* _pages;
+    uint32_t _nbPages, _szPages;
+};
+
+
+
+}
+}
+
+
+#endif//FONTOMAS_FALLBACK_COVERAGE_H_
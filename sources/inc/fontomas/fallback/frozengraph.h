@@ -0,0 +1,136 @@
+#pragma once
+#ifndef FONTOMAS_FALLBACK_FROZENGRAPH_H_
+#define FONTOMAS_FALLBACK_FROZENGRAPH_H_
+
+
+#include <algorithm>
+#include <cinttypes>
+
+#include <fontomas/exports.h>
+#include <fontomas/mappedfile.h>
+#include <fontomas/types.h>
+
+
+namespace fontomas { ;
+namespace fallback { ;
+
+
+
+template <class Traits> class BasicGraph;
+
+
+/*
+ * An immutable snapshot of a fallback graph, produced by Graph::freeze().
+ * All routes are stored in a compressed sparse row layout: each node owns a
+ * slice of the sorted ids of its tags, which have fallbacks, and each (node,
+ * tag) pair is a range in one flat array of fallback ids. Thus a lookup is a
+ * binary search over tags of the node and a span, and a node takes space
+ * for its own tags only, however large their ids are.
+ *
+ * A snapshot can be saved into a binary file and loaded back by mapping the
+ * file: the tables are stored as they are in memory, after a header with a
+ * format version and a checksum, so lookups are served right from mapped
+ * pages. Ids are as wide as ids of the frozen graph (see GraphTraits) and
+ * their widths are saved too, so a file is loaded only by a snapshot of the
+ * same widths.
+ */
+template <typename NodeId, typename TagId>
+class fontomas_public BasicFrozenGraph final {
+public:
+    using nodeid_t = NodeId;
+    using tagid_t = TagId;
+
+    enum Result { eOk = 0, eNotExists, eFailed, eCorrupted, eNotSupported };
+
+    BasicFrozenGraph() noexcept;
+    BasicFrozenGraph(BasicFrozenGraph&& other) noexcept;
+    ~BasicFrozenGraph() noexcept;
+
+    BasicFrozenGraph& operator = (BasicFrozenGraph&& other) noexcept;
+
+    BasicFrozenGraph(const BasicFrozenGraph&) = delete;
+    BasicFrozenGraph& operator = (const BasicFrozenGraph&) = delete;
+
+    bool empty() const noexcept { return 0 == _nbNodes; }
+
+    /*
+     * Writes the snapshot into the file. An existing file is replaced at
+     * once, so snapshots, which have it loaded, keep the old content.
+     *
+     * @return eFailed if the file can't be written.
+     */
+    Result save(const char* path) const noexcept;
+
+    /*
+     * Replaces the snapshot by one, which was saved into the file. The file
+     * is mapped, not read: nothing is parsed, copied or allocated, and pages
+     * of the file are shared by all processes, which load it. The file must
+     * not change while the snapshot lives.
+     *
+     * @param verify if true, the checksum of the file is checked, which reads
+     *        all its pages once; otherwise the file is trusted.
+     * @return eNotExists if the file can't be opened or mapped; eNotSupported
+     *         if it isn't a snapshot of this format version, byte order and
+     *         widths of ids;
+     *         eCorrupted if its size or checksum are wrong. The snapshot is
+     *         empty on any failure.
+     */
+    Result load(const char* path, bool verify = true) noexcept;
+
+    span_t<const nodeid_t> fallbacks(nodeid_t nodeId, tagid_t tagId) const noexcept {
+        if (nodeId >= _nbNodes)
+            return span_t<const nodeid_t>();
+
+        const tagid_t* first = _tags + _slices[nodeId];
+        const tagid_t* last = _tags + _slices[nodeId + 1];
+        const tagid_t* found = std::lower_bound(first, last, tagId);
+        if (found == last || tagId != *found)
+            return span_t<const nodeid_t>(); // tag is not attached or has no fallbacks
+
+        const uint32_t* offsets = _offsets + (found - _tags);
+        return span_t<const nodeid_t>(_fallbacks + offsets[0], offsets[1] - offsets[0]);
+    }
+
+private:
+    template <class Traits> friend class BasicGraph;
+
+    void allocate(uint32_t nbNodes, uint32_t nbTags, uint32_t nbFallbacks) noexcept;
+    void attach(uint32_t* block, uint32_t nbNodes, uint32_t nbTags) noexcept;
+    void release() noexcept;
+
+    // number of 32 bit words in a block with all tables
+    static std::size_t block_size(uint32_t nbNodes, uint32_t nbTags, uint32_t nbFallbacks) noexcept;
+
+    // one block for all tables below, if the snapshot was built
+    uint32_t* _block;
+    // a file with the tables, if the snapshot was loaded
+    MappedFile _file;
+    // node id is an index in this table; a node owns tags and offsets in
+    // range [_slices[nodeId], _slices[nodeId + 1])
+    uint32_t* _slices;
+    // fallbacks of the i-th tag are stored in range [_offsets[i],
+    // _offsets[i + 1]) of the fallbacks array, so there is one more offset
+    // than tags
+    uint32_t* _offsets;
+    // tags of each node in ascending order
+    tagid_t* _tags;
+    nodeid_t* _fallbacks;
+    // number of nodes in the slices table (max node id + 1)
+    uint32_t _nbNodes;
+};
+
+
+using FrozenGraph = BasicFrozenGraph<nodeid_t, tagid_t>;
+
+// instantiations for graphs of all id widths (see Graph8, Graph, Graph32)
+extern template class BasicFrozenGraph<uint8_t, uint8_t>;
+extern template class BasicFrozenGraph<uint16_t, uint16_t>;
+extern template class BasicFrozenGraph<uint32_t, uint32_t>;
+
+
+
+}
+}
+
+
+#endif//FONTOMAS_FALLBACK_FROZENGRAPH_H_
@@ -3,14 +3,22 @@
 #define FONTOMAS_FALLBACK_GRAPH_H_
 
 
+#include <atomic>
 #include <cinttypes>
 #include <limits>
 #include <list>
+#include <memory>
+#include <type_traits>
 #include <unordered_map>
 #include <vector>
 
+#include <fontomas/allocator.h>
 #include <fontomas/exports.h>
 #include <fontomas/types.h>
+#include <fontomas/fallback/costs.h>
+#include <fontomas/fallback/coverage.h>
+#include <fontomas/fallback/frozengraph.h>
+#include <fontomas/fallback/traversal.h>
 
 
 namespace fontomas { ;
@@ -18,63 +26,514 @@ namespace fallback { ;
 
 
 
-class fontomas_public Graph final {
+/*
+ * Widths of a fallback graph: ids of nodes and tags, and counts of a node -
+ * its tags, fallbacks and parents for a tag and its chain. A count must hold
+ * any number of nodes, e.g. parents of a last resort font, so by default it
+ * is as wide as the ids, but never narrower than 16 bits.
+ */
+template <typename NodeId, typename TagId,
+          typename Count = typename std::conditional<(sizeof(NodeId) > 2 || sizeof(TagId) > 2),
+                                                     uint32_t, uint16_t>::type>
+struct GraphTraits {
+    using nodeid_t = NodeId;
+    using tagid_t = TagId;
+    using count_t = Count;
+};
+
+
+/*
+ * A graph of fallback routes between nodes (e.g. fonts) for tags (e.g.
+ * scripts). The widths of ids and counts are chosen by the traits at compile
+ * time: narrow ids make nodes and routes denser, wide ones allow more nodes
+ * and tags. The graph is instantiated for 8, 16 and 32 bit ids (see Graph8,
+ * Graph and Graph32), so other code sticks to one of them. The traits choose
+ * widths only: memory still comes from the allocator, which is given at run
+ * time.
+ *
+ * Only the graph and its snapshots (see BasicFrozenGraph) are templates. The
+ * layers above them, ConcurrentGraph and ResolutionCache, work with Graph of
+ * 16 bit ids only; Graph8 and Graph32 can't be used with them.
+ *
+ * Const methods only read the graph, so many threads may call them at once,
+ * while no one changes it. Lookups, which cache chains or take buffers of the
+ * graph (chain, firstCovering, cheapest and fallbacksForTags), are not const
+ * and need a lock like changes do; readers, which don't share a lock, should
+ * share a snapshot (see freeze) instead.
+ */
+template <class Traits>
+class fontomas_public BasicGraph final {
 public:
+    using nodeid_t = typename Traits::nodeid_t;
+    using tagid_t = typename Traits::tagid_t;
+    using count_t = typename Traits::count_t;
+    using Costs = BasicCosts<nodeid_t, tagid_t>;
+    using FrozenGraph = BasicFrozenGraph<nodeid_t, tagid_t>;
+
+    static_assert(std::is_unsigned<nodeid_t>::value && std::is_unsigned<tagid_t>::value,
+                  "ids must be unsigned integers");
+    static_assert(sizeof(nodeid_t) <= 4 && sizeof(tagid_t) <= 4, "ids must fit 32 bits");
+    static_assert(std::is_unsigned<count_t>::value && sizeof(count_t) >= 2 &&
+                  sizeof(count_t) >= sizeof(nodeid_t) && sizeof(count_t) >= sizeof(tagid_t),
+                  "a count must hold any number of nodes and tags");
+
+    // a result, when no node is found, and a tag id, which is not valid
+    static constexpr nodeid_t sNotConnected = std::numeric_limits<nodeid_t>::max();
+    static constexpr tagid_t sNoTag = std::numeric_limits<tagid_t>::max();
+
     enum Result { eOk = 0, eExists, eNotExists, eNotAllowed, eFailed };
 
-    Graph() noexcept;
-    ~Graph() noexcept;
+    struct Route {
+        nodeid_t nodeId, fallbackId;
+        tagid_t tagId;
+    };
+
+    struct Query {
+        nodeid_t nodeId;
+        tagid_t tagId;
+    };
+
+    // fallbacks of a query are arena[offset], ..., arena[offset + count - 1]
+    struct Found {
+        uint32_t offset;
+        count_t count;
+    };
+
+    // the cheapest path to a node, which serves a tag; see cheapest()
+    struct Path {
+        nodeid_t nodeId; // the found node or sNotConnected, which is no node
+        uint32_t cost; // the sum of costs of all routes on the path
+        count_t nbhops; // number of routes on the path
+    };
 
-    bool empty() const noexcept { return 0 == _szNodes; }
+    static constexpr uint16_t sDefaultFrontier = 64;
 
+    BasicGraph() noexcept;
+    /*
+     * @param allocator gives memory for all routes of the graph; it must
+     *        outlive the graph.
+     */
+    explicit BasicGraph(Allocator& allocator) noexcept;
+    ~BasicGraph() noexcept;
+
+    BasicGraph(const BasicGraph&) = delete;
+    BasicGraph& operator = (const BasicGraph&) = delete;
+
+    bool empty() const noexcept { return 0 == _nbNodes; }
+
+    // sNoTag is not a valid tag id, so it gets eNotAllowed; so does the max
+    // node id of any width, since it's sNotConnected, which lookups return,
+    // when no node is found
     Result addNode(nodeid_t nodeId, tagid_t tagId) noexcept;
     Result addRoute(nodeid_t nodeId, nodeid_t fallbackId, tagid_t tagId) noexcept;
 
-    uint16_t fallbacks(nodeid_t nodeId, tagid_t tagId,
-                       nodeid_t* buffer, uint16_t szbuffer) const noexcept;
+    /*
+     * Adds a table of routes at once. Capacities are reserved up front and
+     * loops are searched once per tag after all routes of the tag are added.
+     * Routes of a loop are accepted in the order of the table, and only the
+     * route, which closes the loop, is rejected with eNotAllowed, just like
+     * adding the routes one by one with addRoute() does. Fallbacks of a node
+     * keep the order of the routes in the table, across its tags too, so
+     * fallbacksForTags() lists them as after addRoute().
+     *
+     * @param routes routes to add.
+     * @param results optional array of routes.size() elements, which gets
+     *        the result of each route (see addRoute).
+     * @return eOk if all routes were added, otherwise the result of the first
+     *         route in the table, which wasn't added.
+     */
+    Result addRoutes(span_t<const Route> routes, Result* results = nullptr) noexcept;
+    /*
+     * Adds a table of routes like addRoutes() does, with the same results,
+     * but validates routes of different tags on nbThreads threads at once:
+     * tags never share routes, so their loops are searched independently.
+     * Accepted routes are put into the graph by all threads too, except for
+     * reserving arrays, which takes one thread, since the allocator isn't
+     * thread-safe. It's meant for loading big configurations with many tags.
+     * Threads are started by the first call, which needs them, and are kept
+     * for later calls until shrink_to_fit().
+     */
+    Result addRoutesParallel(span_t<const Route> routes, uint32_t nbThreads,
+                             Result* results = nullptr) noexcept;
+
+    /*
+     * Removes the route; the tag stays attached to both nodes.
+     *
+     * @return eNotExists if there is no such route.
+     */
+    Result removeRoute(nodeid_t nodeId, nodeid_t fallbackId, tagid_t tagId) noexcept;
+    /*
+     * Detaches the tag from the node with all routes of the tag from and to
+     * the node.
+     *
+     * @return eNotExists if the tag isn't attached to the node; eNotAllowed
+     *         if it's the last tag of the node (see removeNode).
+     */
+    Result detachTag(nodeid_t nodeId, tagid_t tagId) noexcept;
+    /*
+     * Removes the node with all its routes, e.g. when the font is uninstalled.
+     * Its id becomes vacant (see vacantNode).
+     *
+     * @return eNotExists if the node doesn't exist.
+     */
+    Result removeNode(nodeid_t nodeId) noexcept;
+
+    /*
+     * Gets an id for a new node, which keeps the nodes array dense: the last
+     * removed id, which is still vacant and is less than the last node id,
+     * otherwise the id after the last node.
+     *
+     * @return sNotConnected if all ids are taken; it's never an id of a
+     *         node (see addNode).
+     */
+    nodeid_t vacantNode() noexcept;
+
+    /*
+     * Compacts arrays of up to nbNodes nodes like shrink_to_fit(), starting
+     * from the node, where the previous step stopped; the step, which passes
+     * the last node, cuts the nodes array down to the last node id. Thus the
+     * graph may be compacted in short steps between other work, e.g. between
+     * publications of a ConcurrentGraph.
+     *
+     * @return true if the step finished a pass over all nodes.
+     */
+    bool compactStep(uint32_t nbNodes) noexcept;
+
+    /*
+     * Reserves the nodes array for node ids less than nbNodes exactly, so
+     * adding such nodes doesn't reallocate it. A hint, which isn't greater
+     * than the capacity, is ignored.
+     */
+    void reserve(uint32_t nbNodes) noexcept;
+    /*
+     * Reserves fallbacks of the node for the given tag, so adding up to
+     * nbfallbacks routes doesn't reallocate them. The tag is attached to the
+     * node, if it isn't yet.
+     *
+     * @return eNotExists if the node doesn't exist; eNotAllowed if the tag
+     *         is sNoTag.
+     */
+    Result reserve(nodeid_t nodeId, tagid_t tagId, count_t nbfallbacks) noexcept;
+
+    /*
+     * Gives back memory, which is reserved but not used: all arrays are cut
+     * down to their sizes and reusable buffers are freed. It is meant to be
+     * called, once the graph is loaded; later changes grow arrays again.
+     */
+    void shrink_to_fit() noexcept;
+
+    /*
+     * Copies fallbacks of the node for the given tag into the buffer.
+     *
+     * @return number of copied fallbacks, which is never greater than the
+     *         size of the buffer; use the view overload to get full count.
+     */
+    count_t fallbacks(nodeid_t nodeId, tagid_t tagId,
+                      nodeid_t* buffer, count_t szbuffer) const noexcept;
+
+    /*
+     * Gets a read-only view over fallbacks of the node for the given tag.
+     * The view is invalidated by any change of the graph.
+     *
+     * @return all fallbacks in the insertion order; empty if the node doesn't
+     *         exist or the tag isn't attached to the node.
+     */
+    span_t<const nodeid_t> fallbacks(nodeid_t nodeId, tagid_t tagId) const noexcept;
+
+    /*
+     * Looks fallbacks up for many queries at once, e.g. for all runs of a
+     * paragraph. Lookups are pipelined: memory of the next queries is
+     * prefetched, while the current one is copied, so their cache misses
+     * overlap.
+     *
+     * @param found array of queries.size() elements, which gets where
+     *        fallbacks of each query are in the arena.
+     * @param arena gets fallbacks of all queries one after another.
+     * @return number of fallbacks of all queries; if it's greater than the
+     *         size of the arena, fallbacks, which don't fit, are not copied.
+     */
+    uint32_t fallbacks(span_t<const Query> queries, Found* found,
+                       nodeid_t* arena, uint32_t szarena) const noexcept;
+
+    /*
+     * Collects fallbacks of the node for all tags in the mask, e.g. for all
+     * scripts of a paragraph. Each fallback is listed once, in the order, in
+     * which the node got it as a fallback for any tag.
+     *
+     * @param tagMask a bitset of tag ids: tag t is in the mask, if bit t % 64
+     *        of word t / 64 is set; tags beyond the last word are not.
+     * @return number of found fallbacks; only the first szbuffer of them are
+     *         copied into the buffer.
+     */
+    count_t fallbacksForTags(nodeid_t nodeId, span_t<const uint64_t> tagMask,
+                             nodeid_t* buffer, count_t szbuffer) noexcept;
+
+    /*
+     * Sets codepoints, which the node covers, e.g. from the cmap of its font;
+     * the graph takes the coverage.
+     *
+     * @return eNotExists if the node doesn't exist.
+     */
+    Result setCoverage(nodeid_t nodeId, Coverage&& coverage) noexcept;
+    // gets the coverage of the node or nullptr, if it's not set
+    const Coverage* coverage(nodeid_t nodeId) const noexcept;
+
+    /*
+     * Finds the first node, which covers the codepoint: the node itself, if
+     * it does, otherwise the first node of its chain for the tag (see chain),
+     * which does. Only coverages are tested, so no font has to be loaded;
+     * nodes without a coverage are taken as they cover nothing.
+     *
+     * @return sNotConnected if no node covers the codepoint.
+     */
+    nodeid_t firstCovering(nodeid_t nodeId, tagid_t tagId, codepoint_t codepoint) noexcept;
+    /*
+     * Finds the node like firstCovering() does, but only if it's found
+     * without resolving the chain, so it only reads the graph and many
+     * threads may call it at once.
+     *
+     * @param foundId gets what firstCovering() gives, if true is returned.
+     * @return false if the chain isn't resolved; firstCovering() resolves it.
+     */
+    bool cachedCovering(nodeid_t nodeId, tagid_t tagId, codepoint_t codepoint,
+                        nodeid_t& foundId) const noexcept;
+
+    /*
+     * Gets a transitive fallback chain of the node for the given tag: every
+     * node reachable by routes of the tag, listed once and in a topological
+     * order (a node always precedes its own fallbacks). Chains are resolved
+     * on the first request and cached until a route, which affects them, is
+     * added. The view is invalidated by any change of the graph.
+     *
+     * @return the chain without the node itself; empty if the node doesn't
+     *         exist or the tag isn't attached to the node.
+     */
+    span_t<const nodeid_t> chain(nodeid_t nodeId, tagid_t tagId) noexcept;
+
+    /*
+     * Finds the cheapest path from the node by routes of the tag to a node,
+     * which serves the tag, e.g. a fallback, which avoids a font load. The
+     * search is best-first: nodes are expanded from the cheapest one, so the
+     * first node, which serves, is the cheapest; equal costs are taken in the
+     * order of fallbacks. The node itself is not a candidate.
+     *
+     * @param costs gives costs of routes and tells nodes, which serve.
+     * @param hops optional buffer, which gets nodes of the path after the
+     *        node itself, the found node is the last; only the first szhops
+     *        of them are copied.
+     * @param szfrontier maximum number of nodes, which wait to be expanded;
+     *        when there are more, the most expensive ones are dropped, so a
+     *        path through them may be missed. It's meant to be small (tens
+     *        of nodes): a push into the full frontier takes O(szfrontier).
+     * @return nodeId is sNotConnected if no reachable node serves the tag.
+     */
+    Path cheapest(nodeid_t nodeId, tagid_t tagId, Costs& costs,
+                  nodeid_t* hops = nullptr, count_t szhops = 0,
+                  uint16_t szfrontier = sDefaultFrontier) noexcept;
+
+    /*
+     * Compacts all routes of the graph into an immutable snapshot, which is
+     * optimized for lookups. Later changes of the graph are not reflected in
+     * the snapshot.
+     *
+     * @return an empty snapshot, if the graph has 2^32 - 1 or more pairs of
+     *         a node and a tag with fallbacks or as many fallbacks in total,
+     *         since the snapshot indexes them by 32 bits.
+     */
+    FrozenGraph freeze() const noexcept;
+
+    /*
+     * Gets memory, which is taken by routes of the graph from its allocator:
+     * reserved bytes are sizes of all arrays, used ones are sizes of their
+     * elements, which are in use. Coverages of nodes are counted too, even
+     * if they have their own allocators. Reusable buffers of the graph are
+     * not counted.
+     */
+    MemoryStats memory() const noexcept;
+
+    /*
+     * Gets a number, which grows with every change of routes, tags or
+     * coverages, so results, which are derived from the graph, may be cached
+     * until it changes. Compaction doesn't change it. It may be read by any
+     * thread, even while the graph is changed.
+     */
+    uint64_t generation() const noexcept { return _generation.load(std::memory_order_acquire); }
 
 private:
     friend class Tester;
 
+    using Traversal = BasicTraversal<nodeid_t, count_t>;
+
     struct TagRoutes {
         nodeid_t* fallbacks; // if fallbacks is null, the tag is not attached
-        uint16_t nbfallbacks, szfallbacks;
+        count_t nbfallbacks, szfallbacks;
+        nodeid_t* parents; // nodes, which have a route to this one
+        count_t nbparents, szparents;
+        nodeid_t* chain; // cached transitive fallbacks
+        count_t nbchain;
+        bool resolved; // if false, the chain must be resolved again
+        // position in the topological order of the tag; a route always goes
+        // from a lesser position to a greater one
+        uint32_t order;
     };
 
+    // routes of a node are kept in one of the layouts, which is chosen by the
+    // number of tags and by how close they are to each other:
+    //  eSorted - a few tags: routes[i] belong to tags[i], tags are sorted;
+    //  eDense - close tags: routes[i] belong to tag base + i, no tags array;
+    //  eHashed - many scattered tags: an open addressing table, where
+    //            routes[i] belong to tags[i] and free slots have sNoTag
+    enum Layout : uint8_t { eSorted = 0, eDense, eHashed };
+
+    // a tag t is in a mask, if bit t % 64 is set; thus masks of nodes, which
+    // have only tags less than 64, are exact
     struct NodeInfo {
-        TagRoutes* routes; // tag id is an index in this array
-        uint16_t nbtags, sztags;
+        TagRoutes* routes;
+        tagid_t* tags;
+        count_t nbtags; // number of attached tags
+        count_t sztags; // number of slots in routes and tags arrays
+        tagid_t base;
+        Layout layout;
+        bool wide; // some attached tag is not less than 64
+        uint64_t tagmask; // attached tags
+        // each fallback of the node once, in the order it was added, and a
+        // mask of tags, which have it
+        nodeid_t* edges;
+        uint64_t* edgemasks;
+        count_t nbedges, szedges;
+        Coverage* coverage; // nullptr if it's not set
     };
 
-    enum Color { eWhite = 0, eGray, eBlack };
-    bool is_looped(nodeid_t nodeId, const NodeInfo& info,
-                   nodeid_t fallbackId, tagid_t tagId) const noexcept;
-    bool has_backedge(nodeid_t nodeId, tagid_t tagId,
-                      Color* colors, const TagRoutes& route) const noexcept;
+    bool reorder(nodeid_t nodeId, nodeid_t fallbackId, tagid_t tagId) noexcept;
+    void renumber() noexcept;
+    bool search(nodeid_t startId, nodeid_t stopId, tagid_t tagId, bool forward,
+                uint32_t lower, uint32_t upper, std::vector<nodeid_t>& visited) noexcept;
+    void prepare() noexcept;
+
+    struct TagBatch;
+    struct Workspace;
+    struct Workers;
+
+    void partition(span_t<const Route> routes, Result* results) noexcept;
+    void validate(span_t<const Route> routes, const uint32_t* batch, TagBatch& tag,
+                  Workspace& workspace, Result* results) const noexcept;
+    void apply(span_t<const Route> routes, span_t<const TagBatch> tags, const Result* results,
+               uint32_t nbWorkers) noexcept;
 
     static bool has_route(const NodeInfo& info, nodeid_t fallbackId, tagid_t tagId) noexcept;
+
+    TagRoutes& emplace(NodeInfo& info, tagid_t tagId) noexcept;
+    void erase(NodeInfo& info, tagid_t tagId) noexcept;
+    void cut(nodeid_t nodeId, tagid_t tagId) noexcept;
+    void compact(NodeInfo& info) noexcept;
+    void shrink(NodeInfo& info) noexcept;
+    void relayout(NodeInfo& info, Layout layout, count_t sztags, tagid_t base) noexcept;
+    static TagRoutes* probe(NodeInfo& info, tagid_t tagId) noexcept;
+    // gets a tag of the slot or sNoTag, if the slot is free
+    static tagid_t slot_tag(const NodeInfo& info, count_t slot) noexcept;
+
+    void resolve(nodeid_t nodeId, tagid_t tagId) noexcept;
+    void merge(nodeid_t nodeId, tagid_t tagId) noexcept;
+    void invalidate(nodeid_t nodeId, tagid_t tagId) noexcept;
     
-    inline void allocNodes(nodeid_t maxNodeId) noexcept;
+    // grows the nodes array for the node id; if exact, it's not rounded up
+    // by the growth policy
+    inline void allocNodes(nodeid_t maxNodeId, bool exact = false) noexcept;
+    // makes room for orders, which are taken below and above the bounds
+    inline void reserve_orders(uint32_t nbLow, uint32_t nbHigh) noexcept;
+
+    // gets routes of the tag, which must be attached to the node
+    inline TagRoutes& tag_routes(nodeid_t nodeId, tagid_t tagId) const noexcept;
+    // gets a slot of the tag or nullptr, if the node has no slot for it
+    static inline TagRoutes* lookup(const NodeInfo& info, tagid_t tagId) noexcept;
+    static inline count_t hash(tagid_t tagId) noexcept;
     
     static inline bool exists(const NodeInfo& info) noexcept;
+    static inline void prefetch(const NodeInfo& info, tagid_t tagId) noexcept;
     static inline bool attached(const NodeInfo& info, tagid_t tagId) noexcept;
     static inline bool detached(const NodeInfo& info, tagid_t tagId) noexcept;
-    static inline void attach(NodeInfo& info, tagid_t tagId) noexcept;
-    static inline void detach(NodeInfo& info, tagid_t tagId) noexcept;
-    static inline void connect(NodeInfo& info, nodeid_t fallbackId, tagid_t tagId) noexcept;
-    static inline void release(NodeInfo& info) noexcept;
+    inline bool attach(NodeInfo& info, tagid_t tagId) noexcept;
+    inline void detach(NodeInfo& info, tagid_t tagId) noexcept;
+    inline void connect(NodeInfo& info, nodeid_t fallbackId, tagid_t tagId) noexcept;
+    inline void link(NodeInfo& info, nodeid_t parentId, tagid_t tagId) noexcept;
+    static inline void disconnect(NodeInfo& info, nodeid_t fallbackId, tagid_t tagId) noexcept;
+    static inline void drop_edge(NodeInfo& info, nodeid_t fallbackId, tagid_t tagId) noexcept;
+    static inline void unlink(NodeInfo& info, nodeid_t parentId, tagid_t tagId) noexcept;
+    inline void reserve(NodeInfo& info, tagid_t tagId, uint32_t nbfallbacks, uint32_t nbparents) noexcept;
+    inline void reserve_edges(NodeInfo& info, uint32_t nbedges) noexcept;
+    inline void forget(TagRoutes& route) noexcept;
+    inline void release(NodeInfo& info) noexcept;
+
+    // all arrays below and arrays of routes are allocated by this allocator
+    Allocator& _allocator;
 
     // an array of info for each node; index is a node id, thus it is better to
     // keep set of node ids dense; the node exists if its info contains at least
     // one tag
     NodeInfo* _nodes;
-    // number of allocated elements in the nodes array
-    nodeid_t _szNodes;
+    // number of allocated elements in the nodes array, up to a node for each
+    // node id
+    uint32_t _szNodes;
+    // number of existing nodes
+    uint32_t _nbNodes;
     // max node id, which is registered in the graph
     nodeid_t _maxNodeId;
+
+    // removed node ids, some of which may be taken again (see vacantNode)
+    std::vector<nodeid_t> _vacant;
+    // a node, where the next compaction step starts
+    uint32_t _compacted;
+    // see generation()
+    std::atomic<uint64_t> _generation;
+
+    // bounds of the topological orders: nodes, which are attached as route
+    // sources, are placed before all others, fallbacks - after all others;
+    // they only move outwards, so all orders are renumbered around the middle,
+    // before either of them wraps (see renumber)
+    uint32_t _lowOrder, _highOrder;
+
+    // a node, which waits to be expanded by cheapest(); seq keeps the order
+    // of equal costs
+    struct Candidate {
+        uint32_t cost, seq;
+        nodeid_t nodeId;
+    };
+
+    // buffers, which are reused between calls to avoid allocations; per node
+    // arrays are indexed by a node id
+    struct Scratch {
+        // all searches share the traversal; only colors of marks are used,
+        // to mark nodes while a chain is merged inside of a traversal
+        Traversal traversal, marks;
+        std::vector<nodeid_t> buffer, stack, forward, backward;
+        std::vector<uint32_t> orders;
+        std::vector<uint32_t> batch, added, buckets;
+        // buffers of threads, which validate routes, and the threads, which
+        // are kept between calls (see addRoutesParallel)
+        std::vector<Workspace> workspaces;
+        std::unique_ptr<Workers> workers;
+        std::vector<Result> results;
+        // the frontier of cheapest() and costs of nodes, which it reached
+        std::vector<Candidate> frontier;
+        std::vector<uint32_t> costs;
+        std::vector<nodeid_t> parents;
+
+        void release() noexcept;
+    };
+    Scratch _scratch;
 };
 
 
+using Graph8 = BasicGraph<GraphTraits<uint8_t, uint8_t>>;
+using Graph = BasicGraph<GraphTraits<nodeid_t, tagid_t>>;
+using Graph32 = BasicGraph<GraphTraits<uint32_t, uint32_t>>;
+
+// all instantiations are compiled once by the library
+extern template class BasicGraph<GraphTraits<uint8_t, uint8_t>>;
+extern template class BasicGraph<GraphTraits<uint16_t, uint16_t>>;
+extern template class BasicGraph<GraphTraits<uint32_t, uint32_t>>;
+
+
 
 }
 }
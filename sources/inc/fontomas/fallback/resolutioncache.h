@@ -0,0 +1,154 @@
+#pragma once
+#ifndef FONTOMAS_FALLBACK_RESOLUTIONCACHE_H_
+#define FONTOMAS_FALLBACK_RESOLUTIONCACHE_H_
+
+
+#include <cinttypes>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+
+#include <fontomas/allocator.h>
+#include <fontomas/di.h>
+#include <fontomas/exports.h>
+#include <fontomas/types.h>
+#include <fontomas/fallback/graph.h>
+#include <fontomas/services/logger.h>
+
+
+namespace fontomas { ;
+namespace fallback { ;
+
+
+
+/*
+ * Memoizes Graph::firstCovering() for (node, tag, codepoint) triples, which
+ * repeat over and over in real text. Entries live in fixed open addressing
+ * tables, so nothing is allocated after construction; when a probe window is
+ * full, one of its entries is evicted. The table is split into shards, each
+ * under its own lock, so threads, which hit different shards, don't contend.
+ * A key packs the triple into 64 bits, so it works with Graph, i.e. 16 bit
+ * ids, only (see BasicGraph).
+ *
+ * Misses are looked up in the graph under a shared lock, if chains, which
+ * they need, are resolved already, so they don't wait for each other; only
+ * resolving a chain locks the graph for one thread.
+ *
+ * The graph may be changed between calls of resolve(), e.g. under a lock,
+ * which callers of resolve() share, but not while any of them runs. Entries
+ * are tagged by the generation of the graph (see Graph::generation), so a
+ * change drops them: a shard is cleared on its first lookup after it. The
+ * graph must outlive the cache.
+ */
+class fontomas_public ResolutionCache final {
+public:
+    using Ptr = std::unique_ptr<ResolutionCache>;
+
+    static constexpr uint32_t sDefaultCapacity = 4096;
+    static constexpr uint32_t sDefaultShards = 8;
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    };
+
+    /*
+     * @param capacity number of entries, it's rounded up to a power of two,
+     *        which gives at least sProbes entries per shard.
+     * @param nbShards number of shards, it's rounded up to a power of two.
+     * @param allocator gives memory for entries; it must outlive the cache.
+     */
+    explicit ResolutionCache(Graph& graph,
+                             uint32_t capacity = sDefaultCapacity,
+                             uint32_t nbShards = sDefaultShards,
+                             Allocator& allocator = Allocator::heap()) noexcept;
+    /*
+     * The same, but statistics are reported to services::Logger, which is
+     * taken from the container (see report), e.g. by
+     * di.resolve<ResolutionCache>(graph).
+     */
+    ResolutionCache(DIContainer& di, Graph& graph,
+                    uint32_t capacity = sDefaultCapacity,
+                    uint32_t nbShards = sDefaultShards,
+                    Allocator& allocator = Allocator::heap()) noexcept;
+    ~ResolutionCache() noexcept;
+
+    ResolutionCache(const ResolutionCache&) = delete;
+    ResolutionCache& operator = (const ResolutionCache&) = delete;
+
+    /*
+     * Gets what graph.firstCovering(nodeId, tagId, codepoint) gives, from the
+     * cache if the triple was resolved since the last change of the graph.
+     * May be called by many threads at once.
+     */
+    nodeid_t resolve(nodeid_t nodeId, tagid_t tagId, codepoint_t codepoint) noexcept;
+
+    // drops all entries; statistics are kept
+    void clear() noexcept;
+
+    // hits and misses of all shards since the cache was made
+    Stats stats() const noexcept;
+
+    /*
+     * Prints hits, misses and the hit rate to the logger at the Info level,
+     * if there is a logger and the level is visible.
+     */
+    void report() const noexcept;
+
+    // memory of the tables, which is taken from the allocator
+    MemoryStats memory() const noexcept;
+
+private:
+    friend class Tester;
+
+    // number of entries, where a key may be placed, starting from its hash
+    static constexpr uint32_t sProbes = 4;
+
+    // a key has the high bit set, so a zeroed entry is free
+    struct Entry {
+        uint64_t key;
+        nodeid_t nodeId;
+    };
+
+    struct alignas(64) Shard {
+        std::mutex lock;
+        Entry* entries;
+        // a generation of the graph, which the entries were resolved at
+        uint64_t generation;
+        uint64_t hits, misses;
+        // a next entry in a probe window to evict
+        uint32_t victim;
+    };
+
+    /*
+     * Drops entries of the shard, which is locked, if they are older than the
+     * generation of the graph.
+     *
+     * @return false if the shard is already at a later generation.
+     */
+    bool sync(Shard& shard, uint64_t generation) noexcept;
+
+    static inline uint64_t key(nodeid_t nodeId, tagid_t tagId, codepoint_t codepoint) noexcept;
+    static inline uint64_t hash(uint64_t key) noexcept;
+
+    Graph& _graph;
+    // misses, which find their chains resolved, share the graph; resolving
+    // a chain changes it, so it takes the graph alone
+    std::shared_mutex _graphLock;
+
+    std::shared_ptr<services::Logger> _logger;
+    Allocator& _allocator;
+
+    std::unique_ptr<Shard[]> _shards;
+    uint32_t _nbShards;
+    // entries per shard minus 1
+    uint32_t _mask;
+};
+
+
+
+}
+}
+
+
+#endif//FONTOMAS_FALLBACK_RESOLUTIONCACHE_H_
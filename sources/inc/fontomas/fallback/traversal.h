@@ -0,0 +1,135 @@
+#pragma once
+#ifndef FONTOMAS_FALLBACK_TRAVERSAL_H_
+#define FONTOMAS_FALLBACK_TRAVERSAL_H_
+
+
+#include <cinttypes>
+#include <vector>
+
+#include <fontomas/exports.h>
+#include <fontomas/types.h>
+
+
+namespace fontomas { ;
+namespace fallback { ;
+
+
+
+/*
+ * A reusable state of iterative traversals over node ids: an explicit stack
+ * and a color map, which keeps 2 bits per node. Both are grown by reset() and
+ * reused later, so a traversal neither recurses nor allocates, while each node
+ * is pushed at most once. Only words of the color map, which were painted, are
+ * cleared by the next reset().
+ *
+ * Node ids and cursors are as wide as ids and counts of the graph, which
+ * walks its nodes (see GraphTraits).
+ */
+template <typename NodeId, typename Cursor>
+class fontomas_public BasicTraversal final {
+public:
+    using nodeid_t = NodeId;
+    using cursor_t = Cursor;
+
+    enum Color : uint8_t { eWhite = 0, eGray, eBlack };
+
+    BasicTraversal() noexcept = default;
+
+    BasicTraversal(const BasicTraversal&) = delete;
+    BasicTraversal& operator = (const BasicTraversal&) = delete;
+
+    /*
+     * Prepares a new traversal over node ids less than nbNodes: the stack
+     * gets empty and all nodes get white.
+     */
+    void reset(std::size_t nbNodes) noexcept;
+    // frees all memory; the next reset() allocates it again
+    void release() noexcept;
+
+    Color color(nodeid_t id) const noexcept {
+        return Color((_colors[id / sNodesPerWord] >> shift(id)) & sColorMask);
+    }
+
+    void paint(nodeid_t id, Color color) noexcept {
+        uint64_t& word = _colors[id / sNodesPerWord];
+        if (0 == word)
+            touch(id / sNodesPerWord);
+
+        word = (word & ~(sColorMask << shift(id))) | (uint64_t(color) << shift(id));
+    }
+
+    bool empty() const noexcept { return _stack.empty(); }
+    nodeid_t top() const noexcept { return _stack.back(); }
+
+    // a walk, which visits nodes in any order: a pushed node is painted gray
+    // and stays gray, so it is never pushed again
+
+    void push(nodeid_t id) noexcept {
+        paint(id, eGray);
+        _stack.push_back(id);
+    }
+
+    nodeid_t pop() noexcept {
+        const nodeid_t id = _stack.back();
+        _stack.pop_back();
+        return id;
+    }
+
+    // a depth-first walk: the stack is a path from the root, where each node
+    // keeps a cursor - an index of its next adjacent node to visit; a node is
+    // gray while it is on the path and gets the given color, when it leaves
+
+    void enter(nodeid_t id) noexcept {
+        push(id);
+        _cursors.push_back(0);
+    }
+
+    cursor_t& cursor() noexcept { return _cursors.back(); }
+
+    nodeid_t leave(Color color = eBlack) noexcept {
+        _cursors.pop_back();
+
+        const nodeid_t id = pop();
+        paint(id, color);
+        return id;
+    }
+
+private:
+    static constexpr uint32_t sNodesPerWord = 32;
+    static constexpr uint64_t sColorMask = 3;
+
+    static constexpr uint32_t shift(nodeid_t id) noexcept {
+        return (id % sNodesPerWord) * 2;
+    }
+
+    void touch(uint32_t word) noexcept {
+        // a word, which was painted white back, may be listed twice
+        if (_painted.size() < _painted.capacity())
+            _painted.push_back(word);
+        else
+            _overflow = true;
+    }
+
+    std::vector<uint64_t> _colors;
+    std::vector<nodeid_t> _stack;
+    std::vector<cursor_t> _cursors;
+    // indices of painted words; once it is full, reset() clears all words
+    std::vector<uint32_t> _painted;
+    bool _overflow = false;
+};
+
+
+using Traversal = BasicTraversal<nodeid_t, uint16_t>;
+
+// instantiations for graphs of all id widths (see Graph8, Graph, Graph32)
+extern template class BasicTraversal<uint8_t, uint16_t>;
+extern template class BasicTraversal<uint16_t, uint16_t>;
+extern template class BasicTraversal<uint32_t, uint32_t>;
+
+
+
+}
+}
+
+
+#endif//FONTOMAS_FALLBACK_TRAVERSAL_H_
@@ -36,6 +36,17 @@
 #endif
 
 
+// hints the cpu to load the cache line of the address; never faults
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#   include <xmmintrin.h>
+#   define fontomas__prefetch(Address) _mm_prefetch(reinterpret_cast<const char*>(Address), _MM_HINT_T0)
+#elif defined(__GNUC__) || defined(__clang__)
+#   define fontomas__prefetch(Address) __builtin_prefetch((Address))
+#else
+#   define fontomas__prefetch(Address) ((void)(Address))
+#endif
+
+
 #define fontomas__safe_call(Call) { fontomas__try { Call; } fontomas__catchall { fontomas__hardbreak; } }
 
 
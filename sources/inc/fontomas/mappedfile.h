@@ -0,0 +1,72 @@
+#pragma once
+#ifndef FONTOMAS_MAPPEDFILE_H_
+#define FONTOMAS_MAPPEDFILE_H_
+
+
+#include <cinttypes>
+#include <cstddef>
+#include <utility>
+
+#include <fontomas/exports.h>
+
+
+namespace fontomas { ;
+
+
+
+/*
+ * A whole file, which is mapped into memory for reading. Pages of the file
+ * are loaded on demand and shared by all processes, which map the same file.
+ */
+class fontomas_public MappedFile final {
+public:
+    MappedFile() noexcept : _data(nullptr), _size(0) {}
+
+    MappedFile(MappedFile&& other) noexcept
+        : MappedFile()
+    {
+        swap(other);
+    }
+
+    ~MappedFile() noexcept { close(); }
+
+    MappedFile& operator = (MappedFile&& other) noexcept {
+        if (this != &other) {
+            close();
+            swap(other);
+        }
+        return *this;
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator = (const MappedFile&) = delete;
+
+    /*
+     * Maps the file; a file, which was mapped before, is unmapped.
+     *
+     * @return false if the file can't be opened or mapped, e.g. it's empty.
+     */
+    bool open(const char* path) noexcept;
+    void close() noexcept;
+
+    bool empty() const noexcept { return nullptr == _data; }
+
+    const uint8_t* data() const noexcept { return _data; }
+    std::size_t size() const noexcept { return _size; }
+
+    void swap(MappedFile& other) noexcept {
+        std::swap(_data, other._data);
+        std::swap(_size, other._size);
+    }
+
+private:
+    const uint8_t* _data;
+    std::size_t _size;
+};
+
+
+
+}
+
+
+#endif//FONTOMAS_MAPPEDFILE_H_
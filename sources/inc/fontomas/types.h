@@ -4,6 +4,7 @@
 
 
 #include <cinttypes>
+#include <cstddef>
 
 
 namespace fontomas { ;
@@ -11,6 +12,32 @@ namespace fontomas { ;
 
 using tagid_t = uint16_t;
 using nodeid_t = uint16_t;
+using codepoint_t = uint32_t;
+
+
+/*
+ * A non-owning read-only (if T is const) view over a contiguous sequence of
+ * elements. Must not outlive the storage it was taken from.
+ */
+template <class T>
+class span_t {
+public:
+    constexpr span_t() noexcept : _data(nullptr), _size(0) {}
+    constexpr span_t(T* data, std::size_t size) noexcept : _data(data), _size(size) {}
+
+    constexpr T* data() const noexcept { return _data; }
+    constexpr std::size_t size() const noexcept { return _size; }
+    constexpr bool empty() const noexcept { return 0 == _size; }
+
+    constexpr T* begin() const noexcept { return _data; }
+    constexpr T* end() const noexcept { return _data + _size; }
+
+    constexpr T& operator [] (std::size_t i) const noexcept { return _data[i]; }
+
+private:
+    T* _data;
+    std::size_t _size;
+};
 
 
 
@@ -0,0 +1,255 @@
+#include "fontomas/allocator.h"
+
+#include <algorithm>
+#include <new>
+
+#include "fontomas/debug.h"
+
+
+using namespace fontomas;
+
+
+namespace {
+
+
+    constexpr std::size_t sAlignment = alignof(std::max_align_t);
+
+    constexpr std::size_t align(std::size_t size) noexcept {
+        return (size + sAlignment - 1) & ~(sAlignment - 1);
+    }
+
+
+}
+
+
+// ALLOCATOR PUBLICS
+
+
+/*static*/
+Allocator& Allocator::heap() noexcept {
+    static HeapAllocator sHeap;
+    return sHeap;
+}
+
+
+// HEAPALLOCATOR PUBLICS
+
+
+void* HeapAllocator::allocate(std::size_t size) noexcept {
+    if (0 == size)
+        return nullptr;
+
+    void* block = ::operator new(size, std::nothrow);
+    if (block)
+        _used.fetch_add(size, std::memory_order_relaxed);
+
+    return block;
+}
+
+
+void HeapAllocator::deallocate(void* block, std::size_t size) noexcept {
+    if (!block)
+        return;
+
+    ::operator delete(block);
+
+    _used.fetch_sub(size, std::memory_order_relaxed);
+}
+
+
+MemoryStats HeapAllocator::stats() const noexcept {
+    MemoryStats stats;
+    stats.reserved = stats.used = _used.load(std::memory_order_relaxed);
+    return stats;
+}
+
+
+// ARENAALLOCATOR PUBLICS
+
+
+struct alignas(std::max_align_t) ArenaAllocator::Chunk {
+    Chunk* next;
+    std::size_t size; // with the header
+};
+
+
+ArenaAllocator::ArenaAllocator(std::size_t chunkSize) noexcept
+    : _chunks(nullptr)
+    , _top(nullptr), _end(nullptr), _last(nullptr)
+    , _chunkSize(std::max(align(chunkSize), align(sizeof(Chunk)) + sAlignment))
+{}
+
+
+ArenaAllocator::~ArenaAllocator() noexcept {
+    release();
+}
+
+
+void* ArenaAllocator::allocate(std::size_t size) noexcept {
+    if (0 == size)
+        return nullptr;
+
+    size = align(size);
+
+    if (std::size_t(_end - _top) < size) {
+        // a big block gets its own chunk, which goes after the current one,
+        // so the free space of the current chunk is not lost
+        const bool own = size > _chunkSize / 4;
+        const std::size_t szchunk = own ? sizeof(Chunk) + size : _chunkSize;
+
+        Chunk* chunk = static_cast<Chunk*>(::operator new(szchunk, std::nothrow));
+        if (!chunk)
+            return nullptr;
+
+        chunk->size = szchunk;
+        _stats.reserved += szchunk;
+
+        uint8_t* data = reinterpret_cast<uint8_t*>(chunk + 1);
+        if (own && _chunks) {
+            chunk->next = _chunks->next;
+            _chunks->next = chunk;
+
+            _stats.used += size;
+            return data;
+        }
+
+        chunk->next = _chunks;
+        _chunks = chunk;
+        _top = data;
+        _end = reinterpret_cast<uint8_t*>(chunk) + szchunk;
+    }
+
+    _last = _top;
+    _top += size;
+    _stats.used += size;
+
+    return _last;
+}
+
+
+void ArenaAllocator::deallocate(void* block, std::size_t size) noexcept {
+    if (!block)
+        return;
+
+    size = align(size);
+    _stats.used -= size;
+
+    if (block == _last && _last + size == _top) {
+        _top = _last;
+        _last = nullptr;
+    }
+}
+
+
+void ArenaAllocator::release() noexcept {
+    while (_chunks) {
+        Chunk* next = _chunks->next;
+        ::operator delete(_chunks);
+        _chunks = next;
+    }
+
+    _top = _end = _last = nullptr;
+    _stats = MemoryStats();
+}
+
+
+// POOLALLOCATOR PUBLICS
+
+
+struct alignas(std::max_align_t) PoolAllocator::Chunk {
+    Chunk* next;
+};
+
+
+PoolAllocator::PoolAllocator() noexcept
+    : _chunks(nullptr)
+{
+    std::fill(_free, _free + sNbClasses, nullptr);
+}
+
+
+PoolAllocator::~PoolAllocator() noexcept {
+    while (_chunks) {
+        Chunk* next = _chunks->next;
+        ::operator delete(_chunks);
+        _chunks = next;
+    }
+}
+
+
+void* PoolAllocator::allocate(std::size_t size) noexcept {
+    if (0 == size)
+        return nullptr;
+
+    if (size > sMaxBlockSize) {
+        void* block = ::operator new(size, std::nothrow);
+        if (block) {
+            _stats.reserved += size;
+            _stats.used += size;
+        }
+        return block;
+    }
+
+    const std::size_t cls = size_class(size);
+    const std::size_t szblock = sMinBlockSize << cls;
+
+    if (!_free[cls]) {
+        Chunk* chunk = static_cast<Chunk*>(::operator new(sizeof(Chunk) + sChunkSize, std::nothrow));
+        if (!chunk)
+            return nullptr;
+
+        chunk->next = _chunks;
+        _chunks = chunk;
+        _stats.reserved += sizeof(Chunk) + sChunkSize;
+
+        // the chunk is cut into blocks of the class, the first one on top
+        uint8_t* data = reinterpret_cast<uint8_t*>(chunk + 1);
+        for (std::size_t offset = sChunkSize; offset >= szblock; offset -= szblock) {
+            FreeBlock* block = reinterpret_cast<FreeBlock*>(data + offset - szblock);
+            block->next = _free[cls];
+            _free[cls] = block;
+        }
+    }
+
+    FreeBlock* block = _free[cls];
+    _free[cls] = block->next;
+    _stats.used += szblock;
+
+    return block;
+}
+
+
+void PoolAllocator::deallocate(void* block, std::size_t size) noexcept {
+    if (!block)
+        return;
+
+    if (size > sMaxBlockSize) {
+        ::operator delete(block);
+        _stats.reserved -= size;
+        _stats.used -= size;
+        return;
+    }
+
+    const std::size_t cls = size_class(size);
+
+    FreeBlock* freed = static_cast<FreeBlock*>(block);
+    freed->next = _free[cls];
+    _free[cls] = freed;
+    _stats.used -= sMinBlockSize << cls;
+}
+
+
+// POOLALLOCATOR PRIVATES
+
+
+/*static*/
+std::size_t PoolAllocator::size_class(std::size_t size) noexcept {
+    std::size_t cls = 0;
+    while ((sMinBlockSize << cls) < size)
+        ++cls;
+    return cls;
+}
+
+
+
+// allocator.cpp
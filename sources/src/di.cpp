@@ -0,0 +1,216 @@
+#include "fontomas/di.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <new>
+
+
+using namespace fontomas;
+
+
+// ids of containers, which were made so far
+static std::atomic<uint64_t> sNbContainers(0);
+
+
+// DICONTAINER PUBLICS
+
+
+DIContainer::DIContainer(Mode mode) noexcept
+    : _mode(mode)
+    , _id(sNbContainers.fetch_add(1, std::memory_order_relaxed) + 1)
+    , _table(nullptr)
+    , _slots(nullptr)
+    , _epoch(1)
+{}
+
+
+DIContainer::~DIContainer() noexcept {
+    delete _table.load();
+
+    LookupSlot* slot = _slots.load();
+    while (slot) {
+        LookupSlot* next = slot->next;
+        delete slot;
+        slot = next;
+    }
+}
+
+
+// DICONTAINER SCOPE PUBLICS
+
+
+DIContainer::Scope::Scope(DIContainer& di) noexcept
+    : _di(di)
+    , _nbEntries(0)
+{
+    // registrations, which are replaced later, are kept by entries
+    Lookup lookup(_di);
+    const Table* table = _di._table.load();
+    if (!table)
+        return;
+
+    for (const Slot& slot : *table)
+        _nbEntries += eScoped == slot.lifetime && 0 != slot.id ? 1 : 0;
+    if (0 == _nbEntries)
+        return;
+
+    _entries.reset(new (std::nothrow) Entry[_nbEntries]);
+    if (!_entries)
+        fontomas__hardbreak; // out of memory
+
+    uint32_t i = 0;
+    for (const Slot& slot : *table) {
+        if (eScoped == slot.lifetime && 0 != slot.id) {
+            _entries[i].id = slot.id;
+            _entries[i].holder = slot.holder;
+            ++i;
+        }
+    }
+}
+
+
+DIContainer::Scope::~Scope() noexcept {
+    // services of the scope, which aren't shared, are destroyed with entries
+}
+
+
+// DICONTAINER PRIVATES
+
+
+void DIContainer::publish(Slot&& slot) noexcept {
+    std::lock_guard<std::mutex> lock(_writer);
+
+#ifdef _DEBUG
+    // lookups of other threads may read a table, which is deleted below
+    if (eSingleThreaded == _mode) {
+        if (std::thread::id() == _registrar)
+            _registrar = std::this_thread::get_id();
+        else if (std::this_thread::get_id() != _registrar)
+            fontomas__hardbreak; // use eConcurrent
+    }
+#endif
+
+    const Table* current = _table.load(std::memory_order_relaxed);
+
+    // the slot may be new, so the table grows, once it's half taken
+    std::size_t nbTaken = 1;
+    if (current) {
+        for (const Slot& s : *current)
+            nbTaken += 0 != s.id ? 1 : 0;
+    }
+    std::size_t capacity = current ? current->size() : sMinCapacity;
+    while (2 * nbTaken > capacity)
+        capacity *= 2;
+
+    Table* table = new (std::nothrow) Table();
+    if (!table)
+        fontomas__hardbreak; // out of memory
+    fontomas__safe_call(table->resize(capacity));
+
+    const std::size_t mask = capacity - 1;
+    auto place = [table, mask](Slot&& s) noexcept {
+        std::size_t i = std::size_t(s.id) & mask;
+        while (0 != (*table)[i].id && s.id != (*table)[i].id)
+            i = (i + 1) & mask;
+
+        // ids of different names are the same, so one service would shadow
+        // the other; rename one of them
+        if (s.id == (*table)[i].id && 0 != std::strcmp(s.name, (*table)[i].name))
+            fontomas__hardbreak;
+
+        (*table)[i] = std::move(s);
+    };
+
+    if (current) {
+        for (const Slot& s : *current) {
+            if (0 != s.id)
+                place(Slot(s));
+        }
+    }
+
+    // a replaced service outlives its tables, so its pointers, which were
+    // got before, stay valid
+    if (eConcurrent == _mode && current) {
+        const Slot* replaced = find(slot.id);
+        if (replaced) {
+            fontomas__safe_call(_replaced.push_back(replaced->holder));
+        }
+    }
+    place(std::move(slot));
+
+    _table.store(table);
+
+    if (!current)
+        return;
+    if (eSingleThreaded == _mode) {
+        delete current;
+        return;
+    }
+
+    // lookups, which store their epoch after it's advanced, can't read the
+    // replaced table
+    const uint64_t epoch = _epoch.fetch_add(1) + 1;
+    fontomas__safe_call(_retired.push_back(Retired{ std::unique_ptr<const Table>(current), epoch }));
+
+    reclaim();
+}
+
+
+DIContainer::LookupSlot* DIContainer::pin() const noexcept {
+    // a thread takes the slot of its last lookup again, so threads rarely
+    // try one slot or share its cache line
+    struct Last {
+        uint64_t containerId;
+        LookupSlot* slot;
+    };
+    thread_local Last tLast{ 0, nullptr };
+
+    // the epoch is stored before the table is loaded, so a registration,
+    // which replaces the table later, sees the epoch and keeps the table
+    auto take = [this](LookupSlot& slot) -> bool {
+        uint64_t free = 0;
+        return 0 == slot.epoch.load(std::memory_order_relaxed)
+            && slot.epoch.compare_exchange_strong(free, _epoch.load());
+    };
+
+    if (_id == tLast.containerId && take(*tLast.slot))
+        return tLast.slot;
+
+    LookupSlot* slot = _slots.load();
+    while (slot && !take(*slot))
+        slot = slot->next;
+
+    // all slots are taken, so one more is added rather than waited for; the
+    // slot is pinned, before it's seen by registrations
+    if (!slot) {
+        slot = new (std::nothrow) LookupSlot();
+        if (!slot)
+            fontomas__hardbreak; // out of memory
+
+        slot->epoch.store(_epoch.load(), std::memory_order_relaxed);
+        slot->next = _slots.load(std::memory_order_relaxed);
+        while (!_slots.compare_exchange_weak(slot->next, slot))
+            ;
+    }
+
+    tLast = Last{ _id, slot };
+    return slot;
+}
+
+
+void DIContainer::reclaim() noexcept {
+    uint64_t oldest = std::numeric_limits<uint64_t>::max();
+    for (const LookupSlot* slot = _slots.load(); slot; slot = slot->next) {
+        const uint64_t epoch = slot->epoch.load();
+        if (0 != epoch)
+            oldest = std::min(oldest, epoch);
+    }
+
+    auto pinned = std::partition(_retired.begin(), _retired.end(),
+        [oldest](const Retired& retired) { return retired.epoch > oldest; });
+    _retired.erase(pinned, _retired.end());
+}
+
+
+// di.cpp
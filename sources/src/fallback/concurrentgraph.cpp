@@ -0,0 +1,144 @@
+#include "fontomas/fallback/concurrentgraph.h"
+
+#include <algorithm>
+#include <limits>
+#include <new>
+
+#include "fontomas/debug.h"
+#include "fontomas/macros.h"
+
+
+using namespace fontomas;
+using namespace fontomas::fallback;
+
+
+// CONCURRENTGRAPH PUBLICS
+
+
+ConcurrentGraph::ConcurrentGraph(uint32_t maxReaders, Allocator& allocator) noexcept
+    : _slots(new (std::nothrow) ReaderSlot[maxReaders])
+    , _nbSlots(maxReaders)
+    , _current(new (std::nothrow) FrozenGraph())
+    , _epoch(1)
+    , _graph(allocator)
+{
+    if (!_slots || !_current.load())
+        fontomas__hardbreak; // out of memory
+
+    for (uint32_t i = 0; i < _nbSlots; ++i) {
+        _slots[i].epoch.store(0, std::memory_order_relaxed);
+        _slots[i].taken.store(false, std::memory_order_relaxed);
+        _slots[i].depth = 0;
+    }
+}
+
+
+ConcurrentGraph::~ConcurrentGraph() noexcept {
+    delete _current.load();
+    for (const Retired& retired : _retired)
+        delete retired.graph;
+}
+
+
+ConcurrentGraph::Reader ConcurrentGraph::reader() const noexcept {
+    for (uint32_t i = 0; i < _nbSlots; ++i) {
+        bool taken = false;
+        if (_slots[i].taken.compare_exchange_strong(taken, true, std::memory_order_acquire))
+            return Reader(this, &_slots[i]);
+    }
+
+    return Reader(this, nullptr);
+}
+
+
+Graph::Result ConcurrentGraph::addNode(nodeid_t nodeId, tagid_t tagId) noexcept {
+    std::lock_guard<std::mutex> lock(_writer);
+    return _graph.addNode(nodeId, tagId);
+}
+
+
+Graph::Result ConcurrentGraph::addRoute(nodeid_t nodeId, nodeid_t fallbackId, tagid_t tagId) noexcept {
+    std::lock_guard<std::mutex> lock(_writer);
+    return _graph.addRoute(nodeId, fallbackId, tagId);
+}
+
+
+Graph::Result ConcurrentGraph::addRoutes(span_t<const Graph::Route> routes, Graph::Result* results) noexcept {
+    std::lock_guard<std::mutex> lock(_writer);
+    return _graph.addRoutes(routes, results);
+}
+
+
+Graph::Result ConcurrentGraph::removeRoute(nodeid_t nodeId, nodeid_t fallbackId, tagid_t tagId) noexcept {
+    std::lock_guard<std::mutex> lock(_writer);
+    return _graph.removeRoute(nodeId, fallbackId, tagId);
+}
+
+
+Graph::Result ConcurrentGraph::detachTag(nodeid_t nodeId, tagid_t tagId) noexcept {
+    std::lock_guard<std::mutex> lock(_writer);
+    return _graph.detachTag(nodeId, tagId);
+}
+
+
+Graph::Result ConcurrentGraph::removeNode(nodeid_t nodeId) noexcept {
+    std::lock_guard<std::mutex> lock(_writer);
+    return _graph.removeNode(nodeId);
+}
+
+
+bool ConcurrentGraph::compactStep(uint32_t nbNodes) noexcept {
+    std::lock_guard<std::mutex> lock(_writer);
+    return _graph.compactStep(nbNodes);
+}
+
+
+void ConcurrentGraph::publish() noexcept {
+    std::lock_guard<std::mutex> lock(_writer);
+
+    FrozenGraph* published = new (std::nothrow) FrozenGraph(_graph.freeze());
+    if (!published)
+        fontomas__hardbreak; // out of memory
+
+    fontomas__safe_call(_retired.reserve(_retired.size() + 1));
+
+    // readers, which pin a snapshot after the epoch is advanced, can't get
+    // the replaced version
+    const FrozenGraph* replaced = _current.exchange(published);
+    const uint64_t epoch = _epoch.fetch_add(1) + 1;
+    _retired.push_back(Retired{replaced, epoch});
+
+    reclaim();
+}
+
+
+// CONCURRENTGRAPH PRIVATES
+
+
+void ConcurrentGraph::reclaim() noexcept {
+    uint64_t oldest = std::numeric_limits<uint64_t>::max();
+    for (uint32_t i = 0; i < _nbSlots; ++i) {
+        const uint64_t epoch = _slots[i].epoch.load();
+        if (0 != epoch)
+            oldest = std::min(oldest, epoch);
+    }
+
+    auto pinned = std::partition(_retired.begin(), _retired.end(),
+        [oldest](const Retired& retired) { return retired.epoch > oldest; });
+    for (auto it = pinned; it != _retired.end(); ++it)
+        delete it->graph;
+    _retired.erase(pinned, _retired.end());
+}
+
+
+// READER PUBLICS
+
+
+ConcurrentGraph::Reader::~Reader() noexcept {
+    if (_slot)
+        _slot->taken.store(false, std::memory_order_release);
+}
+
+
+
+// fallback/concurrentgraph.cpp
@@ -0,0 +1,163 @@
+#include "fontomas/fallback/coverage.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+
+using namespace fontomas;
+using namespace fontomas::fallback;
+
+
+namespace {
+
+
+    // grows or shrinks the array, new elements are zeroed; the array is kept
+    // if memory is over
+    template <typename T>
+    bool resize(Allocator& allocator, T** pArr, uint32_t curSize, uint32_t newSize) noexcept {
+        T* resized = static_cast<T*>(allocator.allocate(sizeof(T) * newSize));
+        if (!resized && newSize > 0)
+            return false;
+
+        const uint32_t nbkept = std::min(curSize, newSize);
+        if (nbkept > 0)
+            std::memcpy(resized, *pArr, sizeof(T) * nbkept);
+        if (newSize > nbkept)
+            std::memset(resized + nbkept, 0, sizeof(T) * (newSize - nbkept));
+
+        allocator.deallocate(*pArr, sizeof(T) * curSize);
+        *pArr = resized;
+
+        return true;
+    }
+
+
+    // arrays grow by a half, so adding ranges in the order of a cmap takes
+    // amortized O(1) per block
+    uint32_t grown(uint32_t capacity, uint32_t needed, uint32_t limit) noexcept {
+        return std::min(std::max(needed, capacity + capacity / 2), limit);
+    }
+
+
+}
+
+
+// COVERAGE PUBLICS
+
+
+Coverage::Coverage(Allocator& allocator) noexcept
+    : _allocator(&allocator)
+    , _blocks(nullptr), _nbBlocks(0), _szBlocks(0)
+    , _pages(nullptr), _nbPages(0), _szPages(0)
+{}
+
+
+Coverage::Coverage(Coverage&& other) noexcept
+    : Coverage(*other._allocator)
+{
+    *this = std::move(other);
+}
+
+
+Coverage::~Coverage() noexcept {
+    release();
+}
+
+
+Coverage& Coverage::operator = (Coverage&& other) noexcept {
+    if (this == &other)
+        return *this;
+
+    release();
+
+    std::swap(_allocator, other._allocator);
+    std::swap(_blocks, other._blocks);
+    std::swap(_nbBlocks, other._nbBlocks);
+    std::swap(_szBlocks, other._szBlocks);
+    std::swap(_pages, other._pages);
+    std::swap(_nbPages, other._nbPages);
+    std::swap(_szPages, other._szPages);
+
+    return *this;
+}
+
+
+bool Coverage::add(codepoint_t first, codepoint_t last) noexcept {
+    if (first > last || last > sMaxCodepoint)
+        return false;
+
+    const uint32_t lastBlock = last >> sBlockBits;
+    if (lastBlock >= _szBlocks) {
+        const uint32_t szBlocks = grown(_szBlocks, lastBlock + 1, sMaxBlocks);
+        if (!resize(*_allocator, &_blocks, _szBlocks, szBlocks))
+            return false;
+        _szBlocks = szBlocks;
+    }
+    _nbBlocks = std::max(_nbBlocks, lastBlock + 1);
+
+    for (uint32_t block = first >> sBlockBits; block <= lastBlock; ++block) {
+        const codepoint_t lo = std::max(first, codepoint_t(block << sBlockBits));
+        const codepoint_t hi = std::min(last, codepoint_t(block << sBlockBits | sBlockMask));
+
+        uint16_t& page = _blocks[block];
+        if (sFullPage == page)
+            continue;
+
+        // a whole block needs no bits; a page, which it had, stays unused
+        if (0 == (lo & sBlockMask) && sBlockMask == (hi & sBlockMask)) {
+            page = sFullPage;
+            continue;
+        }
+
+        if (sEmptyPage == page) {
+            if (_nbPages == _szPages) {
+                const uint32_t szPages = grown(_szPages, _nbPages + 1, sMaxBlocks);
+                if (!resize(*_allocator, &_pages, _szPages * sWordsPerPage, szPages * sWordsPerPage))
+                    return false;
+                _szPages = szPages;
+            }
+            page = uint16_t(sFirstPage + _nbPages++);
+        }
+
+        uint64_t* bits = _pages + uint32_t(page - sFirstPage) * sWordsPerPage;
+        for (codepoint_t c = lo & sBlockMask; c <= (hi & sBlockMask); ++c)
+            bits[c / 64] |= uint64_t(1) << (c % 64);
+    }
+
+    return true;
+}
+
+
+void Coverage::shrink_to_fit() noexcept {
+    if (_szBlocks != _nbBlocks && resize(*_allocator, &_blocks, _szBlocks, _nbBlocks))
+        _szBlocks = _nbBlocks;
+    if (_szPages != _nbPages && resize(*_allocator, &_pages, _szPages * sWordsPerPage, _nbPages * sWordsPerPage))
+        _szPages = _nbPages;
+}
+
+
+MemoryStats Coverage::memory() const noexcept {
+    MemoryStats stats;
+    stats.reserved = sizeof(uint16_t) * _szBlocks + sizeof(uint64_t) * sWordsPerPage * _szPages;
+    stats.used = sizeof(uint16_t) * _nbBlocks + sizeof(uint64_t) * sWordsPerPage * _nbPages;
+    return stats;
+}
+
+
+// COVERAGE PRIVATES
+
+
+void Coverage::release() noexcept {
+    _allocator->deallocate(_blocks, sizeof(uint16_t) * _szBlocks);
+    _allocator->deallocate(_pages, sizeof(uint64_t) * sWordsPerPage * _szPages);
+
+    _blocks = nullptr;
+    _pages = nullptr;
+    _nbBlocks = _szBlocks = 0;
+    _nbPages = _szPages = 0;
+}
+
+
+
+// fallback/coverage.cpp
@@ -0,0 +1,277 @@
+#include "fontomas/fallback/frozengraph.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <new>
+#include <string>
+#include <utility>
+
+#include "fontomas/debug.h"
+#include "fontomas/macros.h"
+
+
+using namespace fontomas;
+using namespace fontomas::fallback;
+
+
+namespace {
+
+
+    constexpr uint32_t sMagic = uint32_t('F') | uint32_t('M') << 8 | uint32_t('F') << 16 | uint32_t('G') << 24;
+    constexpr uint32_t sFormatVersion = 3;
+
+    // a file is the header and the block of tables right after it; numbers
+    // are in the byte order of the machine, which saved the file, so another
+    // byte order is seen as a wrong magic
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t nbNodes;
+        uint32_t nbTags; // of all nodes
+        uint32_t nbFallbacks;
+        uint16_t szNodeId; // bytes of a node id
+        uint16_t szTagId; // bytes of a tag id
+        uint64_t checksum; // of the block
+    };
+
+    static_assert(sizeof(FileHeader) == 32, "tables must stay aligned after the header");
+
+
+    // Fletcher-64 over 32 bit words; sums are reduced once per a run of
+    // words, which can't overflow them
+    uint64_t checksum(const uint32_t* words, std::size_t nbWords) noexcept {
+        constexpr uint64_t sModulo = 0xffffffffull;
+        constexpr std::size_t sRunLength = 1024;
+
+        uint64_t sum1 = 0, sum2 = 0;
+        while (nbWords > 0) {
+            const std::size_t run = std::min(nbWords, sRunLength);
+            for (std::size_t i = 0; i < run; ++i) {
+                sum1 += words[i];
+                sum2 += sum1;
+            }
+            sum1 %= sModulo;
+            sum2 %= sModulo;
+
+            words += run;
+            nbWords -= run;
+        }
+
+        return sum2 << 32 | sum1;
+    }
+
+
+    // number of 32 bit words, which hold the bytes
+    std::size_t words(std::size_t nbBytes) noexcept {
+        return (nbBytes + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+    }
+
+
+    // checks that the table of indices starts from 0, never decreases and
+    // ends with the last index, so every range of it is within [0, last]
+    bool ascending(const uint32_t* table, std::size_t size, uint32_t last) noexcept {
+        if (0 != table[0] || last != table[size - 1])
+            return false;
+
+        for (std::size_t i = 1; i < size; ++i) {
+            if (table[i] < table[i - 1])
+                return false;
+        }
+
+        return true;
+    }
+
+
+}
+
+
+// FROZENGRAPH PUBLICS
+
+
+template <typename NodeId, typename TagId>
+BasicFrozenGraph<NodeId, TagId>::BasicFrozenGraph() noexcept
+    : _block(nullptr)
+    , _slices(nullptr), _offsets(nullptr), _tags(nullptr), _fallbacks(nullptr)
+    , _nbNodes(0)
+{}
+
+
+template <typename NodeId, typename TagId>
+BasicFrozenGraph<NodeId, TagId>::BasicFrozenGraph(BasicFrozenGraph&& other) noexcept
+    : BasicFrozenGraph()
+{
+    *this = std::move(other);
+}
+
+
+template <typename NodeId, typename TagId>
+BasicFrozenGraph<NodeId, TagId>::~BasicFrozenGraph() noexcept {
+    release();
+}
+
+
+template <typename NodeId, typename TagId>
+auto BasicFrozenGraph<NodeId, TagId>::operator = (BasicFrozenGraph&& other) noexcept -> BasicFrozenGraph& {
+    if (this == &other)
+        return *this;
+
+    release();
+
+    std::swap(_block, other._block);
+    _file.swap(other._file);
+    std::swap(_slices, other._slices);
+    std::swap(_offsets, other._offsets);
+    std::swap(_tags, other._tags);
+    std::swap(_fallbacks, other._fallbacks);
+    std::swap(_nbNodes, other._nbNodes);
+
+    return *this;
+}
+
+
+template <typename NodeId, typename TagId>
+auto BasicFrozenGraph<NodeId, TagId>::save(const char* path) const noexcept -> Result {
+    FileHeader header = {};
+    header.magic = sMagic;
+    header.version = sFormatVersion;
+    header.nbNodes = _nbNodes;
+    header.nbTags = _nbNodes > 0 ? _slices[_nbNodes] : 0;
+    header.nbFallbacks = _nbNodes > 0 ? _offsets[header.nbTags] : 0;
+    header.szNodeId = sizeof(nodeid_t);
+    header.szTagId = sizeof(tagid_t);
+
+    const std::size_t nbWords = block_size(header.nbNodes, header.nbTags, header.nbFallbacks);
+    header.checksum = checksum(_slices, nbWords);
+
+    // the file is replaced at once, so snapshots, which have the old file
+    // loaded (this one too), keep it
+    std::string written;
+    fontomas__safe_call(written = std::string(path) + ".tmp");
+
+    std::FILE* file = std::fopen(written.c_str(), "wb");
+    if (!file)
+        return eFailed;
+
+    bool ok = 1 == std::fwrite(&header, sizeof(header), 1, file);
+    if (ok && nbWords > 0)
+        ok = nbWords == std::fwrite(_slices, sizeof(uint32_t), nbWords, file);
+    ok = 0 == std::fclose(file) && ok;
+
+    if (!ok || 0 != std::rename(written.c_str(), path)) {
+        std::remove(written.c_str());
+        return eFailed;
+    }
+
+    return eOk;
+}
+
+
+template <typename NodeId, typename TagId>
+auto BasicFrozenGraph<NodeId, TagId>::load(const char* path, bool verify) noexcept -> Result {
+    release();
+
+    MappedFile file;
+    if (!file.open(path))
+        return eNotExists;
+
+    if (file.size() < sizeof(FileHeader))
+        return eCorrupted;
+
+    const FileHeader& header = *reinterpret_cast<const FileHeader*>(file.data());
+    if (sMagic != header.magic || sFormatVersion != header.version ||
+        sizeof(nodeid_t) != header.szNodeId || sizeof(tagid_t) != header.szTagId)
+    {
+        return eNotSupported;
+    }
+
+    const std::size_t nbWords = block_size(header.nbNodes, header.nbTags, header.nbFallbacks);
+    if (file.size() != sizeof(FileHeader) + sizeof(uint32_t) * nbWords)
+        return eCorrupted;
+
+    // mapped pages are read-only, but a loaded snapshot is never written
+    uint32_t* block = const_cast<uint32_t*>(reinterpret_cast<const uint32_t*>(file.data() + sizeof(FileHeader)));
+    if (verify && checksum(block, nbWords) != header.checksum)
+        return eCorrupted;
+
+    if (0 == header.nbNodes)
+        return eOk;
+
+    // lookups trust the tables, so a file with a valid checksum or a trusted
+    // one still must not lead them out of the tables
+    const uint32_t* offsets = block + header.nbNodes + 1;
+    if (!ascending(block, std::size_t(header.nbNodes) + 1, header.nbTags) ||
+        !ascending(offsets, std::size_t(header.nbTags) + 1, header.nbFallbacks))
+    {
+        return eCorrupted;
+    }
+
+    attach(block, header.nbNodes, header.nbTags);
+    _file = std::move(file);
+
+    return eOk;
+}
+
+
+// FROZENGRAPH PRIVATES
+
+
+template <typename NodeId, typename TagId>
+void BasicFrozenGraph<NodeId, TagId>::allocate(uint32_t nbNodes, uint32_t nbTags, uint32_t nbFallbacks) noexcept {
+    release();
+
+    const std::size_t nbWords = block_size(nbNodes, nbTags, nbFallbacks);
+    _block = new (std::nothrow) uint32_t[nbWords];
+    if (!_block)
+        fontomas__hardbreak; // out of memory
+
+    attach(_block, nbNodes, nbTags);
+
+    // paddings after tags and fallbacks are zeroed, so saved files are the
+    // same for the same graphs
+    _block[nbWords - 1] = 0;
+    const uint32_t* fallbacks = reinterpret_cast<const uint32_t*>(_fallbacks);
+    if (fallbacks > _block + nbNodes + 1 + nbTags + 1)
+        *(reinterpret_cast<uint32_t*>(_fallbacks) - 1) = 0;
+}
+
+
+template <typename NodeId, typename TagId>
+void BasicFrozenGraph<NodeId, TagId>::attach(uint32_t* block, uint32_t nbNodes, uint32_t nbTags) noexcept {
+    _slices = block;
+    _offsets = _slices + nbNodes + 1;
+    _tags = reinterpret_cast<tagid_t*>(_offsets + nbTags + 1);
+    _fallbacks = reinterpret_cast<nodeid_t*>(_offsets + nbTags + 1 + words(sizeof(tagid_t) * nbTags));
+    _nbNodes = nbNodes;
+}
+
+
+template <typename NodeId, typename TagId>
+void BasicFrozenGraph<NodeId, TagId>::release() noexcept {
+    delete[] _block;
+    _file.close();
+
+    _block = _slices = _offsets = nullptr;
+    _tags = nullptr;
+    _fallbacks = nullptr;
+    _nbNodes = 0;
+}
+
+
+
+/*static*/
+template <typename NodeId, typename TagId>
+std::size_t BasicFrozenGraph<NodeId, TagId>::block_size(uint32_t nbNodes, uint32_t nbTags, uint32_t nbFallbacks) noexcept {
+    if (0 == nbNodes)
+        return 0;
+
+    return std::size_t(nbNodes) + 1 + std::size_t(nbTags) + 1 +
+           words(sizeof(tagid_t) * nbTags) + words(sizeof(nodeid_t) * nbFallbacks);
+}
+
+
+template class fontomas::fallback::BasicFrozenGraph<uint8_t, uint8_t>;
+template class fontomas::fallback::BasicFrozenGraph<uint16_t, uint16_t>;
+template class fontomas::fallback::BasicFrozenGraph<uint32_t, uint32_t>;
+
+
+// fallback/frozengraph.cpp
@@ -1,34 +1,315 @@
 #include "fontomas/fallback/graph.h"
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <cstring>
-#include <memory>
+#include <mutex>
+#include <new>
+#include <numeric>
+#include <thread>
+#include <utility>
 
 #include "fontomas/debug.h"
 #include "fontomas/macros.h"
+#include "fontomas/fallback/consts.h"
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#   include <immintrin.h>
+#elif defined(__ARM_NEON)
+#   include <arm_neon.h>
+#endif
 
 
 using namespace fontomas;
 using namespace fontomas::fallback;
 
 
-static constexpr nodeid_t sNodesReserved = 16;
-static constexpr uint16_t sTagsReserved = 16;
-static constexpr uint16_t sFallbacksReserved = 16;
+static constexpr uint32_t sNodesReserved = 16;
+static constexpr uint16_t sSortedTagsMax = 8;
+static constexpr uint32_t sDenseSpanFactor = 4;
+static constexpr uint16_t sHashedTagsMin = 16;
+static constexpr uint16_t sFallbacksReserved = 4;
+static constexpr uint32_t sMaskBits = 64;
+
+// number of ids of nodes: the max value of the id type is sNotConnected, so
+// it's not one, and the rest fit a 32 bit size
+template <typename Id>
+static constexpr uint32_t sMaxIds = uint32_t(std::numeric_limits<Id>::max());
+// number of elements of any array of a node
+template <typename Count>
+static constexpr uint32_t sMaxCount = std::numeric_limits<Count>::max();
+
+static constexpr uint32_t sMiddleOrder = 1u << 31;
 
 
 namespace {
 
 
+    // stable sort of items by keys, which are ids: 8 and 16 bit keys are
+    // sorted in one pass, 32 bit ones - in two passes by their 16 bit halves,
+    // the low one first
+    template <class Key>
+    inline void counting_sort(const std::vector<uint32_t>& items, std::vector<uint32_t>& sorted,
+                              std::vector<uint32_t>& buckets, Key key) noexcept
+    {
+        using key_t = decltype(key(uint32_t()));
+        static_assert(sizeof(key_t) <= 4, "keys must fit 32 bits");
+
+        constexpr uint32_t sKeyBits = 8 * sizeof(key_t);
+        constexpr uint32_t sDigitBits = std::min<uint32_t>(sKeyBits, 16);
+        constexpr std::size_t sNbBuckets = (std::size_t(1) << sDigitBits) + 1;
+
+        std::vector<uint32_t> low; // items sorted by low halves of keys
+        const std::vector<uint32_t>* input = &items;
+        for (uint32_t shift = 0; shift < sKeyBits; shift += sDigitBits) {
+            std::vector<uint32_t>& output = shift + sDigitBits < sKeyBits ? low : sorted;
+            auto digit = [&key, shift](uint32_t item) -> std::size_t {
+                return (uint32_t(key(item)) >> shift) & ((uint32_t(1) << sDigitBits) - 1);
+            };
+
+            fontomas__safe_call(buckets.assign(sNbBuckets, 0));
+            fontomas__safe_call(output.resize(items.size()));
+
+            for (uint32_t item : *input)
+                ++buckets[digit(item) + 1];
+            for (std::size_t i = 1; i < sNbBuckets; ++i)
+                buckets[i] += buckets[i - 1];
+            for (uint32_t item : *input)
+                output[buckets[digit(item)]++] = item;
+
+            input = &output;
+        }
+    }
+
+
+    // splits items, which are sorted by a key, into about nbChunks ranges,
+    // so all items of a key are in one range
+    template <class Key>
+    void split(const std::vector<uint32_t>& items, uint32_t nbChunks, std::vector<uint32_t>& bounds,
+               Key key) noexcept
+    {
+        const std::size_t step = std::max<std::size_t>(1, items.size() / std::max(nbChunks, 1u));
+
+        bounds.clear();
+        fontomas__safe_call(bounds.push_back(0));
+        for (std::size_t i = step; i < items.size();) {
+            while (i < items.size() && key(items[i]) == key(items[i - 1]))
+                ++i;
+            if (i < items.size())
+                fontomas__safe_call(bounds.push_back(uint32_t(i)));
+            i += step;
+        }
+        fontomas__safe_call(bounds.push_back(uint32_t(items.size())));
+    }
+
+
+    // the end of a Pearce-Kelly step (see reorder): ancestors of the node and
+    // descendants of the fallback, which were found between them, take the
+    // positions, which they had, ancestors first and each set in its order;
+    // positions must have room for both sets
+    template <typename Id, typename Position>
+    void shift(std::vector<Id>& backward, std::vector<Id>& forward, std::vector<uint32_t>& positions,
+               Position position) noexcept
+    {
+        auto byPosition = [&position](Id a, Id b) -> bool { return position(a) < position(b); };
+        std::sort(backward.begin(), backward.end(), byPosition);
+        std::sort(forward.begin(), forward.end(), byPosition);
+
+        positions.clear();
+        for (Id id : backward)
+            positions.push_back(position(id));
+        for (Id id : forward)
+            positions.push_back(position(id));
+        std::sort(positions.begin(), positions.end());
+
+        std::size_t i = 0;
+        for (Id id : backward)
+            position(id) = positions[i++];
+        for (Id id : forward)
+            position(id) = positions[i++];
+    }
+
+
+    template <typename T>
+    inline T* allocate(Allocator& allocator, std::size_t size) noexcept {
+        T* arr = static_cast<T*>(allocator.allocate(sizeof(T) * size));
+        if (!arr && size > 0)
+            fontomas__hardbreak; // out of memory
+
+        return arr;
+    }
+
+
+    template <typename T>
+    inline void deallocate(Allocator& allocator, T* arr, std::size_t size) noexcept {
+        allocator.deallocate(arr, sizeof(T) * size);
+    }
+
+
+    inline uint64_t mask_bit(uint32_t tagId) noexcept {
+        return uint64_t(1) << (tagId % sMaskBits);
+    }
+
+
+#if defined(__AVX2__)
+    constexpr uint32_t sVectorBytes = 32;
+
+    // checks if a vector of ids has the id
+    template <typename Id>
+    inline bool has_id(const Id* ids, Id id) noexcept {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ids));
+        if (1 == sizeof(Id))
+            return 0 != _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(char(id))));
+        if (2 == sizeof(Id))
+            return 0 != _mm256_movemask_epi8(_mm256_cmpeq_epi16(v, _mm256_set1_epi16(short(id))));
+        return 0 != _mm256_movemask_epi8(_mm256_cmpeq_epi32(v, _mm256_set1_epi32(int(id))));
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    constexpr uint32_t sVectorBytes = 16;
+
+    template <typename Id>
+    inline bool has_id(const Id* ids, Id id) noexcept {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ids));
+        if (1 == sizeof(Id))
+            return 0 != _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(char(id))));
+        if (2 == sizeof(Id))
+            return 0 != _mm_movemask_epi8(_mm_cmpeq_epi16(v, _mm_set1_epi16(short(id))));
+        return 0 != _mm_movemask_epi8(_mm_cmpeq_epi32(v, _mm_set1_epi32(int(id))));
+    }
+#elif defined(__ARM_NEON)
+    constexpr uint32_t sVectorBytes = 16;
+
+    template <typename Id>
+    inline bool has_id(const Id* ids, Id id) noexcept {
+        const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(ids));
+        uint64x2_t eq;
+        if (1 == sizeof(Id))
+            eq = vreinterpretq_u64_u8(vceqq_u8(v, vdupq_n_u8(uint8_t(id))));
+        else if (2 == sizeof(Id))
+            eq = vreinterpretq_u64_u16(vceqq_u16(vreinterpretq_u16_u8(v), vdupq_n_u16(uint16_t(id))));
+        else
+            eq = vreinterpretq_u64_u32(vceqq_u32(vreinterpretq_u32_u8(v), vdupq_n_u32(uint32_t(id))));
+        return 0 != (vgetq_lane_u64(eq, 0) | vgetq_lane_u64(eq, 1));
+    }
+#endif
+
+
+    // finds the id in the array; a vector of ids is compared at once, then
+    // the one, which is equal, is found among them
+    template <typename Id>
+    inline uint32_t find_id(const Id* ids, uint32_t nbids, Id id) noexcept {
+        uint32_t i = 0;
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64) || defined(__ARM_NEON)
+        constexpr uint32_t sNbLanes = sVectorBytes / sizeof(Id);
+        for (; i + sNbLanes <= nbids; i += sNbLanes) {
+            if (has_id(ids + i, id))
+                break;
+        }
+#endif
+
+        for (; i < nbids; ++i) {
+            if (ids[i] == id)
+                return i;
+        }
+
+        return nbids;
+    }
+
+
+    // takes edges, whose masks intersect the mask, in their order; a vector
+    // of masks is tested at once, so runs of edges, which don't match, are
+    // skipped quickly
+    template <typename Id, typename Count>
+    inline Count select_edges(const Id* edges, const uint64_t* masks, Count nbedges,
+                              uint64_t mask, Id* buffer, Count szbuffer) noexcept
+    {
+        uint32_t nbfound = 0;
+        auto take = [&](uint32_t e) {
+            if (nbfound < szbuffer)
+                buffer[nbfound] = edges[e];
+            ++nbfound;
+        };
+
+        uint32_t e = 0;
+
+#if defined(__AVX2__)
+        const __m256i vmask = _mm256_set1_epi64x(int64_t(mask));
+        const __m256i zero = _mm256_setzero_si256();
+        for (; e + 4 <= nbedges; e += 4) {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(masks + e));
+            const __m256i missed = _mm256_cmpeq_epi64(_mm256_and_si256(v, vmask), zero);
+            const int bits = _mm256_movemask_pd(_mm256_castsi256_pd(missed));
+            if (0xf == bits)
+                continue;
+
+            for (uint32_t k = 0; k < 4; ++k) {
+                if (0 == (bits & (1 << k)))
+                    take(e + k);
+            }
+        }
+#elif defined(__SSE2__) || defined(_M_X64)
+        // SSE2 compares 32 bit lanes, so a mask misses, if both its halves do
+        const __m128i vmask = _mm_set1_epi64x(int64_t(mask));
+        const __m128i zero = _mm_setzero_si128();
+        for (; e + 2 <= nbedges; e += 2) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(masks + e));
+            const __m128i missed = _mm_cmpeq_epi32(_mm_and_si128(v, vmask), zero);
+            const int bits = _mm_movemask_ps(_mm_castsi128_ps(missed));
+            if (0xf == bits)
+                continue;
+
+            if (0x3 != (bits & 0x3))
+                take(e);
+            if (0xc != (bits & 0xc))
+                take(e + 1);
+        }
+#elif defined(__ARM_NEON)
+        const uint64x2_t vmask = vdupq_n_u64(mask);
+        for (; e + 2 <= nbedges; e += 2) {
+            const uint64x2_t hit = vtstq_u64(vld1q_u64(masks + e), vmask);
+            if (0 != vgetq_lane_u64(hit, 0))
+                take(e);
+            if (0 != vgetq_lane_u64(hit, 1))
+                take(e + 1);
+        }
+#endif
+
+        for (; e < nbedges; ++e) {
+            if (0 != (masks[e] & mask))
+                take(e);
+        }
+
+        return Count(nbfound);
+    }
+
+
+    // the growth policy of all arrays of the graph: a full array grows by a
+    // half at least, so appends take amortized O(1), while a bigger request
+    // is taken exactly; explicit hints of nodes skip it (see reserve)
+    inline uint32_t grown(uint32_t capacity, uint32_t needed, uint32_t minimum, uint32_t limit) noexcept {
+        if (needed <= capacity)
+            return capacity;
+
+        const uint32_t geometric = std::max(capacity + capacity / 2, minimum);
+        return std::min(std::max(needed, geometric), limit);
+    }
+
+
+    // grows or shrinks the array; new elements are zeroed
     template <typename T, typename SzT>
-    inline SzT resize(T** pArr, SzT curSize, SzT newSize) noexcept {
-        T* resized = new T[newSize];
+    inline SzT resize(Allocator& allocator, T** pArr, SzT curSize, SzT newSize) noexcept {
+        T* resized = allocate<T>(allocator, newSize);
 
-        std::memcpy(resized, *pArr, sizeof(T) * curSize);
-        std::memset(resized, 0, sizeof(T) * (newSize - curSize));
+        const SzT nbkept = std::min(curSize, newSize);
+        if (nbkept > 0)
+            std::memcpy(resized, *pArr, sizeof(T) * nbkept);
+        if (newSize > nbkept)
+            std::memset(resized + nbkept, 0, sizeof(T) * (newSize - nbkept));
 
-        std::swap(resized, *pArr);
-        delete[] resized;
+        deallocate(allocator, *pArr, curSize);
+        *pArr = resized;
 
         return newSize;
     }
@@ -37,47 +318,187 @@ namespace {
 }
 
 
+// routes of one tag in addRoutesParallel(), which are batch[first], ...,
+// batch[last - 1] of the partitioned table; validation leaves new orders of
+// the tag for nodes, which it moved or placed, so old and accepted routes
+// go forward in the order; nbLow and nbHigh orders below and above the
+// bounds are taken by nodes, which had no routes of the tag
+template <class Traits>
+struct BasicGraph<Traits>::TagBatch {
+    tagid_t tagId;
+    uint32_t first, last;
+    uint32_t nbLow, nbHigh;
+    std::vector<nodeid_t> nodes;
+    std::vector<uint32_t> orders;
+};
+
+
+// buffers of a validating thread; nodes of the validated tag get local ids
+// and routes between them are kept as edges of local nodes
+template <class Traits>
+struct BasicGraph<Traits>::Workspace {
+    static constexpr uint32_t sNone = std::numeric_limits<uint32_t>::max();
+
+    std::vector<uint32_t> local; // a local id of each node id or sNone
+    std::vector<nodeid_t> nodes; // a node id of each local id
+    // an order of each local id before the batch, and sides of the window,
+    // which it's found on (see validate)
+    std::vector<uint32_t> keys;
+    std::vector<uint8_t> sides;
+    // edges of local node v are targets[offsets[v]], ..., targets[offsets[v + 1] - 1];
+    // an edge of an old route is always active
+    std::vector<uint32_t> offsets, targets, sources;
+    std::vector<uint8_t> active;
+    // edges into local node v are edges[reverse[v]], ..., edges[reverse[v + 1] - 1]
+    std::vector<uint32_t> reverse, inward;
+    // per route of the tag: its edge and a route, which it duplicates
+    std::vector<uint32_t> edges, duplicates;
+    std::vector<uint32_t> seen, indices, lowlinks, components, cursors, positions;
+    std::vector<uint32_t> stack, frames, queue, taken;
+    std::vector<uint32_t> forward, backward, orders;
+};
+
+
+// threads of addRoutesParallel(), which are kept between calls; the calling
+// thread is worker 0 and threads[i] is worker i + 1; a job wakes all threads,
+// and the ones, which it doesn't need, go back to sleep
+template <class Traits>
+struct BasicGraph<Traits>::Workers {
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    // the current job and its number, so a thread runs each job once
+    void (*job)(void* context, uint32_t worker) = nullptr;
+    void* context = nullptr;
+    uint64_t round = 0;
+    uint32_t nbJoined = 0, nbBusy = 0;
+    bool stop = false;
+
+    ~Workers() noexcept {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        wake.notify_all();
+        for (std::thread& thread : threads)
+            thread.join();
+    }
+
+    void loop(uint32_t worker) noexcept {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            wake.wait(lock, [this, &seen] { return stop || round != seen; });
+            if (stop)
+                return;
+
+            seen = round;
+            if (worker > nbJoined)
+                continue;
+
+            lock.unlock();
+            job(context, worker);
+            lock.lock();
+            if (0 == --nbBusy)
+                done.notify_one();
+        }
+    }
+
+    // runs work(worker, item) for all items on nbWorkers threads; each thread
+    // takes the next item, when it's done
+    template <typename Work>
+    void run(uint32_t nbWorkers, uint32_t nbItems, Work work) noexcept {
+        std::atomic<uint32_t> next(0);
+        auto each = [&next, nbItems, &work](uint32_t worker) {
+            for (uint32_t i = next++; i < nbItems; i = next++)
+                work(worker, i);
+        };
+
+        const uint32_t nbThreads = std::max(std::min(nbWorkers, nbItems), 1u) - 1;
+        if (0 == nbThreads) {
+            each(0);
+            return;
+        }
+
+        while (threads.size() < nbThreads)
+            fontomas__safe_call(threads.emplace_back(&Workers::loop, this, uint32_t(threads.size() + 1)));
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = [](void* context, uint32_t worker) { (*static_cast<decltype(each)*>(context))(worker); };
+            context = &each;
+            nbJoined = nbBusy = nbThreads;
+            ++round;
+        }
+        wake.notify_all();
+
+        each(0);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return 0 == nbBusy; });
+    }
+};
+
+
 // GRAPH PUBLICS
 
 
-Graph::Graph() noexcept
-    : _nodes(nullptr)
-    , _szNodes(0), _maxNodeId(std::numeric_limits<nodeid_t>::min())
+template <class Traits>
+BasicGraph<Traits>::BasicGraph() noexcept
+    : BasicGraph(Allocator::heap())
+{}
+
+
+template <class Traits>
+BasicGraph<Traits>::BasicGraph(Allocator& allocator) noexcept
+    : _allocator(allocator)
+    , _nodes(nullptr)
+    , _szNodes(0), _nbNodes(0), _maxNodeId(std::numeric_limits<nodeid_t>::min())
+    , _compacted(0)
+    , _generation(0)
+    , _lowOrder(sMiddleOrder), _highOrder(sMiddleOrder)
 {}
 
 
-Graph::~Graph() noexcept {
+template <class Traits>
+BasicGraph<Traits>::~BasicGraph() noexcept {
     if (!_nodes)
         return;
 
-    for (nodeid_t i = 0; i <= _maxNodeId; ++i)
+    for (uint32_t i = 0; i <= _maxNodeId; ++i)
         release(_nodes[i]);
-    delete[] _nodes;
+    deallocate(_allocator, _nodes, _szNodes);
 }
 
 
-Graph::Result Graph::addNode(nodeid_t nodeId, tagid_t tagId) noexcept {
+template <class Traits>
+auto BasicGraph<Traits>::addNode(nodeid_t nodeId, tagid_t tagId) noexcept -> Result {
+    if (sNoTag == tagId || uint64_t(nodeId) >= sMaxIds<nodeid_t>)
+        return eNotAllowed;
+
     if (nodeId < _szNodes && nodeId <= _maxNodeId && exists(_nodes[nodeId]))
         return eExists;
 
     allocNodes(nodeId);
+    reserve_orders(0, 1);
 
     NodeInfo& info = _nodes[nodeId];
-    info.routes = new TagRoutes[sTagsReserved];
-    std::memset(info.routes, 0, sTagsReserved * sizeof(TagRoutes));
-    info.nbtags = 0;
-    info.sztags = sTagsReserved;
+    relayout(info, eSorted, 1, 0);
 
     attach(info, tagId);
+    lookup(info, tagId)->order = ++_highOrder;
 
     _maxNodeId = std::max(_maxNodeId, nodeId);
+    ++_nbNodes;
+    _generation.fetch_add(1, std::memory_order_release);
 
     return eOk;
 }
 
 
-Graph::Result Graph::addRoute(nodeid_t nodeId, nodeid_t fallbackId, tagid_t tagId) noexcept {
-    if (nodeId > _maxNodeId || !exists(_nodes[nodeId]))
+template <class Traits>
+auto BasicGraph<Traits>::addRoute(nodeid_t nodeId, nodeid_t fallbackId, tagid_t tagId) noexcept -> Result {
+    if (!_nodes || nodeId > _maxNodeId || !exists(_nodes[nodeId]))
         return eNotExists;
 
     if (fallbackId > _maxNodeId || !exists(_nodes[fallbackId]))
@@ -89,194 +510,2087 @@ Graph::Result Graph::addRoute(nodeid_t nodeId, nodeid_t fallbackId, tagid_t tagI
     if (has_route(info, fallbackId, tagId))
         return eExists;
 
-    if (is_looped(nodeId, info, fallbackId, tagId))
+    if (nodeId == fallbackId || sNoTag == tagId)
         return eNotAllowed;
 
-    attach(info, tagId);
-    attach(fallback, tagId);
+    reserve_orders(1, 1);
+
+    // a newly attached source has no parents and a newly attached fallback
+    // has no routes, so they can't make a loop; they are placed at the ends
+    // of the order and never need reordering
+    if (attached(info, tagId) && attached(fallback, tagId)) {
+        if (!reorder(nodeId, fallbackId, tagId))
+            return eNotAllowed;
+    }
+
+    if (attach(info, tagId))
+        lookup(info, tagId)->order = --_lowOrder;
+    if (attach(fallback, tagId))
+        lookup(fallback, tagId)->order = ++_highOrder;
 
     connect(info, fallbackId, tagId);
+    link(fallback, nodeId, tagId);
+
+    invalidate(nodeId, tagId);
+    _generation.fetch_add(1, std::memory_order_release);
 
     return eOk;
 }
 
 
-uint16_t Graph::fallbacks(nodeid_t nodeId, tagid_t tagId,
-                          nodeid_t* buffer, uint16_t szbuffer) const noexcept
+template <class Traits>
+auto BasicGraph<Traits>::addRoutes(span_t<const Route> routes, Result* results) noexcept -> Result {
+    return addRoutesParallel(routes, 1, results);
+}
+
+
+template <class Traits>
+auto BasicGraph<Traits>::addRoutesParallel(span_t<const Route> routes, uint32_t nbThreads,
+                                           Result* results) noexcept -> Result
 {
-    if (nodeId > _maxNodeId || !exists(_nodes[nodeId]))
-        return 0;
+    if (!results) {
+        fontomas__safe_call(_scratch.results.resize(routes.size()));
+        results = _scratch.results.data();
+    }
 
-    const NodeInfo& info = _nodes[nodeId];
+    partition(routes, results);
+    const std::vector<uint32_t>& batch = _scratch.batch;
 
-    if (detached(info, tagId))
-        return 0;
+    std::vector<TagBatch> tags;
+    for (uint32_t i = 0; i < batch.size();) {
+        uint32_t j = i;
+        while (j < batch.size() && routes[batch[j]].tagId == routes[batch[i]].tagId)
+            ++j;
 
-    const TagRoutes& route = info.routes[tagId];
+        fontomas__safe_call(tags.push_back(TagBatch{ routes[batch[i]].tagId, i, j, 0, 0, {}, {} }));
+        i = j;
+    }
 
-    uint16_t nbcopied = std::min(route.nbfallbacks, szbuffer);
-    std::memcpy(buffer, route.fallbacks, sizeof(nodeid_t) * nbcopied);
+    // the biggest tags are taken first, so threads finish at about one time
+    std::vector<uint32_t> queue(tags.size());
+    std::iota(queue.begin(), queue.end(), 0u);
+    std::stable_sort(queue.begin(), queue.end(), [&tags](uint32_t a, uint32_t b) {
+        return tags[a].last - tags[a].first > tags[b].last - tags[b].first;
+    });
+
+    const uint32_t nbWorkers = std::max(nbThreads, 1u);
+    if (!_scratch.workers)
+        fontomas__safe_call(_scratch.workers.reset(new Workers()));
+
+    // tags are validated only by reading the graph, so threads don't share
+    // any writable state but results of their own routes; a route takes at
+    // most one order below the bounds and one above them
+    std::vector<Workspace>& workspaces = _scratch.workspaces;
+    if (workspaces.size() < nbWorkers)
+        fontomas__safe_call(workspaces.resize(nbWorkers));
+    reserve_orders(uint32_t(batch.size()), uint32_t(batch.size()));
+
+    _scratch.workers->run(nbWorkers, uint32_t(queue.size()), [&](uint32_t worker, uint32_t i) {
+        validate(routes, batch.data(), tags[queue[i]], workspaces[worker], results);
+    });
+
+    prepare();
+    apply(routes, span_t<const TagBatch>(tags.data(), tags.size()), results, nbWorkers);
+
+    if (!batch.empty())
+        _generation.fetch_add(1, std::memory_order_release);
+
+    for (uint32_t i = 0; i < routes.size(); ++i) {
+        if (eOk != results[i])
+            return results[i];
+    }
 
-    return nbcopied;
+    return eOk;
 }
 
 
-// GRAPH PRIVATES
+template <class Traits>
+auto BasicGraph<Traits>::removeRoute(nodeid_t nodeId, nodeid_t fallbackId, tagid_t tagId) noexcept -> Result {
+    if (!_nodes || nodeId > _maxNodeId || fallbackId > _maxNodeId)
+        return eNotExists;
+
+    NodeInfo& info = _nodes[nodeId];
+    if (!exists(info) || !has_route(info, fallbackId, tagId))
+        return eNotExists;
 
+    // chains of the node and its ancestors pass the fallback; the order stays
+    // valid, because no route is added
+    invalidate(nodeId, tagId);
 
-bool Graph::is_looped(nodeid_t nodeId, const NodeInfo& info, nodeid_t fallbackId, tagid_t tagId) const noexcept {
-    if (fallbackId >= _maxNodeId) {
-        fontomas__hardbreak;
-        return false;
-    }
+    disconnect(info, fallbackId, tagId);
+    unlink(_nodes[fallbackId], nodeId, tagId);
+    _generation.fetch_add(1, std::memory_order_release);
 
-    if (info.sztags <= tagId || !info.routes[tagId].fallbacks)
-        return false; // tag is not attached
+    return eOk;
+}
+
+
+template <class Traits>
+auto BasicGraph<Traits>::detachTag(nodeid_t nodeId, tagid_t tagId) noexcept -> Result {
+    if (!_nodes || nodeId > _maxNodeId || !exists(_nodes[nodeId]) || detached(_nodes[nodeId], tagId))
+        return eNotExists;
 
-    const TagRoutes& nodeRoute = info.routes[tagId];
+    NodeInfo& info = _nodes[nodeId];
+    if (1 == info.nbtags)
+        return eNotAllowed;
 
-    std::unique_ptr<Color[]> colors = std::make_unique<Color[]>(_maxNodeId);
-    std::memset(colors.get(), eWhite, _maxNodeId * sizeof(Color));
+    cut(nodeId, tagId);
 
-    std::unique_ptr<nodeid_t[]> buffer = std::make_unique<nodeid_t[]>(_maxNodeId);
-    std::memcpy(buffer.get(), nodeRoute.fallbacks, nodeRoute.nbfallbacks);
-    buffer[nodeRoute.nbfallbacks] = fallbackId;
+    const TagRoutes& route = *lookup(info, tagId);
+    for (count_t i = 0; i < route.nbfallbacks; ++i)
+        drop_edge(info, route.fallbacks[i], tagId);
 
-    TagRoutes route;
-    route.fallbacks = buffer.get();
-    route.nbfallbacks = nodeRoute.nbfallbacks + 1;
-    route.szfallbacks = _maxNodeId;
+    detach(info, tagId);
+    erase(info, tagId);
+    _generation.fetch_add(1, std::memory_order_release);
 
-    return has_backedge(nodeId, tagId, colors.get(), route);
+    return eOk;
 }
 
 
-bool Graph::has_backedge(nodeid_t nodeId, tagid_t tagId,
-                         Color* colors, const TagRoutes& route) const noexcept
-{
-    colors[nodeId] = eGray;
+template <class Traits>
+auto BasicGraph<Traits>::removeNode(nodeid_t nodeId) noexcept -> Result {
+    if (!_nodes || nodeId > _maxNodeId || !exists(_nodes[nodeId]))
+        return eNotExists;
 
-    for (uint16_t i = 0; i < route.nbfallbacks; ++i) {
-        nodeid_t fallbackId = route.fallbacks[i];
-        if (eGray == colors[fallbackId])
-            return true;
+    NodeInfo& info = _nodes[nodeId];
+    for (count_t slot = 0; slot < info.sztags; ++slot) {
+        const tagid_t tagId = slot_tag(info, slot);
+        if (sNoTag != tagId && info.routes[slot].fallbacks)
+            cut(nodeId, tagId);
+    }
 
-        if (fallbackId > _szNodes || !exists(_nodes[fallbackId])) {
-            // Graph is inconsistent!
-            fontomas__hardbreak;
-            return true; // return true to quickly stop the algorithm
-        }
-        const NodeInfo& fallbackInfo = _nodes[fallbackId];
-        if (detached(fallbackInfo, tagId))
-            continue; // tag is not attached
+    release(info);
+    info = NodeInfo();
+    --_nbNodes;
+    _generation.fetch_add(1, std::memory_order_release);
 
-        if (eWhite == colors[fallbackId] && has_backedge(fallbackId, tagId, colors, fallbackInfo.routes[tagId]))
-            return true;
+    while (_maxNodeId > 0 && !exists(_nodes[_maxNodeId]))
+        --_maxNodeId;
+
+    if (nodeId < _maxNodeId)
+        fontomas__safe_call(_vacant.push_back(nodeId));
+
+    return eOk;
+}
+
+
+template <class Traits>
+auto BasicGraph<Traits>::vacantNode() noexcept -> nodeid_t {
+    // ids, which were taken again or are beyond the last node, are skipped
+    while (!_vacant.empty()) {
+        const nodeid_t nodeId = _vacant.back();
+        if (nodeId < _maxNodeId && !exists(_nodes[nodeId]))
+            return nodeId;
+
+        _vacant.pop_back();
     }
 
-    colors[nodeId] = eBlack;
-    return false;
+    if (0 == _nbNodes)
+        return 0;
+
+    // sNotConnected isn't an id of a node, so it's free only as the result
+    if (uint64_t(_maxNodeId) + 1 >= sNotConnected)
+        return sNotConnected;
+
+    return nodeid_t(_maxNodeId + 1);
 }
 
 
-/*static*/
-bool Graph::has_route(const NodeInfo& info, nodeid_t fallbackId, tagid_t tagId) noexcept {
-    if (detached(info, tagId))
-        return false; // tag is not attached
+template <class Traits>
+bool BasicGraph<Traits>::compactStep(uint32_t nbNodes) noexcept {
+    if (!_nodes)
+        return true;
 
-    const TagRoutes& tag = info.routes[tagId];
+    const uint32_t end = std::min(_compacted + nbNodes, uint32_t(_maxNodeId) + 1);
+    for (; _compacted < end; ++_compacted) {
+        if (exists(_nodes[_compacted]))
+            shrink(_nodes[_compacted]);
+    }
 
-    for (uint16_t i = 0; i < tag.nbfallbacks; ++i) {
-        if (tag.fallbacks[i] == fallbackId)
-            return true;
+    if (_compacted <= _maxNodeId)
+        return false;
+
+    _compacted = 0;
+
+    if (0 == _nbNodes) {
+        deallocate(_allocator, _nodes, _szNodes);
+        _nodes = nullptr;
+        _szNodes = 0;
+        _maxNodeId = std::numeric_limits<nodeid_t>::min();
+        return true;
     }
 
-    return false;
+    const uint32_t szNodes = uint32_t(_maxNodeId) + 1;
+    if (_szNodes != szNodes)
+        _szNodes = resize<NodeInfo, uint32_t>(_allocator, &_nodes, _szNodes, szNodes);
+
+    return true;
 }
 
 
-// GRAPH INLINES
+template <class Traits>
+void BasicGraph<Traits>::reserve(uint32_t nbNodes) noexcept {
+    // a hint is taken exactly, however close it is to the capacity
+    if (nbNodes > _szNodes)
+        allocNodes(nodeid_t(std::min(nbNodes, sMaxIds<nodeid_t>) - 1), true);
+}
 
 
-/*inline*/
-void Graph::allocNodes(nodeid_t maxNodeId) noexcept {
-    if (!_nodes || maxNodeId >= _szNodes) {
-        _szNodes = resize<NodeInfo, nodeid_t>(&_nodes, _szNodes, maxNodeId + sNodesReserved);
+template <class Traits>
+auto BasicGraph<Traits>::reserve(nodeid_t nodeId, tagid_t tagId, count_t nbfallbacks) noexcept -> Result {
+    if (!_nodes || nodeId > _maxNodeId || !exists(_nodes[nodeId]))
+        return eNotExists;
+
+    if (sNoTag == tagId)
+        return eNotAllowed;
+
+    // a tag without routes is placed like one of a new node
+    NodeInfo& info = _nodes[nodeId];
+    reserve_orders(0, 1);
+    if (attach(info, tagId)) {
+        lookup(info, tagId)->order = ++_highOrder;
+        _generation.fetch_add(1, std::memory_order_release);
     }
+
+    TagRoutes& route = *lookup(info, tagId);
+    if (route.szfallbacks < nbfallbacks)
+        route.szfallbacks = resize<nodeid_t, count_t>(_allocator, &route.fallbacks, route.szfallbacks, nbfallbacks);
+    if (info.szedges < nbfallbacks)
+        reserve_edges(info, nbfallbacks - info.nbedges);
+
+    return eOk;
 }
 
 
-/*static inline*/
-bool Graph::exists(const NodeInfo& info) noexcept {
-    return info.routes != nullptr && info.nbtags > 0;
+template <class Traits>
+void BasicGraph<Traits>::shrink_to_fit() noexcept {
+    _scratch.release();
+
+    // one step over all nodes
+    _compacted = 0;
+    compactStep(sMaxIds<nodeid_t>);
 }
 
 
-/*static inline*/
-bool Graph::attached(const NodeInfo &info, tagid_t tagId) noexcept {
-    return tagId < info.sztags && !!info.routes[tagId].fallbacks;
+template <class Traits>
+auto BasicGraph<Traits>::fallbacks(nodeid_t nodeId, tagid_t tagId,
+                                   nodeid_t* buffer, count_t szbuffer) const noexcept -> count_t
+{
+    span_t<const nodeid_t> view = fallbacks(nodeId, tagId);
+
+    count_t nbcopied = static_cast<count_t>(std::min<std::size_t>(view.size(), szbuffer));
+    if (nbcopied > 0)
+        std::memcpy(buffer, view.data(), sizeof(nodeid_t) * nbcopied);
+
+    return nbcopied;
 }
 
 
-/*static inline*/
-bool Graph::detached(const NodeInfo &info, tagid_t tagId) noexcept {
-    return tagId >= info.sztags || !info.routes[tagId].fallbacks;
+template <class Traits>
+auto BasicGraph<Traits>::fallbacks(nodeid_t nodeId, tagid_t tagId) const noexcept -> span_t<const nodeid_t> {
+    if (!_nodes || nodeId > _maxNodeId || !exists(_nodes[nodeId]))
+        return span_t<const nodeid_t>();
+
+    const NodeInfo& info = _nodes[nodeId];
+
+    if (detached(info, tagId))
+        return span_t<const nodeid_t>();
+
+    const TagRoutes& route = *lookup(info, tagId);
+    return span_t<const nodeid_t>(route.fallbacks, route.nbfallbacks);
 }
 
 
-/*static inline*/
-void Graph::attach(NodeInfo& info, tagid_t tagId) noexcept {
-    if (attached(info, tagId))
-        return;
+template <class Traits>
+uint32_t BasicGraph<Traits>::fallbacks(span_t<const Query> queries, Found* found,
+                                       nodeid_t* arena, uint32_t szarena) const noexcept
+{
+    // a lookup goes node -> slots of tags -> fallbacks, each step depends on
+    // the previous one; so the node of a query is prefetched 3 * sAhead
+    // queries before it's copied, its slot 2 * sAhead and its fallbacks
+    // sAhead queries before, when its routes are looked up
+    static constexpr std::size_t sAhead = 8;
+
+    const std::size_t nbqueries = queries.size();
+    auto node = [this, queries](std::size_t i) -> const NodeInfo* {
+        const nodeid_t nodeId = queries[i].nodeId;
+        const NodeInfo* info = _nodes && nodeId <= _maxNodeId ? _nodes + nodeId : nullptr;
+        return info && exists(*info) ? info : nullptr;
+    };
+    auto route = [&node, queries](std::size_t i) -> const TagRoutes* {
+        const NodeInfo* info = node(i);
+        const TagRoutes* route = info ? lookup(*info, queries[i].tagId) : nullptr;
+        return route && route->fallbacks ? route : nullptr;
+    };
+
+    // routes of the next sAhead queries
+    const TagRoutes* ahead[sAhead];
+    for (std::size_t i = 0; i < sAhead && i < nbqueries; ++i)
+        ahead[i] = route(i);
+
+    uint32_t offset = 0;
+    for (std::size_t i = 0; i < nbqueries; ++i) {
+        const TagRoutes* current = ahead[i % sAhead];
+        const count_t nbfallbacks = current ? current->nbfallbacks : 0;
+
+        found[i].offset = offset;
+        found[i].count = nbfallbacks;
+        if (current && offset < szarena) {
+            const uint32_t nbcopied = std::min<uint32_t>(nbfallbacks, szarena - offset);
+            std::copy(current->fallbacks, current->fallbacks + nbcopied, arena + offset);
+        }
+        offset += nbfallbacks;
+
+        if (i + sAhead < nbqueries) {
+            ahead[i % sAhead] = route(i + sAhead);
+            if (ahead[i % sAhead])
+                fontomas__prefetch(ahead[i % sAhead]->fallbacks);
+        }
+
+        if (i + 2 * sAhead < nbqueries) {
+            if (const NodeInfo* info = node(i + 2 * sAhead))
+                prefetch(*info, queries[i + 2 * sAhead].tagId);
+        }
 
-    if (tagId >= info.sztags) {
-        info.sztags = resize<TagRoutes, uint16_t>(&info.routes, info.sztags, tagId + sTagsReserved);
+        if (i + 3 * sAhead < nbqueries) {
+            const nodeid_t nodeId = queries[i + 3 * sAhead].nodeId;
+            if (_nodes && nodeId <= _maxNodeId)
+                fontomas__prefetch(_nodes + nodeId);
+        }
     }
 
-    info.routes[tagId].fallbacks = new nodeid_t[sFallbacksReserved];
-    info.routes[tagId].nbfallbacks = 0;
-    info.routes[tagId].szfallbacks = sFallbacksReserved;
+    return offset;
+}
 
-    ++info.nbtags;
 
-    return;
+template <class Traits>
+auto BasicGraph<Traits>::fallbacksForTags(nodeid_t nodeId, span_t<const uint64_t> tagMask,
+                                          nodeid_t* buffer, count_t szbuffer) noexcept -> count_t
+{
+    if (!_nodes || nodeId > _maxNodeId || !exists(_nodes[nodeId]))
+        return 0;
+
+    const NodeInfo& info = _nodes[nodeId];
+
+    // all tags of the node fit the first word, where masks of edges are exact
+    if (!info.wide) {
+        const uint64_t mask = tagMask.empty() ? 0 : tagMask[0];
+        if (0 == (info.tagmask & mask))
+            return 0;
+
+        return select_edges(info.edges, info.edgemasks, info.nbedges, mask, buffer, szbuffer);
+    }
+
+    // otherwise fallbacks of the tags are marked and edges are taken, if they
+    // are marked
+    Traversal& marks = _scratch.marks;
+    marks.reset(_szNodes);
+
+    for (count_t slot = 0; slot < info.sztags; ++slot) {
+        const tagid_t tagId = slot_tag(info, slot);
+        if (sNoTag == tagId || tagId / sMaskBits >= tagMask.size())
+            continue;
+        if (0 == (tagMask[tagId / sMaskBits] & mask_bit(tagId)))
+            continue;
+
+        const TagRoutes& route = info.routes[slot];
+        for (count_t i = 0; i < route.nbfallbacks; ++i)
+            marks.paint(route.fallbacks[i], Traversal::eBlack);
+    }
+
+    uint32_t nbfound = 0;
+    for (count_t e = 0; e < info.nbedges; ++e) {
+        if (Traversal::eBlack != marks.color(info.edges[e]))
+            continue;
+
+        if (nbfound < szbuffer)
+            buffer[nbfound] = info.edges[e];
+        ++nbfound;
+    }
+
+    return count_t(nbfound);
 }
 
 
-/*static inline*/
-void Graph::detach(NodeInfo& info, tagid_t tagId) noexcept {
+template <class Traits>
+auto BasicGraph<Traits>::chain(nodeid_t nodeId, tagid_t tagId) noexcept -> span_t<const nodeid_t> {
+    if (!_nodes || nodeId > _maxNodeId || !exists(_nodes[nodeId]))
+        return span_t<const nodeid_t>();
+
+    const NodeInfo& info = _nodes[nodeId];
+
     if (detached(info, tagId))
-        return;
+        return span_t<const nodeid_t>();
 
-    delete[] info.routes[tagId].fallbacks;
-    info.routes[tagId].fallbacks = nullptr;
+    const TagRoutes& route = *lookup(info, tagId);
+    if (!route.resolved)
+        resolve(nodeId, tagId);
+
+    return span_t<const nodeid_t>(route.chain, route.nbchain);
 }
 
 
-/*static inline*/
-void Graph::connect(NodeInfo& info, nodeid_t fallbackId, tagid_t tagId) noexcept {
-    TagRoutes& route = info.routes[tagId];
-    if (route.szfallbacks <= route.nbfallbacks) {
-        route.szfallbacks = resize<nodeid_t, uint16_t>(&route.fallbacks, route.szfallbacks, fallbackId + sFallbacksReserved);
+template <class Traits>
+auto BasicGraph<Traits>::cheapest(nodeid_t nodeId, tagid_t tagId, Costs& costs,
+                                  nodeid_t* hops, count_t szhops, uint16_t szfrontier) noexcept -> Path
+{
+    Path path{ sNotConnected, 0, 0 };
+    if (!_nodes || nodeId > _maxNodeId || !exists(_nodes[nodeId]) || detached(_nodes[nodeId], tagId))
+        return path;
+
+    // a reached node is gray and has its cost and parent, an expanded one
+    // is black; the frontier is a min-heap of candidates by cost and seq
+    Traversal& marks = _scratch.marks;
+    std::vector<Candidate>& frontier = _scratch.frontier;
+    std::vector<uint32_t>& reached = _scratch.costs;
+    std::vector<nodeid_t>& parents = _scratch.parents;
+
+    // the frontier is reserved for its bound, so pushes don't allocate
+    const std::size_t szbound = std::max<uint16_t>(szfrontier, 1);
+    marks.reset(_szNodes);
+    frontier.clear();
+    fontomas__safe_call(frontier.reserve(szbound));
+    if (reached.size() < _szNodes) {
+        fontomas__safe_call(reached.resize(_szNodes));
+        fontomas__safe_call(parents.resize(_szNodes));
     }
 
-    route.fallbacks[route.nbfallbacks++] = fallbackId;
+    auto worse = [](const Candidate& a, const Candidate& b) -> bool {
+        return a.cost > b.cost || (a.cost == b.cost && a.seq > b.seq);
+    };
+
+    uint32_t seq = 0;
+    auto push = [&](nodeid_t id, uint32_t cost) {
+        const Candidate candidate{ cost, seq++, id };
+        if (frontier.size() < szbound) {
+            frontier.push_back(candidate);
+            std::push_heap(frontier.begin(), frontier.end(), worse);
+            return;
+        }
+
+        // the bound is reached: the most expensive candidate is replaced;
+        // it's a scan of the frontier, which is small by design (see the
+        // header), so it's cheaper than keeping a min-max heap
+        auto last = std::max_element(frontier.begin(), frontier.end(),
+            [&worse](const Candidate& a, const Candidate& b) { return worse(b, a); });
+        if (!worse(candidate, *last)) {
+            *last = candidate;
+            std::make_heap(frontier.begin(), frontier.end(), worse);
+        }
+    };
+
+    marks.paint(nodeId, Traversal::eGray);
+    reached[nodeId] = 0;
+    push(nodeId, 0);
+
+    while (!frontier.empty()) {
+        std::pop_heap(frontier.begin(), frontier.end(), worse);
+        const Candidate current = frontier.back();
+        frontier.pop_back();
+
+        // a node may be pushed again with a lower cost
+        if (Traversal::eBlack == marks.color(current.nodeId) || current.cost > reached[current.nodeId])
+            continue;
+        marks.paint(current.nodeId, Traversal::eBlack);
+
+        if (current.nodeId != nodeId && costs.serves(current.nodeId, tagId)) {
+            path.nodeId = current.nodeId;
+            path.cost = current.cost;
+            break;
+        }
+
+        for (nodeid_t fallbackId : fallbacks(current.nodeId, tagId)) {
+            const typename Traversal::Color color = marks.color(fallbackId);
+            if (Traversal::eBlack == color)
+                continue;
+
+            const uint64_t cost = uint64_t(current.cost) + costs.cost(current.nodeId, fallbackId, tagId);
+            const uint32_t capped = uint32_t(std::min<uint64_t>(cost, std::numeric_limits<uint32_t>::max()));
+            if (Traversal::eGray == color && reached[fallbackId] <= capped)
+                continue;
+
+            marks.paint(fallbackId, Traversal::eGray);
+            reached[fallbackId] = capped;
+            parents[fallbackId] = current.nodeId;
+            push(fallbackId, capped);
+        }
+    }
+
+    if (sNotConnected == path.nodeId)
+        return path;
+
+    for (nodeid_t id = path.nodeId; id != nodeId; id = parents[id])
+        ++path.nbhops;
+
+    count_t i = path.nbhops;
+    for (nodeid_t id = path.nodeId; id != nodeId; id = parents[id]) {
+        if (--i < szhops)
+            hops[i] = id;
+    }
+
+    return path;
 }
 
 
-/*static inline*/
-void Graph::release(Graph::NodeInfo& info) noexcept {
-    if (!info.routes)
-        return;
+template <class Traits>
+auto BasicGraph<Traits>::setCoverage(nodeid_t nodeId, Coverage&& coverage) noexcept -> Result {
+    if (!_nodes || nodeId > _maxNodeId || !exists(_nodes[nodeId]))
+        return eNotExists;
+
+    NodeInfo& info = _nodes[nodeId];
+    if (info.coverage)
+        *info.coverage = std::move(coverage);
+    else
+        info.coverage = new (allocate<Coverage>(_allocator, 1)) Coverage(std::move(coverage));
+    _generation.fetch_add(1, std::memory_order_release);
+
+    return eOk;
+}
+
+
+template <class Traits>
+const Coverage* BasicGraph<Traits>::coverage(nodeid_t nodeId) const noexcept {
+    if (!_nodes || nodeId > _maxNodeId || !exists(_nodes[nodeId]))
+        return nullptr;
+
+    return _nodes[nodeId].coverage;
+}
+
+
+template <class Traits>
+auto BasicGraph<Traits>::firstCovering(nodeid_t nodeId, tagid_t tagId, codepoint_t codepoint) noexcept -> nodeid_t {
+    nodeid_t foundId;
+    if (cachedCovering(nodeId, tagId, codepoint, foundId))
+        return foundId;
+
+    resolve(nodeId, tagId);
+    cachedCovering(nodeId, tagId, codepoint, foundId);
+
+    return foundId;
+}
+
 
-    for (uint16_t i = 0; i < info.sztags; ++i) {
-        if (info.routes[i].fallbacks)
-            delete[] info.routes[i].fallbacks;
+template <class Traits>
+bool BasicGraph<Traits>::cachedCovering(nodeid_t nodeId, tagid_t tagId, codepoint_t codepoint,
+                                        nodeid_t& foundId) const noexcept
+{
+    foundId = sNotConnected;
+    if (!_nodes || nodeId > _maxNodeId || !exists(_nodes[nodeId]))
+        return true;
+
+    auto covers = [this, codepoint](nodeid_t id) -> bool {
+        const Coverage* coverage = _nodes[id].coverage;
+        return coverage && coverage->covers(codepoint);
+    };
+
+    if (covers(nodeId)) {
+        foundId = nodeId;
+        return true;
+    }
+
+    const NodeInfo& info = _nodes[nodeId];
+    if (detached(info, tagId))
+        return true;
+
+    const TagRoutes& route = *lookup(info, tagId);
+    if (!route.resolved)
+        return false;
+
+    for (count_t i = 0; i < route.nbchain; ++i) {
+        if (covers(route.chain[i])) {
+            foundId = route.chain[i];
+            break;
+        }
+    }
+
+    return true;
+}
+
+
+template <class Traits>
+auto BasicGraph<Traits>::freeze() const noexcept -> FrozenGraph {
+    FrozenGraph frozen;
+    if (!_nodes)
+        return frozen;
+
+    // a node slice lists only tags, which have fallbacks, so a node with a
+    // few tags of large ids takes a few entries
+    auto hasFallbacks = [](const NodeInfo& info, count_t slot) -> bool {
+        return sNoTag != slot_tag(info, slot) && info.routes[slot].fallbacks &&
+               info.routes[slot].nbfallbacks > 0;
+    };
+
+    const std::size_t nbNodes = std::size_t(_maxNodeId) + 1;
+
+    std::size_t nbTags = 0, nbFallbacks = 0;
+    for (std::size_t i = 0; i < nbNodes; ++i) {
+        const NodeInfo& info = _nodes[i];
+        for (count_t t = 0; info.routes && t < info.sztags; ++t) {
+            if (hasFallbacks(info, t)) {
+                ++nbTags;
+                nbFallbacks += info.routes[t].nbfallbacks;
+            }
+        }
     }
 
-    delete[] info.routes;
+    // tables are indexed by 32 bit offsets, and the last offset ends them
+    constexpr std::size_t sMaxEntries = std::numeric_limits<uint32_t>::max();
+    if (nbNodes >= sMaxEntries || nbTags >= sMaxEntries || nbFallbacks >= sMaxEntries)
+        return frozen;
+
+    frozen.allocate(uint32_t(nbNodes), uint32_t(nbTags), uint32_t(nbFallbacks));
+
+    std::vector<tagid_t> tags;
+    uint32_t slice = 0, offset = 0;
+    for (std::size_t i = 0; i < nbNodes; ++i) {
+        const NodeInfo& info = _nodes[i];
+
+        tags.clear();
+        for (count_t t = 0; info.routes && t < info.sztags; ++t) {
+            if (hasFallbacks(info, t)) {
+                fontomas__safe_call(tags.push_back(slot_tag(info, t)));
+            }
+        }
+        std::sort(tags.begin(), tags.end());
+
+        frozen._slices[i] = slice;
+        for (tagid_t tagId : tags) {
+            const TagRoutes* route = lookup(info, tagId);
+
+            frozen._tags[slice] = tagId;
+            frozen._offsets[slice++] = offset;
+            std::memcpy(frozen._fallbacks + offset, route->fallbacks, sizeof(nodeid_t) * route->nbfallbacks);
+            offset += route->nbfallbacks;
+        }
+    }
+    frozen._slices[nbNodes] = slice;
+    frozen._offsets[slice] = offset;
+
+    return frozen;
 }
 
 
+template <class Traits>
+MemoryStats BasicGraph<Traits>::memory() const noexcept {
+    MemoryStats stats;
+    if (!_nodes)
+        return stats;
+
+    stats.reserved += sizeof(NodeInfo) * _szNodes;
+    stats.used += _nbNodes > 0 ? sizeof(NodeInfo) * (std::size_t(_maxNodeId) + 1) : 0;
+
+    for (uint32_t i = 0; i <= _maxNodeId; ++i) {
+        const NodeInfo& info = _nodes[i];
+        if (!info.routes)
+            continue;
+
+        stats.reserved += (sizeof(TagRoutes) + (info.tags ? sizeof(tagid_t) : 0)) * info.sztags;
+        stats.used += (sizeof(TagRoutes) + (info.tags ? sizeof(tagid_t) : 0)) * info.nbtags;
+        stats.reserved += (sizeof(nodeid_t) + sizeof(uint64_t)) * info.szedges;
+        stats.used += (sizeof(nodeid_t) + sizeof(uint64_t)) * info.nbedges;
+
+        if (info.coverage) {
+            const MemoryStats coverage = info.coverage->memory();
+            stats.reserved += sizeof(Coverage) + coverage.reserved;
+            stats.used += sizeof(Coverage) + coverage.used;
+        }
+
+        for (count_t t = 0; t < info.sztags; ++t) {
+            const TagRoutes& route = info.routes[t];
+            if (!route.fallbacks)
+                continue;
+
+            stats.reserved += sizeof(nodeid_t) * (route.szfallbacks + route.szparents + route.nbchain);
+            stats.used += sizeof(nodeid_t) * (route.nbfallbacks + route.nbparents + route.nbchain);
+        }
+    }
+
+    return stats;
+}
+
+
+// GRAPH PRIVATES
+
+
+// Pearce-Kelly dynamic topological sort: a new route breaks the order only if
+// the fallback precedes the node; then only nodes between them are affected -
+// the ones reachable from the fallback and the ones the node is reachable from;
+// these two sets are reordered using the same positions they occupied before.
+template <class Traits>
+bool BasicGraph<Traits>::reorder(nodeid_t nodeId, nodeid_t fallbackId, tagid_t tagId) noexcept {
+    const uint32_t lower = tag_routes(fallbackId, tagId).order;
+    const uint32_t upper = tag_routes(nodeId, tagId).order;
+    if (upper < lower)
+        return true;
+
+    prepare();
+    _scratch.traversal.reset(_szNodes);
+
+    if (!search(fallbackId, nodeId, tagId, true, lower, upper, _scratch.forward))
+        return false; // the node is reachable from the fallback
+
+    search(nodeId, fallbackId, tagId, false, lower, upper, _scratch.backward);
+
+    shift(_scratch.backward, _scratch.forward, _scratch.orders,
+          [this, tagId](nodeid_t id) -> uint32_t& { return tag_routes(id, tagId).order; });
+
+    return true;
+}
+
+
+// gives all attached tags of all nodes consecutive orders around the middle,
+// which keep their relative order, so the bounds get room on both sides again
+template <class Traits>
+void BasicGraph<Traits>::renumber() noexcept {
+    struct Placed {
+        uint32_t order;
+        TagRoutes* route;
+    };
+
+    std::vector<Placed> placed;
+    for (uint32_t i = 0; _nodes && i <= _maxNodeId; ++i) {
+        NodeInfo& info = _nodes[i];
+        for (count_t slot = 0; info.routes && slot < info.sztags; ++slot) {
+            if (sNoTag != slot_tag(info, slot) && info.routes[slot].fallbacks)
+                fontomas__safe_call(placed.push_back(Placed{ info.routes[slot].order, info.routes + slot }));
+        }
+    }
+
+    std::sort(placed.begin(), placed.end(), [](const Placed& a, const Placed& b) { return a.order < b.order; });
+
+    const uint32_t base = sMiddleOrder - uint32_t(placed.size() / 2);
+    for (std::size_t k = 0; k < placed.size(); ++k)
+        placed[k].route->order = base + uint32_t(k);
+
+    _lowOrder = base;
+    _highOrder = placed.empty() ? sMiddleOrder : base + uint32_t(placed.size() - 1);
+}
+
+
+template <class Traits>
+bool BasicGraph<Traits>::search(nodeid_t startId, nodeid_t stopId, tagid_t tagId, bool forward,
+                                uint32_t lower, uint32_t upper, std::vector<nodeid_t>& visited) noexcept
+{
+    Traversal& traversal = _scratch.traversal;
+
+    // the order of visits doesn't matter here, so nodes are marked, when
+    // they are found, and visited in any order
+    visited.clear();
+    traversal.push(startId);
+
+    while (!traversal.empty()) {
+        const nodeid_t id = traversal.pop();
+        visited.push_back(id);
+
+        const TagRoutes& route = tag_routes(id, tagId);
+        const nodeid_t* next = forward ? route.fallbacks : route.parents;
+        const count_t nbnext = forward ? route.nbfallbacks : route.nbparents;
+
+        for (count_t i = 0; i < nbnext; ++i) {
+            const nodeid_t nextId = next[i];
+            if (nextId == stopId)
+                return false;
+
+            const uint32_t order = tag_routes(nextId, tagId).order;
+            if (Traversal::eWhite != traversal.color(nextId) || order < lower || order > upper)
+                continue;
+
+            traversal.push(nextId);
+        }
+    }
+
+    return true;
+}
+
+
+template <class Traits>
+void BasicGraph<Traits>::prepare() noexcept {
+    // a traversal visits each node once, so buffers can't grow later
+    if (_scratch.buffer.capacity() >= _szNodes)
+        return;
+
+    fontomas__safe_call(_scratch.buffer.reserve(_szNodes));
+    fontomas__safe_call(_scratch.stack.reserve(_szNodes));
+    fontomas__safe_call(_scratch.forward.reserve(_szNodes));
+    fontomas__safe_call(_scratch.backward.reserve(_szNodes));
+    fontomas__safe_call(_scratch.orders.reserve(_szNodes));
+}
+
+
+// checks routes, which can't be added whatever other routes are, and puts
+// indices of the others into the scratch batch: routes of one tag and one node
+// go together and keep the table order
+template <class Traits>
+void BasicGraph<Traits>::partition(span_t<const Route> routes, Result* results) noexcept {
+    std::vector<uint32_t>& batch = _scratch.batch;
+    batch.clear();
+    fontomas__safe_call(batch.reserve(routes.size()));
+
+    for (uint32_t i = 0; i < routes.size(); ++i) {
+        const Route& route = routes[i];
+        if (!_nodes || route.nodeId > _maxNodeId || !exists(_nodes[route.nodeId]) ||
+            route.fallbackId > _maxNodeId || !exists(_nodes[route.fallbackId]))
+        {
+            results[i] = eNotExists;
+        } else if (route.nodeId == route.fallbackId || sNoTag == route.tagId) {
+            results[i] = eNotAllowed;
+        } else {
+            results[i] = eOk;
+            batch.push_back(i);
+        }
+    }
+
+    // stable counting sorts by nodes and then by tags do it in linear time
+    std::vector<uint32_t>& buckets = _scratch.buckets;
+    std::vector<uint32_t>& sorted = _scratch.added;
+    counting_sort(batch, sorted, buckets, [&routes](uint32_t i) { return routes[i].nodeId; });
+    counting_sort(sorted, batch, buckets, [&routes](uint32_t i) { return routes[i].tagId; });
+}
+
+
+// decides, which routes of the tag are added: every loop, which new routes
+// close, lies in one strongly connected component, so new routes outside of
+// components are added at once, and the ones inside are added one by one in
+// the table order, thus only routes, which close loops, are rejected. Nodes
+// are kept in buffers of the workspace, so tags may be validated at once; the
+// graph is only read
+template <class Traits>
+void BasicGraph<Traits>::validate(span_t<const Route> routes, const uint32_t* batch, TagBatch& tag,
+                                  Workspace& ws, Result* results) const noexcept
+{
+    static constexpr uint32_t sNone = Workspace::sNone;
+    static constexpr uint8_t sForward = 1, sBackward = 2;
+
+    const tagid_t tagId = tag.tagId;
+    const uint32_t* first = batch + tag.first;
+    const uint32_t nbroutes = tag.last - tag.first;
+
+    if (ws.local.size() < _szNodes)
+        fontomas__safe_call(ws.local.resize(_szNodes, sNone));
+
+    std::vector<nodeid_t>& nodes = ws.nodes;
+    std::vector<uint32_t>& keys = ws.keys;
+    std::vector<uint8_t>& sides = ws.sides;
+    nodes.clear();
+    keys.clear();
+    sides.clear();
+
+    // a node, which has no routes of the tag, can take any order, so it's
+    // placed at an end like addRoute() does: before all others, if it's a
+    // source of a new route, otherwise after them; nodes at each end keep
+    // the order, in which they come, and the bounds are moved by apply()
+    auto placed = [this, tagId](nodeid_t id) -> bool {
+        if (!attached(_nodes[id], tagId))
+            return true;
+
+        const TagRoutes& route = tag_routes(id, tagId);
+        return 0 == route.nbfallbacks && 0 == route.nbparents;
+    };
+
+    tag.nbLow = tag.nbHigh = 0;
+    auto add = [&](nodeid_t id, bool source) {
+        if (sNone != ws.local[id])
+            return;
+
+        uint32_t key;
+        if (!placed(id))
+            key = tag_routes(id, tagId).order;
+        else
+            key = source ? tag.nbLow++ : _highOrder + ++tag.nbHigh;
+
+        ws.local[id] = uint32_t(nodes.size());
+        fontomas__safe_call(nodes.push_back(id));
+        fontomas__safe_call(keys.push_back(key));
+        fontomas__safe_call(sides.push_back(0));
+    };
+
+    for (uint32_t k = 0; k < nbroutes; ++k)
+        add(routes[first[k]].nodeId, true);
+    for (uint32_t v = 0; v < nodes.size(); ++v) {
+        if (placed(nodes[v]))
+            keys[v] += _lowOrder - tag.nbLow;
+    }
+    for (uint32_t k = 0; k < nbroutes; ++k)
+        add(routes[first[k]].fallbackId, false);
+
+    // a loop goes backwards in the order by some new route, so like reorder()
+    // only nodes in the window of such routes are affected: the ones, which
+    // are reachable from fallbacks of new routes, and the ones, which reach
+    // their sources; other nodes keep their orders
+    uint32_t lower = std::numeric_limits<uint32_t>::max(), upper = 0;
+    for (uint32_t k = 0; k < nbroutes; ++k) {
+        const uint32_t u = ws.local[routes[first[k]].nodeId];
+        const uint32_t f = ws.local[routes[first[k]].fallbackId];
+        if (keys[u] > keys[f]) {
+            lower = std::min(lower, keys[f]);
+            upper = std::max(upper, keys[u]);
+        }
+    }
+
+    std::vector<uint32_t>& stack = ws.stack;
+    auto reach = [&](uint32_t v, uint8_t side) {
+        if (keys[v] >= lower && keys[v] <= upper && 0 == (sides[v] & side)) {
+            sides[v] |= side;
+            fontomas__safe_call(stack.push_back(v));
+        }
+    };
+
+    for (uint8_t side : { sForward, sBackward }) {
+        stack.clear();
+        for (uint32_t k = 0; k < nbroutes; ++k) {
+            const Route& route = routes[first[k]];
+            reach(ws.local[sForward == side ? route.fallbackId : route.nodeId], side);
+        }
+
+        while (!stack.empty()) {
+            const uint32_t v = stack.back();
+            stack.pop_back();
+            if (!attached(_nodes[nodes[v]], tagId))
+                continue;
+
+            const TagRoutes& route = tag_routes(nodes[v], tagId);
+            const nodeid_t* next = sForward == side ? route.fallbacks : route.parents;
+            const count_t nbnext = sForward == side ? route.nbfallbacks : route.nbparents;
+            for (count_t i = 0; i < nbnext; ++i) {
+                const uint32_t order = tag_routes(next[i], tagId).order;
+                if (order < lower || order > upper)
+                    continue;
+
+                add(next[i], false);
+                reach(ws.local[next[i]], side);
+            }
+        }
+    }
+
+    // if no node has routes of the tag, there are no orders to keep, so all
+    // nodes go in the found order, like the whole closure of a load did
+    if (nodes.size() == tag.nbLow + tag.nbHigh)
+        std::fill(sides.begin(), sides.end(), uint8_t(sForward | sBackward));
+
+    const uint32_t nbnodes = uint32_t(nodes.size());
+    const std::vector<uint32_t>& local = ws.local;
+
+    // old routes and new ones, which are neither old nor duplicates of new
+    // ones, make edges; routes of a node are adjacent, so a fallback, which
+    // was seen since the first route of the node, is a duplicate
+    std::vector<uint32_t>& offsets = ws.offsets;
+    fontomas__safe_call(offsets.assign(nbnodes + 1, 0));
+    fontomas__safe_call(ws.seen.assign(nbnodes, sNone));
+    fontomas__safe_call(ws.duplicates.assign(nbroutes, sNone));
+    fontomas__safe_call(ws.edges.assign(nbroutes, sNone));
+
+    // old routes, which leave the nodes, can't be on a loop
+    for (uint32_t v = 0; v < nbnodes; ++v) {
+        if (!attached(_nodes[nodes[v]], tagId))
+            continue;
+
+        const TagRoutes& route = tag_routes(nodes[v], tagId);
+        for (count_t i = 0; i < route.nbfallbacks; ++i)
+            offsets[v + 1] += sNone != local[route.fallbacks[i]] ? 1 : 0;
+    }
+
+    for (uint32_t k = 0, start = 0; k < nbroutes; ++k) {
+        const Route& route = routes[first[k]];
+        if (k > 0 && routes[first[k - 1]].nodeId != route.nodeId)
+            start = k;
+
+        const uint32_t f = local[route.fallbackId];
+        if (has_route(_nodes[route.nodeId], route.fallbackId, tagId)) {
+            results[first[k]] = eExists;
+        } else if (sNone != ws.seen[f] && ws.seen[f] >= start) {
+            results[first[k]] = eExists;
+            ws.duplicates[k] = ws.seen[f];
+        } else {
+            ws.seen[f] = k;
+            ++offsets[local[route.nodeId] + 1];
+        }
+    }
+
+    for (uint32_t v = 0; v < nbnodes; ++v)
+        offsets[v + 1] += offsets[v];
+
+    const uint32_t nbedges = offsets[nbnodes];
+    std::vector<uint32_t>& targets = ws.targets;
+    std::vector<uint32_t>& sources = ws.sources;
+    std::vector<uint8_t>& active = ws.active;
+    std::vector<uint32_t>& cursors = ws.cursors;
+    fontomas__safe_call(targets.resize(nbedges));
+    fontomas__safe_call(sources.resize(nbedges));
+    fontomas__safe_call(active.assign(nbedges, 1));
+    fontomas__safe_call(cursors.assign(offsets.begin(), offsets.end() - 1));
+
+    for (uint32_t v = 0; v < nbnodes; ++v) {
+        if (!attached(_nodes[nodes[v]], tagId))
+            continue;
+
+        const TagRoutes& route = tag_routes(nodes[v], tagId);
+        for (count_t i = 0; i < route.nbfallbacks; ++i) {
+            if (sNone != local[route.fallbacks[i]])
+                targets[cursors[v]++] = local[route.fallbacks[i]];
+        }
+    }
+
+    for (uint32_t k = 0; k < nbroutes; ++k) {
+        const Route& route = routes[first[k]];
+        if (eOk != results[first[k]])
+            continue;
+
+        const uint32_t u = local[route.nodeId];
+        ws.edges[k] = cursors[u];
+        targets[cursors[u]++] = local[route.fallbackId];
+    }
+
+    for (uint32_t v = 0; v < nbnodes; ++v) {
+        for (uint32_t e = offsets[v]; e < offsets[v + 1]; ++e)
+            sources[e] = v;
+    }
+
+    // Tarjan's strongly connected components
+    std::vector<uint32_t>& indices = ws.indices;
+    std::vector<uint32_t>& lowlinks = ws.lowlinks;
+    std::vector<uint32_t>& components = ws.components;
+    std::vector<uint32_t>& frames = ws.frames;
+    fontomas__safe_call(indices.assign(nbnodes, 0));
+    fontomas__safe_call(lowlinks.assign(nbnodes, 0));
+    fontomas__safe_call(components.assign(nbnodes, sNone));
+    fontomas__safe_call(cursors.assign(offsets.begin(), offsets.end() - 1));
+    fontomas__safe_call(stack.reserve(nbnodes));
+    fontomas__safe_call(frames.reserve(nbnodes));
+    stack.clear();
+    frames.clear();
+
+    uint32_t index = 0, nbcomponents = 0;
+    auto enter = [&](uint32_t v) {
+        indices[v] = lowlinks[v] = ++index;
+        stack.push_back(v);
+        frames.push_back(v);
+    };
+
+    for (uint32_t root = 0; root < nbnodes; ++root) {
+        if (0 != indices[root])
+            continue;
+
+        enter(root);
+        while (!frames.empty()) {
+            const uint32_t v = frames.back();
+            if (cursors[v] < offsets[v + 1]) {
+                const uint32_t e = cursors[v]++;
+                const uint32_t w = targets[e];
+                if (0 == indices[w])
+                    enter(w);
+                else if (sNone == components[w])
+                    lowlinks[v] = std::min(lowlinks[v], indices[w]);
+                continue;
+            }
+
+            frames.pop_back();
+            if (!frames.empty())
+                lowlinks[frames.back()] = std::min(lowlinks[frames.back()], lowlinks[v]);
+
+            if (lowlinks[v] != indices[v])
+                continue;
+
+            uint32_t member;
+            do {
+                member = stack.back();
+                stack.pop_back();
+                components[member] = nbcomponents;
+            } while (member != v);
+            ++nbcomponents;
+        }
+    }
+
+    // new routes inside components are taken out, so the rest is acyclic
+    std::vector<uint32_t>& taken = ws.taken;
+    taken.clear();
+    for (uint32_t k = 0; k < nbroutes; ++k) {
+        const Route& route = routes[first[k]];
+        if (sNone != ws.edges[k] && components[local[route.nodeId]] == components[local[route.fallbackId]]) {
+            active[ws.edges[k]] = 0;
+            fontomas__safe_call(taken.push_back(k));
+        }
+    }
+
+    // Kahn's topological order of active edges gives positions of nodes
+    std::vector<uint32_t>& positions = ws.positions;
+    std::vector<uint32_t>& queue = ws.queue;
+    fontomas__safe_call(lowlinks.assign(nbnodes, 0)); // in-degrees
+    fontomas__safe_call(positions.resize(nbnodes));
+    fontomas__safe_call(queue.reserve(nbnodes));
+    for (uint32_t e = 0; e < nbedges; ++e)
+        lowlinks[targets[e]] += active[e];
+
+    queue.clear();
+    for (uint32_t v = 0; v < nbnodes; ++v) {
+        if (0 == lowlinks[v])
+            queue.push_back(v);
+    }
+    for (uint32_t i = 0; i < queue.size(); ++i) {
+        const uint32_t v = queue[i];
+        positions[v] = i;
+        for (uint32_t e = offsets[v]; e < offsets[v + 1]; ++e) {
+            if (active[e] && 0 == --lowlinks[targets[e]])
+                queue.push_back(targets[e]);
+        }
+    }
+
+    if (!taken.empty()) {
+        // edges into each node, so ancestors are searched too
+        std::vector<uint32_t>& reverse = ws.reverse;
+        std::vector<uint32_t>& inward = ws.inward;
+        fontomas__safe_call(reverse.assign(nbnodes + 1, 0));
+        fontomas__safe_call(inward.resize(nbedges));
+        for (uint32_t e = 0; e < nbedges; ++e)
+            ++reverse[targets[e] + 1];
+        for (uint32_t v = 0; v < nbnodes; ++v)
+            reverse[v + 1] += reverse[v];
+        fontomas__safe_call(cursors.assign(reverse.begin(), reverse.end() - 1));
+        for (uint32_t e = 0; e < nbedges; ++e)
+            inward[cursors[targets[e]]++] = e;
+
+        fontomas__safe_call(ws.forward.reserve(nbnodes));
+        fontomas__safe_call(ws.backward.reserve(nbnodes));
+        fontomas__safe_call(ws.orders.reserve(nbnodes));
+    }
+
+    // like search() does for reorder(): visits nodes, which are reachable
+    // from the start by active edges and lie in [lower, upper] of positions;
+    // false if the stop is reached
+    auto search = [&](uint32_t start, uint32_t stop, bool forward, uint32_t lower, uint32_t upper,
+                      std::vector<uint32_t>& visited) -> bool
+    {
+        ++index; // marks nodes of this search in indices
+        indices[start] = index;
+        visited.clear();
+        stack.clear();
+        stack.push_back(start);
+
+        while (!stack.empty()) {
+            const uint32_t v = stack.back();
+            stack.pop_back();
+            visited.push_back(v);
+
+            const uint32_t begin = forward ? offsets[v] : ws.reverse[v];
+            const uint32_t end = forward ? offsets[v + 1] : ws.reverse[v + 1];
+            for (uint32_t i = begin; i < end; ++i) {
+                const uint32_t e = forward ? i : ws.inward[i];
+                const uint32_t w = forward ? targets[e] : sources[e];
+                if (!active[e])
+                    continue;
+                if (w == stop)
+                    return false;
+                if (index == indices[w] || positions[w] < lower || positions[w] > upper)
+                    continue;
+
+                indices[w] = index;
+                stack.push_back(w);
+            }
+        }
+
+        return true;
+    };
+
+    // taken out routes are added one by one in the table order; a route,
+    // which goes forward in the order, can't close a loop and keeps it,
+    // otherwise nodes between its ends are reordered like reorder() does
+    std::sort(taken.begin(), taken.end(), [first](uint32_t a, uint32_t b) { return first[a] < first[b]; });
+    for (uint32_t k : taken) {
+        const uint32_t u = local[routes[first[k]].nodeId];
+        const uint32_t f = local[routes[first[k]].fallbackId];
+        const uint32_t lower = positions[f], upper = positions[u];
+        if (upper > lower) {
+            if (!search(f, u, true, lower, upper, ws.forward)) {
+                results[first[k]] = eNotAllowed;
+                continue;
+            }
+
+            search(u, f, false, lower, upper, ws.backward);
+            shift(ws.backward, ws.forward, ws.orders, [&positions](uint32_t v) -> uint32_t& { return positions[v]; });
+        }
+        active[ws.edges[k]] = 1;
+    }
+
+    // a duplicate of a rejected route is rejected as well
+    for (uint32_t k = 0; k < nbroutes; ++k) {
+        if (sNone != ws.duplicates[k] && eOk != results[first[ws.duplicates[k]]])
+            results[first[k]] = eNotAllowed;
+    }
+
+    // nodes of the window take the orders, which they had, so routes, which
+    // enter or leave the window, still go forward: ones, which only reach
+    // sources, go first and ones, which are only reached from fallbacks, go
+    // last, each in the old order, so they only move outwards; ones on both
+    // sides go between in the found order. Nodes, which are placed at the
+    // ends, keep their orders too
+    std::vector<uint32_t>& window = ws.forward;
+    std::vector<uint32_t>& orders = ws.orders;
+    window.clear();
+    orders.clear();
+    tag.nodes.clear();
+    tag.orders.clear();
+
+    for (uint32_t v = 0; v < nbnodes; ++v) {
+        if (0 != sides[v]) {
+            fontomas__safe_call(orders.push_back(keys[v]));
+        } else if (placed(nodes[v])) {
+            fontomas__safe_call(tag.nodes.push_back(nodes[v]));
+            fontomas__safe_call(tag.orders.push_back(keys[v]));
+        }
+    }
+    std::sort(orders.begin(), orders.end());
+
+    // positions are a permutation of local ids, so nodes on both sides are
+    // taken in the found order from its inverse
+    std::vector<uint32_t>& byPosition = ws.cursors;
+    fontomas__safe_call(byPosition.resize(nbnodes));
+    for (uint32_t v = 0; v < nbnodes; ++v)
+        byPosition[positions[v]] = v;
+
+    auto byKey = [&keys](uint32_t a, uint32_t b) -> bool { return keys[a] < keys[b]; };
+    for (uint8_t side : { sBackward, uint8_t(sForward | sBackward), sForward }) {
+        const std::size_t begin = window.size();
+        for (uint32_t i = 0; i < nbnodes; ++i) {
+            const uint32_t v = (sForward | sBackward) == side ? byPosition[i] : i;
+            if (side == sides[v])
+                fontomas__safe_call(window.push_back(v));
+        }
+        if ((sForward | sBackward) != side)
+            std::sort(window.begin() + std::ptrdiff_t(begin), window.end(), byKey);
+    }
+
+    for (std::size_t i = 0; i < window.size(); ++i) {
+        fontomas__safe_call(tag.nodes.push_back(nodes[window[i]]));
+        fontomas__safe_call(tag.orders.push_back(orders[i]));
+    }
+
+    for (nodeid_t id : nodes)
+        ws.local[id] = sNone;
+}
+
+
+// adds routes, which were accepted by validate(), in stages: capacities are
+// reserved by one thread, because the allocator isn't thread-safe, and then
+// arrays are filled by all threads, so no two threads write one array:
+// fallbacks and edges are split by nodes, parents - by fallbacks, orders -
+// by tags
+template <class Traits>
+void BasicGraph<Traits>::apply(span_t<const Route> routes, span_t<const TagBatch> tags, const Result* results,
+                               uint32_t nbWorkers) noexcept
+{
+    std::vector<uint32_t> accepted;
+    for (const TagBatch& tag : tags) {
+        for (uint32_t i = tag.first; i < tag.last; ++i) {
+            if (eOk == results[_scratch.batch[i]])
+                fontomas__safe_call(accepted.push_back(_scratch.batch[i]));
+        }
+    }
+
+    if (accepted.empty())
+        return;
+
+    // accepted routes are sorted by tags, so both orders below keep tags
+    // ascending for each node and the table order for each tag; routes are
+    // connected in the table order of each node, so its edges are in the
+    // order, which addRoute() gives them (see fallbacksForTags)
+    std::vector<uint32_t> inTable;
+    for (uint32_t i = 0; i < routes.size(); ++i) {
+        if (eOk == results[i])
+            fontomas__safe_call(inTable.push_back(i));
+    }
+
+    std::vector<uint32_t> bySource, byFallback, byTable, buckets, tableBuckets;
+    _scratch.workers->run(std::min(nbWorkers, 3u), 3, [&](uint32_t, uint32_t i) {
+        if (0 == i)
+            counting_sort(accepted, bySource, _scratch.buckets, [&routes](uint32_t i) { return routes[i].nodeId; });
+        else if (1 == i)
+            counting_sort(accepted, byFallback, buckets, [&routes](uint32_t i) { return routes[i].fallbackId; });
+        else
+            counting_sort(inTable, byTable, tableBuckets, [&routes](uint32_t i) { return routes[i].nodeId; });
+    });
+
+    for (std::size_t i = 0; i < bySource.size();) {
+        const nodeid_t nodeId = routes[bySource[i]].nodeId;
+        NodeInfo& info = _nodes[nodeId];
+
+        const std::size_t begin = i;
+        while (i < bySource.size() && routes[bySource[i]].nodeId == nodeId) {
+            const tagid_t tagId = routes[bySource[i]].tagId;
+            std::size_t next = i;
+            while (next < bySource.size() && routes[bySource[next]].nodeId == nodeId &&
+                   routes[bySource[next]].tagId == tagId)
+            {
+                ++next;
+            }
+
+            attach(info, tagId);
+            reserve(info, tagId, uint32_t(next - i), 0);
+            i = next;
+        }
+
+        reserve_edges(info, uint32_t(i - begin));
+    }
+
+    for (std::size_t i = 0; i < byFallback.size();) {
+        const Route& first = routes[byFallback[i]];
+        std::size_t next = i;
+        while (next < byFallback.size() && routes[byFallback[next]].fallbackId == first.fallbackId &&
+               routes[byFallback[next]].tagId == first.tagId)
+        {
+            ++next;
+        }
+
+        NodeInfo& fallback = _nodes[first.fallbackId];
+        attach(fallback, first.tagId);
+        reserve(fallback, first.tagId, 0, uint32_t(next - i));
+        i = next;
+    }
+
+    // arrays have room for all routes now, so connect() and link() don't
+    // allocate
+    std::vector<uint32_t> bounds;
+    const uint32_t nbChunks = nbWorkers * 8;
+
+    // routes, which change resolved chains, are marked for invalidate()
+    std::vector<uint8_t> resolved(byTable.size(), 0);
+
+    split(byTable, nbChunks, bounds, [&routes](uint32_t i) { return routes[i].nodeId; });
+    _scratch.workers->run(nbWorkers, uint32_t(bounds.size() - 1), [&](uint32_t, uint32_t chunk) {
+        for (uint32_t i = bounds[chunk]; i < bounds[chunk + 1]; ++i) {
+            const Route& route = routes[byTable[i]];
+            NodeInfo& info = _nodes[route.nodeId];
+            connect(info, route.fallbackId, route.tagId);
+            resolved[i] = lookup(info, route.tagId)->resolved;
+        }
+    });
+
+    split(byFallback, nbChunks, bounds, [&routes](uint32_t i) { return routes[i].fallbackId; });
+    _scratch.workers->run(nbWorkers, uint32_t(bounds.size() - 1), [&](uint32_t, uint32_t chunk) {
+        for (uint32_t i = bounds[chunk]; i < bounds[chunk + 1]; ++i) {
+            const Route& route = routes[byFallback[i]];
+            link(_nodes[route.fallbackId], route.nodeId, route.tagId);
+        }
+    });
+
+    // orders are compared within a tag only, so all tags took orders beyond
+    // the bounds from the same ones; nodes, which got no route, are not
+    // attached and are skipped
+    uint32_t nbLow = 0, nbHigh = 0;
+    for (const TagBatch& tag : tags) {
+        nbLow = std::max(nbLow, tag.nbLow);
+        nbHigh = std::max(nbHigh, tag.nbHigh);
+    }
+    _lowOrder -= nbLow;
+    _highOrder += nbHigh;
+
+    _scratch.workers->run(nbWorkers, uint32_t(tags.size()), [&](uint32_t, uint32_t t) {
+        const TagBatch& tag = tags[t];
+        for (std::size_t i = 0; i < tag.nodes.size(); ++i) {
+            if (attached(_nodes[tag.nodes[i]], tag.tagId))
+                tag_routes(tag.nodes[i], tag.tagId).order = tag.orders[i];
+        }
+    });
+
+    for (std::size_t i = 0; i < byTable.size(); ++i) {
+        if (resolved[i])
+            invalidate(routes[byTable[i]].nodeId, routes[byTable[i]].tagId);
+    }
+}
+
+
+template <class Traits>
+void BasicGraph<Traits>::resolve(nodeid_t nodeId, tagid_t tagId) noexcept {
+    prepare();
+
+    Traversal& traversal = _scratch.traversal;
+    traversal.reset(_szNodes);
+    _scratch.marks.reset(_szNodes);
+
+    // the chain is merged from chains of fallbacks, thus unresolved ones are
+    // merged first, in a post-order; so a resolved chain implies resolved
+    // chains of all descendants
+    traversal.enter(nodeId);
+    while (!traversal.empty()) {
+        const TagRoutes& route = tag_routes(traversal.top(), tagId);
+
+        if (traversal.cursor() < route.nbfallbacks) {
+            const nodeid_t fallbackId = route.fallbacks[traversal.cursor()++];
+            if (!tag_routes(fallbackId, tagId).resolved &&
+                Traversal::eWhite == traversal.color(fallbackId))
+            {
+                traversal.enter(fallbackId);
+            }
+            continue;
+        }
+
+        merge(traversal.leave(), tagId);
+    }
+}
+
+
+template <class Traits>
+void BasicGraph<Traits>::merge(nodeid_t nodeId, tagid_t tagId) noexcept {
+    TagRoutes& route = tag_routes(nodeId, tagId);
+    Traversal& marks = _scratch.marks;
+
+    auto collect = [&marks, this](nodeid_t id) {
+        if (Traversal::eWhite != marks.color(id))
+            return;
+        marks.paint(id, Traversal::eBlack);
+        _scratch.buffer.push_back(id);
+    };
+
+    // fallback blocks are collected backwards: a node, which is shared by
+    // several fallbacks, goes with the last of them, so it follows all its
+    // ancestors; the buffer is reversed when the chain is stored
+    _scratch.buffer.clear();
+    for (count_t i = route.nbfallbacks; i > 0; --i) {
+        const nodeid_t fallbackId = route.fallbacks[i - 1];
+        const TagRoutes& fallback = tag_routes(fallbackId, tagId);
+
+        for (count_t j = fallback.nbchain; j > 0; --j)
+            collect(fallback.chain[j - 1]);
+        collect(fallbackId);
+    }
+
+    // marks are cleared right away, so the next merge starts with no marks
+    for (nodeid_t id : _scratch.buffer)
+        marks.paint(id, Traversal::eWhite);
+
+    forget(route);
+
+    route.nbchain = static_cast<count_t>(_scratch.buffer.size());
+    if (route.nbchain > 0) {
+        route.chain = allocate<nodeid_t>(_allocator, route.nbchain);
+        std::reverse_copy(_scratch.buffer.begin(), _scratch.buffer.end(), route.chain);
+    }
+    route.resolved = true;
+}
+
+
+template <class Traits>
+void BasicGraph<Traits>::invalidate(nodeid_t nodeId, tagid_t tagId) noexcept {
+    TagRoutes& route = tag_routes(nodeId, tagId);
+
+    // ancestors of an unresolved node can't be resolved (see resolve), so
+    // only resolved ones are visited, and each of them once
+    if (!route.resolved)
+        return;
+
+    Traversal& traversal = _scratch.traversal;
+    traversal.reset(_szNodes);
+
+    forget(route);
+    traversal.push(nodeId);
+
+    while (!traversal.empty()) {
+        const TagRoutes& current = tag_routes(traversal.pop(), tagId);
+
+        for (count_t i = 0; i < current.nbparents; ++i) {
+            TagRoutes& parent = tag_routes(current.parents[i], tagId);
+            if (!parent.resolved)
+                continue;
+
+            forget(parent);
+            traversal.push(current.parents[i]);
+        }
+    }
+}
+
+
+// finds a slot for the tag, which isn't attached yet, so the layout of the
+// node may change (see NodeInfo)
+template <class Traits>
+auto BasicGraph<Traits>::emplace(NodeInfo& info, tagid_t tagId) noexcept -> TagRoutes& {
+    if (TagRoutes* found = lookup(info, tagId))
+        return *found; // a free slot of the dense layout
+
+    const uint32_t count = uint32_t(info.nbtags) + 1;
+
+    if (eSorted == info.layout && count <= sSortedTagsMax) {
+        if (count > info.sztags)
+            relayout(info, eSorted, count_t(std::min<uint32_t>(2 * info.sztags, sSortedTagsMax)), 0);
+
+        count_t i = info.nbtags;
+        for (; i > 0 && info.tags[i - 1] > tagId; --i) {
+            info.tags[i] = info.tags[i - 1];
+            info.routes[i] = info.routes[i - 1];
+        }
+
+        info.tags[i] = tagId;
+        std::memset(info.routes + i, 0, sizeof(TagRoutes));
+        return info.routes[i];
+    }
+
+    if (eHashed == info.layout && 2 * count <= info.sztags)
+        return *probe(info, tagId);
+
+    // the layout is chosen again each time it grows, so the node becomes
+    // dense, once its tags fill a range, in whatever order they were attached
+    tagid_t lo = tagId, hi = tagId;
+    for (count_t i = 0; i < info.sztags; ++i) {
+        const tagid_t id = slot_tag(info, i);
+        if (sNoTag != id) {
+            lo = std::min(lo, id);
+            hi = std::max(hi, id);
+        }
+    }
+
+    // the dense layout gets a half of its span in reserve on the side, where
+    // it grows
+    const uint32_t span = uint32_t(hi) - lo + 1;
+    if (span <= sDenseSpanFactor * count) {
+        const uint32_t reserve = span / 2;
+        const tagid_t base = (tagId == lo && eDense == info.layout)
+                           ? tagid_t(lo - std::min<uint32_t>(lo, reserve)) : lo;
+        const uint32_t above = base < lo ? 0 : reserve;
+        const uint32_t sztags = std::min<uint32_t>(uint32_t(hi) - base + 1 + above, uint32_t(sNoTag) - base);
+        relayout(info, eDense, count_t(sztags), base);
+        return info.routes[tagId - base];
+    }
+
+    uint32_t sztags = sHashedTagsMin;
+    while (sztags < 2 * count)
+        sztags *= 2;
+    relayout(info, eHashed, count_t(sztags), 0);
+
+    return *probe(info, tagId);
+}
+
+
+// frees the slot of the tag, which is detached already
+template <class Traits>
+void BasicGraph<Traits>::erase(NodeInfo& info, tagid_t tagId) noexcept {
+    TagRoutes* slot = lookup(info, tagId);
+    const count_t i = count_t(slot - info.routes);
+
+    switch (info.layout) {
+    case eSorted:
+        std::copy(info.tags + i + 1, info.tags + info.nbtags, info.tags + i);
+        std::copy(info.routes + i + 1, info.routes + info.nbtags, info.routes + i);
+        info.tags[info.nbtags - 1] = sNoTag;
+        std::memset(info.routes + info.nbtags - 1, 0, sizeof(TagRoutes));
+        break;
+    case eDense:
+        break; // a slot without fallbacks is free
+    case eHashed:
+        // probes of other tags may pass the slot, so all tags are placed again
+        info.tags[i] = sNoTag;
+        relayout(info, eHashed, info.sztags, 0);
+        break;
+    }
+
+    --info.nbtags;
+
+    info.tagmask = 0;
+    info.wide = false;
+    for (count_t k = 0; k < info.sztags; ++k) {
+        const tagid_t other = slot_tag(info, k);
+        if (sNoTag != other && info.routes[k].fallbacks) {
+            info.tagmask |= mask_bit(other);
+            info.wide = info.wide || other >= sMaskBits;
+        }
+    }
+}
+
+
+// removes all routes of the tag from and to the node in other nodes; routes
+// of the node itself stay
+template <class Traits>
+void BasicGraph<Traits>::cut(nodeid_t nodeId, tagid_t tagId) noexcept {
+    invalidate(nodeId, tagId);
+
+    const TagRoutes& route = tag_routes(nodeId, tagId);
+    for (count_t i = 0; i < route.nbfallbacks; ++i)
+        unlink(_nodes[route.fallbacks[i]], nodeId, tagId);
+    for (count_t i = 0; i < route.nbparents; ++i)
+        disconnect(_nodes[route.parents[i]], nodeId, tagId);
+}
+
+
+// cuts slots of the node down to the least number, which its layout needs
+template <class Traits>
+void BasicGraph<Traits>::compact(NodeInfo& info) noexcept {
+    switch (info.layout) {
+    case eSorted:
+        if (info.sztags != info.nbtags)
+            relayout(info, eSorted, info.nbtags, 0);
+        break;
+    case eDense: {
+        count_t first = 0, last = info.sztags;
+        while (!info.routes[first].fallbacks)
+            ++first;
+        while (!info.routes[last - 1].fallbacks)
+            --last;
+        if (last - first != info.sztags)
+            relayout(info, eDense, count_t(last - first), tagid_t(info.base + first));
+        break;
+    }
+    case eHashed: {
+        uint32_t sztags = sHashedTagsMin;
+        while (sztags < 2u * info.nbtags)
+            sztags *= 2;
+        if (sztags != info.sztags)
+            relayout(info, eHashed, count_t(sztags), 0);
+        break;
+    }
+    }
+}
+
+
+// cuts all arrays of the node down to their sizes
+template <class Traits>
+void BasicGraph<Traits>::shrink(NodeInfo& info) noexcept {
+    compact(info);
+
+    if (info.coverage)
+        info.coverage->shrink_to_fit();
+
+    if (info.szedges != info.nbedges) {
+        resize<uint64_t, count_t>(_allocator, &info.edgemasks, info.szedges, info.nbedges);
+        info.szedges = resize<nodeid_t, count_t>(_allocator, &info.edges, info.szedges, info.nbedges);
+    }
+
+    for (count_t slot = 0; slot < info.sztags; ++slot) {
+        TagRoutes& route = info.routes[slot];
+        if (!route.fallbacks)
+            continue;
+
+        // fallbacks of an attached tag are never null
+        const count_t szfallbacks = std::max<count_t>(route.nbfallbacks, 1);
+        if (route.szfallbacks != szfallbacks)
+            route.szfallbacks = resize<nodeid_t, count_t>(_allocator, &route.fallbacks, route.szfallbacks, szfallbacks);
+        if (route.szparents != route.nbparents)
+            route.szparents = resize<nodeid_t, count_t>(_allocator, &route.parents, route.szparents, route.nbparents);
+    }
+}
+
+
+// moves all routes of the node into new arrays of the given layout
+template <class Traits>
+void BasicGraph<Traits>::relayout(NodeInfo& info, Layout layout, count_t sztags, tagid_t base) noexcept {
+    NodeInfo moved = info;
+    moved.routes = allocate<TagRoutes>(_allocator, sztags);
+    std::memset(moved.routes, 0, sizeof(TagRoutes) * sztags);
+    moved.tags = nullptr;
+    if (eDense != layout) {
+        moved.tags = allocate<tagid_t>(_allocator, sztags);
+        std::fill(moved.tags, moved.tags + sztags, sNoTag);
+    }
+    moved.sztags = sztags;
+    moved.base = base;
+    moved.layout = layout;
+
+    // the sorted layout is taken only by sorted routes, thus they are just
+    // appended
+    count_t nbsorted = 0;
+    for (count_t i = 0; i < info.sztags; ++i) {
+        const tagid_t tagId = slot_tag(info, i);
+        if (sNoTag == tagId)
+            continue;
+
+        TagRoutes* slot = nullptr;
+        switch (layout) {
+        case eSorted:
+            moved.tags[nbsorted] = tagId;
+            slot = moved.routes + nbsorted++;
+            break;
+        case eDense:
+            slot = moved.routes + (tagId - base);
+            break;
+        case eHashed:
+            slot = probe(moved, tagId);
+            break;
+        }
+
+        *slot = info.routes[i];
+    }
+
+    deallocate(_allocator, info.routes, info.sztags);
+    deallocate(_allocator, info.tags, info.sztags);
+
+    info = moved;
+}
+
+
+/*static*/
+template <class Traits>
+auto BasicGraph<Traits>::probe(NodeInfo& info, tagid_t tagId) noexcept -> TagRoutes* {
+    const count_t mask = info.sztags - 1;
+
+    count_t slot = hash(tagId) & mask;
+    while (sNoTag != info.tags[slot])
+        slot = (slot + 1) & mask;
+
+    info.tags[slot] = tagId;
+    return info.routes + slot;
+}
+
+
+/*static*/
+template <class Traits>
+auto BasicGraph<Traits>::slot_tag(const NodeInfo& info, count_t slot) noexcept -> tagid_t {
+    switch (info.layout) {
+    case eDense:
+        return info.routes[slot].fallbacks ? tagid_t(info.base + slot) : sNoTag;
+    case eSorted:
+        return slot < info.nbtags ? info.tags[slot] : sNoTag;
+    case eHashed:
+        return info.tags[slot];
+    }
+
+    return sNoTag;
+}
+
+
+/*static*/
+template <class Traits>
+bool BasicGraph<Traits>::has_route(const NodeInfo& info, nodeid_t fallbackId, tagid_t tagId) noexcept {
+    if (detached(info, tagId))
+        return false; // tag is not attached
+
+    const TagRoutes& tag = *lookup(info, tagId);
+    return find_id(tag.fallbacks, tag.nbfallbacks, fallbackId) < tag.nbfallbacks;
+}
+
+
+template <class Traits>
+void BasicGraph<Traits>::Scratch::release() noexcept {
+    traversal.release();
+    marks.release();
+
+    for (std::vector<nodeid_t>* v : { &buffer, &stack, &forward, &backward })
+        std::vector<nodeid_t>().swap(*v);
+    for (std::vector<uint32_t>* v : { &orders, &batch, &added, &buckets })
+        std::vector<uint32_t>().swap(*v);
+    std::vector<Workspace>().swap(workspaces);
+    workers.reset();
+    std::vector<Result>().swap(results);
+    std::vector<Candidate>().swap(frontier);
+    std::vector<uint32_t>().swap(costs);
+    std::vector<nodeid_t>().swap(parents);
+}
+
+
+// GRAPH INLINES
+
+
+/*inline*/
+template <class Traits>
+void BasicGraph<Traits>::allocNodes(nodeid_t maxNodeId, bool exact) noexcept {
+    if (maxNodeId >= _szNodes) {
+        const uint32_t szNodes = exact ? uint32_t(maxNodeId) + 1
+                               : grown(_szNodes, uint32_t(maxNodeId) + 1, sNodesReserved, sMaxIds<nodeid_t>);
+        _szNodes = resize<NodeInfo, uint32_t>(_allocator, &_nodes, _szNodes, szNodes);
+    }
+}
+
+
+/*inline*/
+template <class Traits>
+void BasicGraph<Traits>::reserve_orders(uint32_t nbLow, uint32_t nbHigh) noexcept {
+    // order 0 is never taken, so the low bound never wraps either
+    if (_lowOrder > nbLow && std::numeric_limits<uint32_t>::max() - _highOrder >= nbHigh)
+        return;
+
+    renumber();
+    if (_lowOrder <= nbLow || std::numeric_limits<uint32_t>::max() - _highOrder < nbHigh)
+        fontomas__hardbreak; // more orders than 32 bits hold
+}
+
+
+/*inline*/
+template <class Traits>
+auto BasicGraph<Traits>::tag_routes(nodeid_t nodeId, tagid_t tagId) const noexcept -> TagRoutes& {
+    return *lookup(_nodes[nodeId], tagId);
+}
+
+
+/*static inline*/
+template <class Traits>
+auto BasicGraph<Traits>::lookup(const NodeInfo& info, tagid_t tagId) noexcept -> TagRoutes* {
+    switch (info.layout) {
+    case eDense: {
+        // a tag below the base wraps around to a big slot
+        const uint32_t slot = uint32_t(tagid_t(tagId - info.base));
+        return slot < info.sztags ? info.routes + slot : nullptr;
+    }
+    case eSorted:
+        for (count_t i = 0; i < info.nbtags && info.tags[i] <= tagId; ++i) {
+            if (info.tags[i] == tagId)
+                return info.routes + i;
+        }
+        return nullptr;
+    case eHashed: {
+        const count_t mask = info.sztags - 1;
+        for (count_t slot = hash(tagId) & mask;; slot = (slot + 1) & mask) {
+            if (sNoTag == info.tags[slot])
+                return nullptr;
+            if (tagId == info.tags[slot])
+                return info.routes + slot;
+        }
+    }
+    }
+
+    return nullptr;
+}
+
+
+/*static inline*/
+template <class Traits>
+auto BasicGraph<Traits>::hash(tagid_t tagId) noexcept -> count_t {
+    return count_t((uint64_t(tagId) * 2654435761u) >> 16);
+}
+
+
+/*static inline*/
+template <class Traits>
+bool BasicGraph<Traits>::exists(const NodeInfo& info) noexcept {
+    return info.routes != nullptr && info.nbtags > 0;
+}
+
+
+/*static inline*/
+template <class Traits>
+void BasicGraph<Traits>::prefetch(const NodeInfo& info, tagid_t tagId) noexcept {
+    switch (info.layout) {
+    case eDense: {
+        const uint32_t slot = uint32_t(tagid_t(tagId - info.base));
+        if (slot < info.sztags)
+            fontomas__prefetch(info.routes + slot);
+        break;
+    }
+    case eSorted:
+        fontomas__prefetch(info.tags);
+        fontomas__prefetch(info.routes);
+        break;
+    case eHashed: {
+        const count_t slot = hash(tagId) & (info.sztags - 1);
+        fontomas__prefetch(info.tags + slot);
+        fontomas__prefetch(info.routes + slot);
+        break;
+    }
+    }
+}
+
+
+/*static inline*/
+template <class Traits>
+bool BasicGraph<Traits>::attached(const NodeInfo &info, tagid_t tagId) noexcept {
+    const TagRoutes* route = lookup(info, tagId);
+    return route && !!route->fallbacks;
+}
+
+
+/*static inline*/
+template <class Traits>
+bool BasicGraph<Traits>::detached(const NodeInfo &info, tagid_t tagId) noexcept {
+    return !attached(info, tagId);
+}
+
+
+/*inline*/
+template <class Traits>
+bool BasicGraph<Traits>::attach(NodeInfo& info, tagid_t tagId) noexcept {
+    if (attached(info, tagId))
+        return false;
+
+    TagRoutes& route = emplace(info, tagId);
+    route.fallbacks = allocate<nodeid_t>(_allocator, sFallbacksReserved);
+    route.nbfallbacks = 0;
+    route.szfallbacks = sFallbacksReserved;
+
+    ++info.nbtags;
+    info.tagmask |= mask_bit(tagId);
+    info.wide = info.wide || tagId >= sMaskBits;
+
+    return true;
+}
+
+
+/*inline*/
+template <class Traits>
+void BasicGraph<Traits>::detach(NodeInfo& info, tagid_t tagId) noexcept {
+    if (detached(info, tagId))
+        return;
+
+    TagRoutes& route = *lookup(info, tagId);
+
+    forget(route);
+
+    deallocate(_allocator, route.fallbacks, route.szfallbacks);
+    route.fallbacks = nullptr;
+    route.nbfallbacks = route.szfallbacks = 0;
+
+    deallocate(_allocator, route.parents, route.szparents);
+    route.parents = nullptr;
+    route.nbparents = route.szparents = 0;
+}
+
+
+/*inline*/
+template <class Traits>
+void BasicGraph<Traits>::connect(NodeInfo& info, nodeid_t fallbackId, tagid_t tagId) noexcept {
+    TagRoutes& route = *lookup(info, tagId);
+    if (route.szfallbacks <= route.nbfallbacks) {
+        const uint32_t szfallbacks = grown(route.szfallbacks, route.nbfallbacks + 1u, sFallbacksReserved, sMaxCount<count_t>);
+        route.szfallbacks = resize<nodeid_t, count_t>(_allocator, &route.fallbacks, route.szfallbacks, count_t(szfallbacks));
+    }
+
+    route.fallbacks[route.nbfallbacks++] = fallbackId;
+
+    const uint32_t e = find_id(info.edges, info.nbedges, fallbackId);
+    if (e < info.nbedges) {
+        info.edgemasks[e] |= mask_bit(tagId);
+        return;
+    }
+
+    reserve_edges(info, 1);
+    info.edges[info.nbedges] = fallbackId;
+    info.edgemasks[info.nbedges++] = mask_bit(tagId);
+}
+
+
+/*inline*/
+template <class Traits>
+void BasicGraph<Traits>::link(NodeInfo& info, nodeid_t parentId, tagid_t tagId) noexcept {
+    TagRoutes& route = *lookup(info, tagId);
+    if (route.szparents <= route.nbparents) {
+        const uint32_t szparents = grown(route.szparents, route.nbparents + 1u, sFallbacksReserved, sMaxCount<count_t>);
+        route.szparents = resize<nodeid_t, count_t>(_allocator, &route.parents, route.szparents, count_t(szparents));
+    }
+
+    route.parents[route.nbparents++] = parentId;
+}
+
+
+/*static inline*/
+template <class Traits>
+void BasicGraph<Traits>::disconnect(NodeInfo& info, nodeid_t fallbackId, tagid_t tagId) noexcept {
+    TagRoutes& route = *lookup(info, tagId);
+
+    nodeid_t* last = route.fallbacks + route.nbfallbacks;
+    nodeid_t* found = std::find(route.fallbacks, last, fallbackId);
+    if (found == last)
+        return;
+
+    std::copy(found + 1, last, found);
+    --route.nbfallbacks;
+
+    drop_edge(info, fallbackId, tagId);
+}
+
+
+/*static inline*/
+template <class Traits>
+void BasicGraph<Traits>::drop_edge(NodeInfo& info, nodeid_t fallbackId, tagid_t tagId) noexcept {
+    const uint32_t e = find_id(info.edges, info.nbedges, fallbackId);
+    if (e == info.nbedges)
+        return;
+
+    // the bit of the tag stays, if another tag with the same bit has the edge
+    for (count_t slot = 0; info.wide && slot < info.sztags; ++slot) {
+        const tagid_t other = slot_tag(info, slot);
+        if (sNoTag != other && other != tagId && mask_bit(other) == mask_bit(tagId) &&
+            has_route(info, fallbackId, other))
+        {
+            return;
+        }
+    }
+
+    info.edgemasks[e] &= ~mask_bit(tagId);
+    if (0 != info.edgemasks[e])
+        return;
+
+    std::copy(info.edges + e + 1, info.edges + info.nbedges, info.edges + e);
+    std::copy(info.edgemasks + e + 1, info.edgemasks + info.nbedges, info.edgemasks + e);
+    --info.nbedges;
+}
+
+
+/*static inline*/
+template <class Traits>
+void BasicGraph<Traits>::unlink(NodeInfo& info, nodeid_t parentId, tagid_t tagId) noexcept {
+    TagRoutes& route = *lookup(info, tagId);
+
+    nodeid_t* last = route.parents + route.nbparents;
+    nodeid_t* found = std::find(route.parents, last, parentId);
+    if (found == last)
+        return;
+
+    std::copy(found + 1, last, found);
+    --route.nbparents;
+}
+
+
+/*inline*/
+template <class Traits>
+void BasicGraph<Traits>::reserve(NodeInfo& info, tagid_t tagId, uint32_t nbfallbacks, uint32_t nbparents) noexcept {
+    TagRoutes& route = *lookup(info, tagId);
+
+    const uint32_t szfallbacks = grown(route.szfallbacks, route.nbfallbacks + nbfallbacks, sFallbacksReserved, sMaxCount<count_t>);
+    if (route.szfallbacks < szfallbacks) {
+        route.szfallbacks = resize<nodeid_t, count_t>(_allocator, &route.fallbacks, route.szfallbacks, count_t(szfallbacks));
+    }
+
+    const uint32_t szparents = grown(route.szparents, route.nbparents + nbparents, sFallbacksReserved, sMaxCount<count_t>);
+    if (route.szparents < szparents) {
+        route.szparents = resize<nodeid_t, count_t>(_allocator, &route.parents, route.szparents, count_t(szparents));
+    }
+
+    reserve_edges(info, nbfallbacks);
+}
+
+
+/*inline*/
+template <class Traits>
+void BasicGraph<Traits>::reserve_edges(NodeInfo& info, uint32_t nbedges) noexcept {
+    const uint32_t szedges = grown(info.szedges, info.nbedges + nbedges, sFallbacksReserved, sMaxCount<count_t>);
+    if (info.szedges < szedges) {
+        resize<uint64_t, count_t>(_allocator, &info.edgemasks, info.szedges, count_t(szedges));
+        info.szedges = resize<nodeid_t, count_t>(_allocator, &info.edges, info.szedges, count_t(szedges));
+    }
+}
+
+
+/*inline*/
+template <class Traits>
+void BasicGraph<Traits>::forget(TagRoutes& route) noexcept {
+    deallocate(_allocator, route.chain, route.nbchain);
+    route.chain = nullptr;
+    route.nbchain = 0;
+    route.resolved = false;
+}
+
+
+/*inline*/
+template <class Traits>
+void BasicGraph<Traits>::release(NodeInfo& info) noexcept {
+    if (!info.routes)
+        return;
+
+    for (count_t i = 0; i < info.sztags; ++i) {
+        const tagid_t tagId = slot_tag(info, i);
+        if (sNoTag != tagId && info.routes[i].fallbacks)
+            detach(info, tagId);
+    }
+
+    deallocate(_allocator, info.routes, info.sztags);
+    deallocate(_allocator, info.tags, info.sztags);
+    deallocate(_allocator, info.edges, info.szedges);
+    deallocate(_allocator, info.edgemasks, info.szedges);
+
+    if (info.coverage) {
+        info.coverage->~Coverage();
+        deallocate(_allocator, info.coverage, 1);
+    }
+}
+
+
+
+template class fontomas::fallback::BasicGraph<GraphTraits<uint8_t, uint8_t>>;
+template class fontomas::fallback::BasicGraph<GraphTraits<uint16_t, uint16_t>>;
+template class fontomas::fallback::BasicGraph<GraphTraits<uint32_t, uint32_t>>;
+
 
 // fallback/graph.cpp
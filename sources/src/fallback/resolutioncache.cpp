@@ -0,0 +1,237 @@
+#include "fontomas/fallback/resolutioncache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+#include "fontomas/debug.h"
+#include "fontomas/fallback/consts.h"
+
+
+using namespace fontomas;
+using namespace fontomas::fallback;
+
+
+namespace {
+
+
+    constexpr uint32_t sMaxSize = uint32_t(1) << 31;
+
+    uint32_t round_up(uint32_t value) noexcept {
+        uint32_t rounded = 1;
+        while (rounded < value && rounded < sMaxSize)
+            rounded <<= 1;
+        return rounded;
+    }
+
+
+}
+
+
+// RESOLUTIONCACHE PUBLICS
+
+
+ResolutionCache::ResolutionCache(Graph& graph, uint32_t capacity, uint32_t nbShards,
+                                 Allocator& allocator) noexcept
+    : _graph(graph)
+    , _allocator(allocator)
+    , _nbShards(round_up(std::max(nbShards, 1u)))
+    , _mask(std::max(round_up(capacity) / _nbShards, sProbes) - 1)
+{
+    _shards.reset(new (std::nothrow) Shard[_nbShards]);
+    if (!_shards)
+        fontomas__hardbreak; // out of memory
+
+    const std::size_t szEntries = sizeof(Entry) * (_mask + 1);
+    for (uint32_t i = 0; i < _nbShards; ++i) {
+        Shard& shard = _shards[i];
+        shard.entries = static_cast<Entry*>(_allocator.allocate(szEntries));
+        if (!shard.entries)
+            fontomas__hardbreak; // out of memory
+
+        std::memset(shard.entries, 0, szEntries);
+        shard.generation = _graph.generation();
+        shard.hits = shard.misses = 0;
+        shard.victim = 0;
+    }
+}
+
+
+ResolutionCache::ResolutionCache(DIContainer& di, Graph& graph, uint32_t capacity,
+                                 uint32_t nbShards, Allocator& allocator) noexcept
+    : ResolutionCache(graph, capacity, nbShards, allocator)
+{
+    _logger = di.resolveService<services::Logger>();
+}
+
+
+ResolutionCache::~ResolutionCache() noexcept {
+    for (uint32_t i = 0; i < _nbShards; ++i)
+        _allocator.deallocate(_shards[i].entries, sizeof(Entry) * (_mask + 1));
+}
+
+
+nodeid_t ResolutionCache::resolve(nodeid_t nodeId, tagid_t tagId, codepoint_t codepoint) noexcept {
+    // no coverage has such codepoints and they don't fit into a key
+    if (codepoint > Coverage::sMaxCodepoint)
+        return sNotConnected;
+
+    const uint64_t k = key(nodeId, tagId, codepoint);
+    const uint64_t h = hash(k);
+
+    Shard& shard = _shards[uint32_t(h >> 32) & (_nbShards - 1)];
+    const uint32_t start = uint32_t(h) & _mask;
+    {
+        std::lock_guard<std::mutex> lock(shard.lock);
+        sync(shard, _graph.generation());
+
+        for (uint32_t i = 0; i < sProbes; ++i) {
+            const Entry& entry = shard.entries[(start + i) & _mask];
+            if (k == entry.key) {
+                ++shard.hits;
+                return entry.nodeId;
+            }
+        }
+
+        ++shard.misses;
+    }
+
+    // the shard isn't locked, while the graph is searched, so other keys of
+    // the shard are served meanwhile
+    nodeid_t foundId;
+    uint64_t generation;
+    bool found;
+    {
+        std::shared_lock<std::shared_mutex> graphLock(_graphLock);
+        found = _graph.cachedCovering(nodeId, tagId, codepoint, foundId);
+        generation = _graph.generation();
+    }
+    if (!found) {
+        std::lock_guard<std::shared_mutex> graphLock(_graphLock);
+        foundId = _graph.firstCovering(nodeId, tagId, codepoint);
+        generation = _graph.generation();
+    }
+
+    std::lock_guard<std::mutex> lock(shard.lock);
+    // the shard may have moved to a later generation, then the result is
+    // stale and is not kept
+    if (!sync(shard, generation))
+        return foundId;
+
+    // another thread may have resolved the key meanwhile
+    Entry* vacant = nullptr;
+    for (uint32_t i = 0; i < sProbes; ++i) {
+        Entry& entry = shard.entries[(start + i) & _mask];
+        if (k == entry.key)
+            return entry.nodeId;
+        if (!vacant && 0 == entry.key)
+            vacant = &entry;
+    }
+
+    // the window is full, so entries of the window are evicted in turn
+    if (!vacant) {
+        vacant = &shard.entries[(start + shard.victim) & _mask];
+        shard.victim = (shard.victim + 1) % sProbes;
+    }
+
+    vacant->key = k;
+    vacant->nodeId = foundId;
+
+    return foundId;
+}
+
+
+void ResolutionCache::clear() noexcept {
+    for (uint32_t i = 0; i < _nbShards; ++i) {
+        Shard& shard = _shards[i];
+        std::lock_guard<std::mutex> lock(shard.lock);
+        std::memset(shard.entries, 0, sizeof(Entry) * (_mask + 1));
+    }
+}
+
+
+ResolutionCache::Stats ResolutionCache::stats() const noexcept {
+    Stats stats;
+    for (uint32_t i = 0; i < _nbShards; ++i) {
+        Shard& shard = _shards[i];
+        std::lock_guard<std::mutex> lock(shard.lock);
+        stats.hits += shard.hits;
+        stats.misses += shard.misses;
+    }
+
+    return stats;
+}
+
+
+void ResolutionCache::report() const noexcept {
+    using Level = services::Logger::Level;
+
+    if (!_logger || !_logger->visible(Level::Info))
+        return;
+
+    const Stats s = stats();
+    const uint64_t total = s.hits + s.misses;
+    const double rate = total > 0 ? 100.0 * double(s.hits) / double(total) : 0.0;
+
+    char message[128];
+    std::snprintf(message, sizeof(message),
+                  "fallback::ResolutionCache: %llu hits, %llu misses, %.1f%% hit rate",
+                  static_cast<unsigned long long>(s.hits),
+                  static_cast<unsigned long long>(s.misses), rate);
+    _logger->print(Level::Info, message);
+}
+
+
+MemoryStats ResolutionCache::memory() const noexcept {
+    MemoryStats stats;
+    stats.reserved = stats.used = sizeof(Entry) * (_mask + 1) * _nbShards;
+    return stats;
+}
+
+
+// RESOLUTIONCACHE PRIVATES
+
+
+bool ResolutionCache::sync(Shard& shard, uint64_t generation) noexcept {
+    // generations only grow, so a later one of the shard is kept
+    if (shard.generation > generation)
+        return false;
+
+    if (shard.generation < generation) {
+        std::memset(shard.entries, 0, sizeof(Entry) * (_mask + 1));
+        shard.generation = generation;
+    }
+    return true;
+}
+
+
+// RESOLUTIONCACHE INLINES
+
+
+/*static inline*/
+uint64_t ResolutionCache::key(nodeid_t nodeId, tagid_t tagId, codepoint_t codepoint) noexcept {
+    // a key is the flag, a node id at bits 37-52, a tag id at bits 21-36
+    // and a codepoint at bits 0-20, so ids must be 16 bits at most
+    static_assert(sizeof(nodeid_t) <= 2 && sizeof(tagid_t) <= 2,
+                  "node and tag ids don't fit into a key");
+    static_assert(Coverage::sMaxCodepoint < (codepoint_t(1) << 21), "codepoints don't fit into a key");
+
+    return (uint64_t(1) << 63) | (uint64_t(nodeId) << 37) | (uint64_t(tagId) << 21) | codepoint;
+}
+
+
+/*static inline*/
+uint64_t ResolutionCache::hash(uint64_t key) noexcept {
+    // a finalizer of splitmix64: every bit of the key affects all bits of
+    // the hash, so both the shard and the slot bits are well mixed
+    key ^= key >> 30;
+    key *= 0xBF58476D1CE4E5B9ull;
+    key ^= key >> 27;
+    key *= 0x94D049BB133111EBull;
+    key ^= key >> 31;
+    return key;
+}
+
+
+// fallback/resolutioncache.cpp
@@ -0,0 +1,60 @@
+#include "fontomas/fallback/traversal.h"
+
+#include <algorithm>
+
+#include "fontomas/debug.h"
+#include "fontomas/macros.h"
+
+
+using namespace fontomas;
+using namespace fontomas::fallback;
+
+
+// TRAVERSAL PUBLICS
+
+
+template <typename NodeId, typename Cursor>
+void BasicTraversal<NodeId, Cursor>::reset(std::size_t nbNodes) noexcept {
+    const std::size_t nbWords = (nbNodes + sNodesPerWord - 1) / sNodesPerWord;
+
+    if (_overflow) {
+        std::fill(_colors.begin(), _colors.end(), 0);
+    } else {
+        for (uint32_t word : _painted)
+            _colors[word] = 0;
+    }
+    _painted.clear();
+    _overflow = false;
+
+    _stack.clear();
+    _cursors.clear();
+
+    if (_colors.size() < nbWords) {
+        fontomas__safe_call(_colors.resize(nbWords, 0));
+        fontomas__safe_call(_painted.reserve(nbWords));
+    }
+
+    // each node is pushed once at most, so the stack can't grow later
+    if (_stack.capacity() < nbNodes) {
+        fontomas__safe_call(_stack.reserve(nbNodes));
+        fontomas__safe_call(_cursors.reserve(nbNodes));
+    }
+}
+
+
+template <typename NodeId, typename Cursor>
+void BasicTraversal<NodeId, Cursor>::release() noexcept {
+    std::vector<uint64_t>().swap(_colors);
+    std::vector<nodeid_t>().swap(_stack);
+    std::vector<cursor_t>().swap(_cursors);
+    std::vector<uint32_t>().swap(_painted);
+    _overflow = false;
+}
+
+
+template class fontomas::fallback::BasicTraversal<uint8_t, uint16_t>;
+template class fontomas::fallback::BasicTraversal<uint16_t, uint16_t>;
+template class fontomas::fallback::BasicTraversal<uint32_t, uint32_t>;
+
+
+// fallback/traversal.cpp
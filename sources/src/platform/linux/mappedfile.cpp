@@ -0,0 +1,44 @@
+#include "fontomas/mappedfile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+using namespace fontomas;
+
+
+bool MappedFile::open(const char* path) noexcept {
+    close();
+
+    const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    // the mapping keeps the file, so the descriptor isn't needed anymore
+    struct stat info;
+    void* data = MAP_FAILED;
+    if (0 == ::fstat(fd, &info) && info.st_size > 0)
+        data = ::mmap(nullptr, std::size_t(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (MAP_FAILED == data)
+        return false;
+
+    _data = static_cast<const uint8_t*>(data);
+    _size = std::size_t(info.st_size);
+
+    return true;
+}
+
+
+void MappedFile::close() noexcept {
+    if (!_data)
+        return;
+
+    ::munmap(const_cast<uint8_t*>(_data), _size);
+
+    _data = nullptr;
+    _size = 0;
+}
@@ -16,8 +16,12 @@ int main(int argc, char** argv) {
     std::srand(unsigned(std::time(0)));
 
     std::list<Test> allTests;
+    fontomas__enable_suit(Allocator, allTests);
     fontomas__enable_suit(DI, allTests);
     fontomas__enable_suit(FallbackGraph, allTests);
+    fontomas__enable_suit(FallbackConcurrentGraph, allTests);
+    fontomas__enable_suit(FallbackCoverage, allTests);
+    fontomas__enable_suit(FallbackResolutionCache, allTests);
 
     LOG << "----------------------------------------\n";
     LOG << "fontomas v" << fontomas::VersionInfo::toString() << " tester\n";
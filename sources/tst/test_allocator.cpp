@@ -0,0 +1,178 @@
+#include "fontomas/allocator.h"
+
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <thread>
+#include <vector>
+
+#include "fontomas/fallback/graph.h"
+
+#include "testsglobals.h"
+
+
+bool test__allocator__heap();
+bool test__allocator__heap_threads();
+bool test__allocator__arena();
+bool test__allocator__pool();
+
+
+fontomas__tests_suit_begin(Allocator)
+    fontomas__test(test__allocator__heap),
+    fontomas__test(test__allocator__heap_threads),
+    fontomas__test(test__allocator__arena),
+    fontomas__test(test__allocator__pool)
+fontomas__tests_suit_end(Allocator);
+
+
+namespace {
+
+    bool aligned(const void* block) {
+        return 0 == reinterpret_cast<std::uintptr_t>(block) % alignof(std::max_align_t);
+    }
+
+}
+
+
+bool test__allocator__heap() {
+    using namespace fontomas;
+
+    HeapAllocator heap;
+    fontomas__check_true(nullptr == heap.allocate(0));
+
+    void* a = heap.allocate(10);
+    void* b = heap.allocate(100);
+    fontomas__check_true(a != nullptr && b != nullptr);
+    fontomas__check_equal(heap.stats().reserved, std::size_t(110));
+    fontomas__check_equal(heap.stats().used, std::size_t(110));
+
+    heap.deallocate(a, 10);
+    heap.deallocate(b, 100);
+    fontomas__check_equal(heap.stats().used, std::size_t(0));
+
+    return true;
+}
+
+
+// graphs of different threads share the default heap allocator
+bool test__allocator__heap_threads() {
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    static constexpr nodeid_t sNbNodes = 2000;
+
+    const std::size_t used = Allocator::heap().stats().used;
+
+    std::size_t nbRoutes[2] = { 0, 0 };
+    auto fill = [&nbRoutes](int t) {
+        Graph g;
+        for (nodeid_t n = 0; n < sNbNodes; ++n)
+            g.addNode(n, tagid_t(t));
+        for (nodeid_t n = 0; n + 1 < sNbNodes; ++n) {
+            g.addRoute(n, nodeid_t(n + 1), tagid_t(t));
+            if (n + 2 < sNbNodes)
+                g.addRoute(n, nodeid_t(n + 2), tagid_t(t));
+        }
+        for (nodeid_t n = 0; n < sNbNodes; ++n)
+            nbRoutes[t] += g.fallbacks(n, tagid_t(t)).size();
+        g.shrink_to_fit();
+    };
+
+    std::thread a(fill, 0), b(fill, 1);
+    a.join();
+    b.join();
+
+    fontomas__check_equal(nbRoutes[0], std::size_t(2 * sNbNodes - 3));
+    fontomas__check_equal(nbRoutes[1], std::size_t(2 * sNbNodes - 3));
+    fontomas__check_equal(Allocator::heap().stats().used, used);
+
+    return true;
+}
+
+
+bool test__allocator__arena() {
+    using namespace fontomas;
+
+    ArenaAllocator arena(1024);
+
+    uint8_t* a = static_cast<uint8_t*>(arena.allocate(10));
+    uint8_t* b = static_cast<uint8_t*>(arena.allocate(20));
+    fontomas__check_true(aligned(a) && aligned(b));
+    fontomas__check_true(b > a && b - a < 32);
+    fontomas__check_equal(arena.stats().reserved, std::size_t(1024));
+
+    // the last block is taken back, others stay reserved
+    arena.deallocate(b, 20);
+    fontomas__check_equal(static_cast<uint8_t*>(arena.allocate(20)), b);
+    arena.deallocate(a, 10);
+    fontomas__check_true(static_cast<uint8_t*>(arena.allocate(10)) > b);
+
+    // a big block gets its own chunk and the current chunk is still used
+    void* big = arena.allocate(4000);
+    fontomas__check_true(big != nullptr && aligned(big));
+    std::memset(big, 0xff, 4000);
+    uint8_t* c = static_cast<uint8_t*>(arena.allocate(10));
+    fontomas__check_true(c > b && c < b + 1024);
+
+    MemoryStats stats = arena.stats();
+    fontomas__check_true(stats.reserved > std::size_t(1024 + 4000));
+    fontomas__check_true(stats.used <= stats.reserved);
+
+    arena.release();
+    fontomas__check_equal(arena.stats().reserved, std::size_t(0));
+    fontomas__check_equal(arena.stats().used, std::size_t(0));
+
+    return true;
+}
+
+
+bool test__allocator__pool() {
+    using namespace fontomas;
+
+    PoolAllocator pool;
+
+    // blocks of one class are reused
+    void* a = pool.allocate(24);
+    fontomas__check_true(aligned(a));
+    fontomas__check_equal(pool.stats().used, std::size_t(32));
+    pool.deallocate(a, 24);
+    fontomas__check_equal(pool.stats().used, std::size_t(0));
+    fontomas__check_equal(pool.allocate(32), a);
+    pool.deallocate(a, 32);
+
+    const std::size_t reserved = pool.stats().reserved;
+
+    std::vector<void*> blocks;
+    for (std::size_t i = 1; i <= 200; ++i) {
+        void* block = pool.allocate(i * 3);
+        fontomas__check_true(block != nullptr && aligned(block));
+        std::memset(block, int(i), i * 3);
+        blocks.push_back(block);
+    }
+    for (std::size_t i = 1; i <= 200; ++i) {
+        const uint8_t* block = static_cast<const uint8_t*>(blocks[i - 1]);
+        fontomas__check_true(block[0] == uint8_t(i) && block[i * 3 - 1] == uint8_t(i));
+        pool.deallocate(blocks[i - 1], i * 3);
+    }
+    fontomas__check_equal(pool.stats().used, std::size_t(0));
+
+    // the same blocks are taken again, so nothing is reserved
+    const std::size_t reservedAll = pool.stats().reserved;
+    for (std::size_t i = 1; i <= 200; ++i)
+        blocks[i - 1] = pool.allocate(i * 3);
+    fontomas__check_equal(pool.stats().reserved, reservedAll);
+    fontomas__check_true(reservedAll > reserved);
+    for (std::size_t i = 1; i <= 200; ++i)
+        pool.deallocate(blocks[i - 1], i * 3);
+
+    // big blocks go to the heap
+    void* big = pool.allocate(PoolAllocator::sMaxBlockSize + 1);
+    fontomas__check_equal(pool.stats().reserved, reservedAll + PoolAllocator::sMaxBlockSize + 1);
+    pool.deallocate(big, PoolAllocator::sMaxBlockSize + 1);
+    fontomas__check_equal(pool.stats().reserved, reservedAll);
+
+    return true;
+}
+
+
+// tst/test_allocator.cpp
@@ -1,6 +1,12 @@
 #include "fontomas/di.h"
 
+#include <atomic>
+#include <cstring>
 #include <list>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "testsglobals.h"
 
@@ -8,12 +14,30 @@
 bool test__di__dicontainer_registerservice();
 bool test__di__dicontainer_resolveservice();
 bool test__di__dicontainer_resolve();
+bool test__di__dicontainer_getservice();
+bool test__di__dicontainer_concurrent();
+bool test__di__dicontainer_reclaim();
+bool test__di__dicontainer_nested();
+bool test__di__dicontainer_serviceid();
+bool test__di__dicontainer_lazy();
+bool test__di__dicontainer_scoped();
+bool test__di__inject_macros();
+bool test__di__injected();
 
 
 fontomas__tests_suit_begin(DI)
     fontomas__test(test__di__dicontainer_registerservice),
     fontomas__test(test__di__dicontainer_resolveservice),
-    fontomas__test(test__di__dicontainer_resolve)
+    fontomas__test(test__di__dicontainer_resolve),
+    fontomas__test(test__di__dicontainer_getservice),
+    fontomas__test(test__di__dicontainer_concurrent),
+    fontomas__test(test__di__dicontainer_reclaim),
+    fontomas__test(test__di__dicontainer_nested),
+    fontomas__test(test__di__dicontainer_serviceid),
+    fontomas__test(test__di__dicontainer_lazy),
+    fontomas__test(test__di__dicontainer_scoped),
+    fontomas__test(test__di__inject_macros),
+    fontomas__test(test__di__injected)
 fontomas__tests_suit_end(DI);
 
 
@@ -21,13 +45,42 @@ namespace fontomas { ;
 
 class DITester {
 public:
-    static std::unordered_map<const char*, DIContainer::BaseHolder::Ptr>& table(DIContainer& di) noexcept {
-        return di._serviceTable;
+    // registered services by their names
+    static std::unordered_map<const char*, DIContainer::BaseHolder*> table(DIContainer& di) noexcept {
+        std::unordered_map<const char*, DIContainer::BaseHolder*> table;
+        if (const DIContainer::Table* slots = di._table.load()) {
+            for (const DIContainer::Slot& slot : *slots) {
+                if (slot.holder)
+                    table[slot.name] = slot.holder.get();
+            }
+        }
+        return table;
     }
     
+    // replaced tables, which are not deleted yet
+    static std::size_t nbRetired(DIContainer& di) noexcept {
+        std::lock_guard<std::mutex> lock(di._writer);
+        return di._retired.size();
+    }
+
+    // a lookup, which keeps tables, that it may read, until it's reset
+    using Lookup = std::unique_ptr<DIContainer::Lookup>;
+
+    static Lookup lookup(const DIContainer& di) noexcept {
+        return Lookup(new DIContainer::Lookup(di));
+    }
+
+    // slots of lookups, which were taken at once at most
+    static std::size_t nbSlots(const DIContainer& di) noexcept {
+        std::size_t nbSlots = 0;
+        for (const DIContainer::LookupSlot* slot = di._slots.load(); slot; slot = slot->next)
+            ++nbSlots;
+        return nbSlots;
+    }
+
     template <typename Service>
     static Service* getEntry(DIContainer& di) noexcept {
-        return static_cast<DIContainer::ServiceHolder<Service>*>(table(di)[Service::sServiceName].get())->pService.get();
+        return static_cast<DIContainer::ServiceHolder<Service>*>(table(di)[Service::sServiceName])->pService.get();
     }
 };
 
@@ -82,6 +135,70 @@ namespace {
     };
     
     
+    // many services, so the table has to grow and probe
+    constexpr const char* sNumberedNames[] = {
+        "Numbered0", "Numbered1", "Numbered2", "Numbered3", "Numbered4", "Numbered5",
+        "Numbered6", "Numbered7", "Numbered8", "Numbered9", "Numbered10", "Numbered11",
+        "Numbered12", "Numbered13", "Numbered14", "Numbered15", "Numbered16", "Numbered17"
+    };
+
+    template <int N>
+    class NumberedService {
+    public:
+        constexpr static const char* sServiceName = sNumberedNames[N];
+
+        explicit NumberedService(int n) noexcept : number(n) {}
+
+        int number;
+    };
+    
+    
+    class CountedService {
+    public:
+        constexpr static const char* sServiceName = "CountedService";
+
+        virtual ~CountedService() noexcept {}
+
+        virtual int value() const noexcept = 0;
+    };
+
+    class CountedServiceImpl : public CountedService {
+    public:
+        explicit CountedServiceImpl(int v) noexcept : _value(v) { ++sNbMade; }
+        ~CountedServiceImpl() noexcept override { ++sNbDestroyed; }
+
+        int value() const noexcept override { return _value; }
+
+        static std::atomic<int> sNbMade, sNbDestroyed;
+
+    private:
+        int _value;
+    };
+
+    std::atomic<int> CountedServiceImpl::sNbMade(0);
+    std::atomic<int> CountedServiceImpl::sNbDestroyed(0);
+
+
+    // lazy services, each of which looks up the previous one, when it's
+    // made, so their lookups are nested
+    constexpr const char* sChainedNames[] = { "Chained0", "Chained1", "Chained2", "Chained3" };
+
+    template <int N>
+    class ChainedService {
+    public:
+        constexpr static const char* sServiceName = sChainedNames[N];
+
+        explicit ChainedService(const fontomas::DIContainer* di) noexcept : depth(0) {
+            if constexpr (N > 0) {
+                const ChainedService<N - 1>* previous = di->getService<ChainedService<N - 1>>();
+                depth = previous ? previous->depth + 1 : 0;
+            }
+        }
+
+        int depth;
+    };
+    
+    
     class ServicesUser1 {
     public:
         using Ptr = std::unique_ptr<ServicesUser1>;
@@ -104,7 +221,7 @@ bool test__di__dicontainer_registerservice() {
     DIContainer dicontainer;
     dicontainer.registerService<TestService1, TestService1MocA>();
 
-    auto& table = DITester::table(dicontainer);
+    auto table = DITester::table(dicontainer);
     fontomas__check_equal(table.size(), 1);
     fontomas__check_contains(table, TestService1::sServiceName);
     fontomas__check_notnull(table, TestService1::sServiceName);
@@ -113,6 +230,7 @@ bool test__di__dicontainer_registerservice() {
     fontomas__check_equal(DITester::getEntry<TestService1>(dicontainer)->getClassName(), "TestService1MocA");
     
     dicontainer.registerService<TestService1, TestService1MocB>();
+    table = DITester::table(dicontainer);
     fontomas__check_equal(table.size(), 1);
     fontomas__check_contains(table, TestService1::sServiceName);
     fontomas__check_notnull(table, TestService1::sServiceName);
@@ -121,6 +239,7 @@ bool test__di__dicontainer_registerservice() {
     fontomas__check_equal(DITester::getEntry<TestService1>(dicontainer)->getClassName(), "TestService1MocB");
     
     dicontainer.registerService<TestService2, TestService2MocA>();
+    table = DITester::table(dicontainer);
     fontomas__check_equal(table.size(), 2);
     fontomas__check_contains(table, TestService1::sServiceName);
     fontomas__check_notnull(table, TestService1::sServiceName);
@@ -134,6 +253,7 @@ bool test__di__dicontainer_registerservice() {
     fontomas__check_equal(DITester::getEntry<TestService2>(dicontainer)->getClassName(), "TestService2MocA");
     
     dicontainer.registerService<TestService2, TestService2MocB>();
+    table = DITester::table(dicontainer);
     fontomas__check_equal(table.size(), 2);
     fontomas__check_contains(table, TestService1::sServiceName);
     fontomas__check_notnull(table, TestService1::sServiceName);
@@ -207,3 +327,497 @@ bool test__di__dicontainer_resolve() {
     
     return true;
 }
+
+
+bool test__di__dicontainer_getservice() {
+    using namespace fontomas;
+
+    DIContainer dicontainer;
+    const DIContainer& view = dicontainer;
+
+    fontomas__check_equal(view.getService<TestService1>(), nullptr);
+
+    dicontainer.registerService<TestService1, TestService1MocA>();
+    fontomas__check_notequal(view.getService<TestService1>(), nullptr);
+    fontomas__check_equal(view.getService<TestService1>()->getClassName(), "TestService1MocA");
+    fontomas__check_equal(view.getService<TestService2>(), nullptr);
+
+    // it's the same service, which is shared, but its owners aren't counted
+    std::shared_ptr<TestService1> shared = dicontainer.resolveService<TestService1>();
+    fontomas__check_equal(view.getService<TestService1>(), shared.get());
+    fontomas__check_equal(shared.use_count(), 2);
+    view.getService<TestService1>()->doSomething();
+    fontomas__check_equal(shared.use_count(), 2);
+
+    dicontainer.registerService<TestService2, TestService2MocB>();
+    dicontainer.registerService<TestService1, TestService1MocB>();
+    fontomas__check_equal(view.getService<TestService1>()->getClassName(), "TestService1MocB");
+    fontomas__check_equal(view.getService<TestService2>()->getClassName(), "TestService2MocB");
+
+    // a replaced service lives while it's shared
+    fontomas__check_equal(shared->getClassName(), "TestService1MocA");
+    fontomas__check_equal(shared.use_count(), 1);
+
+    // containers don't share services
+    DIContainer other;
+    fontomas__check_equal(other.getService<TestService1>(), nullptr);
+    fontomas__check_equal(other.resolveService<TestService2>().get(), nullptr);
+
+    return true;
+}
+
+
+bool test__di__dicontainer_concurrent() {
+    using namespace fontomas;
+
+    static constexpr int sNbReaders = 8;
+    static constexpr int sNbRegistrations = 2000;
+
+    DIContainer dicontainer(DIContainer::eConcurrent);
+    dicontainer.registerService<TestService1, TestService1MocA>();
+
+    std::atomic<bool> done(false), failed(false);
+    std::atomic<int> nbReady(0);
+
+    // a service, which was seen once, is never lost, and each lookup gives
+    // one of the registered implementations
+    auto read = [&]() {
+        ++nbReady;
+
+        bool seen2 = false;
+        while (!done && !failed) {
+            TestService1* pService1 = dicontainer.getService<TestService1>();
+            if (!pService1 || (std::strcmp(pService1->getClassName(), "TestService1MocA")
+                               && std::strcmp(pService1->getClassName(), "TestService1MocB")))
+                failed = true;
+
+            std::shared_ptr<TestService2> pService2 = dicontainer.resolveService<TestService2>();
+            if (seen2 && !pService2)
+                failed = true;
+            if (pService2) {
+                seen2 = true;
+                if (std::strcmp(pService2->getClassName(), "TestService2MocA")
+                    && std::strcmp(pService2->getClassName(), "TestService2MocB"))
+                    failed = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < sNbReaders; ++i)
+        readers.emplace_back(read);
+    while (nbReady < sNbReaders)
+        std::this_thread::yield();
+
+    for (int i = 0; i < sNbRegistrations && !failed; ++i) {
+        if (i % 2)
+            dicontainer.registerService<TestService1, TestService1MocA>();
+        else
+            dicontainer.registerService<TestService1, TestService1MocB>();
+
+        if (i % 3)
+            dicontainer.registerService<TestService2, TestService2MocA>();
+        else
+            dicontainer.registerService<TestService2, TestService2MocB>();
+    }
+
+    done = true;
+    for (std::thread& t : readers)
+        t.join();
+
+    fontomas__check_false(failed);
+    fontomas__check_equal(DITester::table(dicontainer).size(), 2);
+    fontomas__check_equal(dicontainer.getService<TestService1>()->getClassName(), "TestService1MocA");
+    fontomas__check_equal(dicontainer.getService<TestService2>()->getClassName(), "TestService2MocA");
+
+    // no one looks services up, so replaced tables are deleted by the next
+    // registration, while replaced services are kept
+    TestService1* pService1 = dicontainer.getService<TestService1>();
+    dicontainer.registerService<TestService1, TestService1MocB>();
+    fontomas__check_equal(DITester::nbRetired(dicontainer), 0);
+    fontomas__check_equal(pService1->getClassName(), "TestService1MocA");
+
+    return true;
+}
+
+
+bool test__di__dicontainer_reclaim() {
+    using namespace fontomas;
+
+    static constexpr int sNbReaders = 4;
+    static constexpr int sNbRegistrations = 500;
+
+    DIContainer dicontainer(DIContainer::eConcurrent);
+    dicontainer.registerService<TestService1, TestService1MocA>();
+
+    std::atomic<bool> done(false), failed(false);
+    std::atomic<int> nbReady(0);
+
+    auto read = [&]() {
+        ++nbReady;
+        while (!done && !failed) {
+            if (!dicontainer.getService<TestService1>())
+                failed = true;
+        }
+    };
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < sNbReaders; ++i)
+        readers.emplace_back(read);
+    while (nbReady < sNbReaders)
+        std::this_thread::yield();
+
+    // lookups overlap, so there is always one in progress; each of them
+    // only keeps tables, which were replaced after it started
+    DITester::Lookup held = DITester::lookup(dicontainer);
+    for (int i = 0; i < sNbRegistrations && !failed; ++i) {
+        DITester::Lookup next = DITester::lookup(dicontainer);
+        held = std::move(next);
+
+        if (i % 2)
+            dicontainer.registerService<TestService1, TestService1MocA>();
+        else
+            dicontainer.registerService<TestService1, TestService1MocB>();
+    }
+
+    done = true;
+    for (std::thread& t : readers)
+        t.join();
+
+    fontomas__check_false(failed);
+
+    DITester::Lookup next = DITester::lookup(dicontainer);
+    held = std::move(next);
+    dicontainer.registerService<TestService1, TestService1MocB>();
+    fontomas__check_equal(DITester::nbRetired(dicontainer), 1);
+
+    held.reset();
+    dicontainer.registerService<TestService1, TestService1MocA>();
+    fontomas__check_equal(DITester::nbRetired(dicontainer), 0);
+    fontomas__check_equal(dicontainer.getService<TestService1>()->getClassName(), "TestService1MocA");
+
+    return true;
+}
+
+
+bool test__di__dicontainer_nested() {
+    using namespace fontomas;
+
+    // more than any fixed number of slots would let in at once
+    static constexpr int sNbThreads = 96;
+    static constexpr int sNbHeld = 200;
+    static constexpr int sNbRegistrations = 200;
+
+    DIContainer dicontainer(DIContainer::eConcurrent);
+
+    // lookups, which are held at once, take a slot each instead of waiting,
+    // and later lookups take the slots again
+    {
+        std::vector<DITester::Lookup> held;
+        for (int i = 0; i < sNbHeld; ++i)
+            held.push_back(DITester::lookup(dicontainer));
+        fontomas__check_equal(DITester::nbSlots(dicontainer), sNbHeld);
+    }
+    fontomas__check_equal(dicontainer.getService<TestService1>(), nullptr);
+    fontomas__check_equal(DITester::nbSlots(dicontainer), sNbHeld);
+
+    dicontainer.registerLazyService<ChainedService<0>, ChainedService<0>>(&dicontainer);
+    dicontainer.registerLazyService<ChainedService<1>, ChainedService<1>>(&dicontainer);
+    dicontainer.registerLazyService<ChainedService<2>, ChainedService<2>>(&dicontainer);
+    dicontainer.registerLazyService<ChainedService<3>, ChainedService<3>>(&dicontainer);
+    dicontainer.registerService<TestService1, TestService1MocA>();
+
+    std::atomic<bool> go(false), done(false), failed(false);
+    std::atomic<int> nbReady(0);
+
+    // all threads make the chain at once, so they wait for each other in
+    // lazy services, while their lookups are in progress
+    auto read = [&]() {
+        ++nbReady;
+        while (!go)
+            std::this_thread::yield();
+
+        while (!done && !failed) {
+            const ChainedService<3>* last = dicontainer.getService<ChainedService<3>>();
+            if (!last || 3 != last->depth || !dicontainer.resolveService<TestService1>())
+                failed = true;
+        }
+    };
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < sNbThreads; ++i)
+        readers.emplace_back(read);
+    while (nbReady < sNbThreads)
+        std::this_thread::yield();
+    go = true;
+
+    for (int i = 0; i < sNbRegistrations && !failed; ++i) {
+        if (i % 2)
+            dicontainer.registerService<TestService1, TestService1MocA>();
+        else
+            dicontainer.registerService<TestService1, TestService1MocB>();
+    }
+
+    done = true;
+    for (std::thread& t : readers)
+        t.join();
+
+    fontomas__check_false(failed);
+    fontomas__check_equal(dicontainer.getService<ChainedService<3>>()->depth, 3);
+
+    dicontainer.registerService<TestService1, TestService1MocA>();
+    fontomas__check_equal(DITester::nbRetired(dicontainer), 0);
+
+    return true;
+}
+
+
+namespace {
+
+    template <int... Ns>
+    void register_numbered(fontomas::DIContainer& di, std::integer_sequence<int, Ns...>) {
+        (di.registerService<NumberedService<Ns>, NumberedService<Ns>>(Ns), ...);
+    }
+
+    template <int... Ns>
+    bool check_numbered(const fontomas::DIContainer& di, std::integer_sequence<int, Ns...>) {
+        return ((di.getService<NumberedService<Ns>>() && Ns == di.getService<NumberedService<Ns>>()->number) && ...);
+    }
+
+}
+
+
+bool test__di__dicontainer_serviceid() {
+    using namespace fontomas;
+
+    // ids are known at compile time and depend on the content of names only
+    static_assert(service_id(TestService1::sServiceName) == service_id("TestService1"), "");
+    static_assert(service_id("TestService1") != service_id("TestService2"), "");
+    static_assert(0 != service_id(""), "");
+
+    char copy[] = "TestService1";
+    fontomas__check_equal(service_id(copy), service_id(TestService1::sServiceName));
+    fontomas__check_equal(service_id(""), 0xCBF29CE484222325ull);
+    fontomas__check_equal(service_id("a"), 0xAF63DC4C8601EC8Cull);
+
+    DIContainer dicontainer;
+    using Numbers = std::make_integer_sequence<int, CountOf(sNumberedNames)>;
+    register_numbered(dicontainer, Numbers());
+    dicontainer.registerService<TestService1, TestService1MocA>();
+
+    fontomas__check_equal(DITester::table(dicontainer).size(), CountOf(sNumberedNames) + 1);
+    fontomas__check_true(check_numbered(dicontainer, Numbers()));
+    fontomas__check_equal(dicontainer.getService<TestService1>()->getClassName(), "TestService1MocA");
+    fontomas__check_equal(dicontainer.getService<TestService2>(), nullptr);
+
+    // replacing keeps others in place
+    dicontainer.registerService<NumberedService<3>, NumberedService<3>>(33);
+    fontomas__check_equal(dicontainer.getService<NumberedService<3>>()->number, 33);
+    fontomas__check_equal(dicontainer.getService<NumberedService<4>>()->number, 4);
+    fontomas__check_equal(DITester::table(dicontainer).size(), CountOf(sNumberedNames) + 1);
+
+    return true;
+}
+
+
+bool test__di__dicontainer_lazy() {
+    using namespace fontomas;
+
+    static constexpr int sNbThreads = 8;
+
+    CountedServiceImpl::sNbMade = CountedServiceImpl::sNbDestroyed = 0;
+    {
+        DIContainer dicontainer(DIContainer::eConcurrent);
+        dicontainer.registerLazyService<CountedService, CountedServiceImpl>(7);
+        dicontainer.registerService<TestService1, TestService1MocA>();
+        fontomas__check_equal(CountedServiceImpl::sNbMade, 0);
+
+        // many threads ask for it at once, but it's made once
+        std::atomic<bool> go(false);
+        std::vector<CountedService*> found(sNbThreads, nullptr);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < sNbThreads; ++t) {
+            threads.emplace_back([&, t]() {
+                while (!go)
+                    std::this_thread::yield();
+                found[t] = t % 2 ? dicontainer.getService<CountedService>()
+                                 : dicontainer.resolveService<CountedService>().get();
+            });
+        }
+        go = true;
+        for (std::thread& t : threads)
+            t.join();
+
+        fontomas__check_equal(CountedServiceImpl::sNbMade, 1);
+        fontomas__check_notequal(found[0], nullptr);
+        for (CountedService* service : found)
+            fontomas__check_equal(service, found[0]);
+        fontomas__check_equal(found[0]->value(), 7);
+
+        // it's shared like other services
+        std::shared_ptr<CountedService> shared = dicontainer.resolveService<CountedService>();
+        fontomas__check_equal(shared.get(), found[0]);
+        fontomas__check_equal(CountedServiceImpl::sNbMade, 1);
+
+        // a replaced lazy service, which was never looked up, is never made
+        dicontainer.registerLazyService<CountedService, CountedServiceImpl>(8);
+        dicontainer.registerLazyService<CountedService, CountedServiceImpl>(9);
+        fontomas__check_equal(CountedServiceImpl::sNbMade, 1);
+        fontomas__check_equal(dicontainer.getService<CountedService>()->value(), 9);
+        fontomas__check_equal(CountedServiceImpl::sNbMade, 2);
+    }
+    fontomas__check_equal(CountedServiceImpl::sNbDestroyed, 2);
+
+    return true;
+}
+
+
+bool test__di__dicontainer_scoped() {
+    using namespace fontomas;
+
+    CountedServiceImpl::sNbMade = CountedServiceImpl::sNbDestroyed = 0;
+
+    DIContainer dicontainer;
+    dicontainer.registerScopedService<CountedService, CountedServiceImpl>(5);
+    dicontainer.registerService<TestService1, TestService1MocA>();
+
+    // scoped services live in scopes only
+    fontomas__check_equal(dicontainer.getService<CountedService>(), nullptr);
+    fontomas__check_equal(dicontainer.resolveService<CountedService>().get(), nullptr);
+
+    {
+        DIContainer::Scope job1(dicontainer);
+        DIContainer::Scope job2(dicontainer);
+        fontomas__check_equal(CountedServiceImpl::sNbMade, 0);
+
+        CountedService* service1 = job1.getService<CountedService>();
+        fontomas__check_notequal(service1, nullptr);
+        fontomas__check_equal(service1->value(), 5);
+        fontomas__check_equal(job1.getService<CountedService>(), service1);
+        fontomas__check_equal(job1.resolveService<CountedService>().get(), service1);
+        fontomas__check_equal(CountedServiceImpl::sNbMade, 1);
+
+        CountedService* service2 = job2.getService<CountedService>();
+        fontomas__check_notequal(service2, nullptr);
+        fontomas__check_notequal(service2, service1);
+        fontomas__check_equal(CountedServiceImpl::sNbMade, 2);
+
+        // others are taken from the container
+        fontomas__check_equal(job1.getService<TestService1>(), dicontainer.getService<TestService1>());
+        fontomas__check_equal(job2.resolveService<TestService2>().get(), nullptr);
+
+        // a scope keeps the registration, which it was made with
+        dicontainer.registerScopedService<CountedService, CountedServiceImpl>(6);
+        DIContainer::Scope job3(dicontainer);
+        fontomas__check_equal(job3.getService<CountedService>()->value(), 6);
+        fontomas__check_equal(job1.getService<CountedService>()->value(), 5);
+
+        std::shared_ptr<CountedService> kept;
+        {
+            DIContainer::Scope job4(dicontainer);
+            kept = job4.resolveService<CountedService>();
+            job4.getService<CountedService>();
+        }
+        fontomas__check_equal(CountedServiceImpl::sNbDestroyed, 0);
+        fontomas__check_equal(kept->value(), 6);
+    }
+    fontomas__check_equal(CountedServiceImpl::sNbMade, 4);
+    fontomas__check_equal(CountedServiceImpl::sNbDestroyed, 4);
+
+    return true;
+}
+
+
+fontomas__provide_as_shared(TestService1, TestService1MocB)
+fomtomas__provide_as_local(TestService2)
+
+
+namespace {
+
+    struct InjectedUser {
+        fontomas__inject(TestService1, service1);
+        fontomas__inject(TestService2, service2);
+    };
+
+}
+
+
+bool test__di__inject_macros() {
+    using namespace fontomas;
+
+    static constexpr int sNbThreads = 8;
+    static constexpr int sNbObjects = 1000;
+
+    // making an object with injected fields costs nothing
+    static_assert(std::is_empty<fontomas_client::TestService1DI::Factory>::value, "");
+    static_assert(std::is_trivially_default_constructible<InjectedUser>::value, "");
+
+    TestService2MocA local;
+    fontomas__provide(TestService2, &local);
+
+    std::atomic<bool> go(false), failed(false);
+    std::vector<TestService1*> found(sNbThreads, nullptr);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < sNbThreads; ++t) {
+        threads.emplace_back([&, t]() {
+            while (!go)
+                std::this_thread::yield();
+            for (int i = 0; i < sNbObjects; ++i) {
+                InjectedUser user;
+                TestService1* service1 = user.service1.operator ->();
+                if (found[t] && found[t] != service1)
+                    failed = true;
+                found[t] = service1;
+                if (user.service2.operator ->() != &local)
+                    failed = true;
+            }
+        });
+    }
+    go = true;
+    for (std::thread& t : threads)
+        t.join();
+
+    fontomas__check_false(failed);
+    for (TestService1* service : found)
+        fontomas__check_equal(service, fontomas_client::TestService1DI::Factory::sObject.get());
+
+    InjectedUser user;
+    fontomas__check_equal(user.service1->getClassName(), "TestService1MocB");
+    fontomas__check_equal(user.service2->getClassName(), "TestService2MocA");
+
+    return true;
+}
+
+
+bool test__di__injected() {
+    using namespace fontomas;
+
+    DIContainer dicontainer(DIContainer::eConcurrent);
+
+    Injected<TestService1> service1(dicontainer);
+    Injected<CountedService> counted(dicontainer);
+
+    // not found isn't cached, so it's found once it's registered
+    fontomas__check_false(service1);
+    dicontainer.registerService<TestService1, TestService1MocA>();
+    fontomas__check_true(service1);
+    fontomas__check_equal(service1->getClassName(), "TestService1MocA");
+
+    // a found service is cached, so the object and its copies keep it
+    Injected<TestService1> copy = service1;
+    dicontainer.registerService<TestService1, TestService1MocB>();
+    fontomas__check_equal(service1->getClassName(), "TestService1MocA");
+    fontomas__check_equal(copy->getClassName(), "TestService1MocA");
+    fontomas__check_equal(Injected<TestService1>(dicontainer)->getClassName(), "TestService1MocB");
+
+    // lazy services are made on the first use, not by the object
+    CountedServiceImpl::sNbMade = 0;
+    dicontainer.registerLazyService<CountedService, CountedServiceImpl>(3);
+    Injected<CountedService> lazy(dicontainer);
+    fontomas__check_equal(CountedServiceImpl::sNbMade, 0);
+    fontomas__check_equal(lazy->value(), 3);
+    fontomas__check_equal(counted.get(), lazy.get());
+    fontomas__check_equal(CountedServiceImpl::sNbMade, 1);
+
+    return true;
+}
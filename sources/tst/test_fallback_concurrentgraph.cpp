@@ -0,0 +1,190 @@
+#include "fontomas/fallback/concurrentgraph.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "testers.h"
+#include "testsglobals.h"
+
+
+bool test__fallback__concurrentgraph_publish();
+bool test__fallback__concurrentgraph_readers();
+bool test__fallback__concurrentgraph_stress();
+
+
+fontomas__tests_suit_begin(FallbackConcurrentGraph)
+    fontomas__test(test__fallback__concurrentgraph_publish),
+    fontomas__test(test__fallback__concurrentgraph_readers),
+    fontomas__test(test__fallback__concurrentgraph_stress)
+fontomas__tests_suit_end(FallbackConcurrentGraph);
+
+
+bool test__fallback__concurrentgraph_publish() {
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    ConcurrentGraph g;
+    ConcurrentGraph::Reader reader = g.reader();
+    fontomas__check_true(reader.valid());
+    fontomas__check_true(reader.pin().graph().empty());
+
+    fontomas__check_equal(g.addNode(0, 0), Graph::eOk);
+    fontomas__check_equal(g.addNode(1, 0), Graph::eOk);
+    fontomas__check_equal(g.addRoute(0, 1, 0), Graph::eOk);
+    fontomas__check_equal(g.addRoute(1, 0, 0), Graph::eNotAllowed);
+
+    // changes are not visible until they are published
+    fontomas__check_true(reader.pin().graph().empty());
+    g.publish();
+    fontomas__check_equal(reader.pin().fallbacks(0, 0).size(), 1);
+
+    // a pinned version lives until it is unpinned
+    {
+        ConcurrentGraph::Snapshot snapshot = reader.pin();
+
+        Graph::Route routes[] = { {1, 2, 0}, {0, 2, 1} };
+        fontomas__check_equal(g.addNode(2, 0), Graph::eOk);
+        fontomas__check_equal(g.addRoutes(span_t<const Graph::Route>(routes, 2)), Graph::eOk);
+        g.publish();
+        g.publish();
+
+        fontomas__check_equal(Tester::nbRetired(g), 2);
+        fontomas__check_equal(snapshot.fallbacks(1, 0).size(), 0);
+        fontomas__check_equal(snapshot.fallbacks(0, 1).size(), 0);
+    }
+
+    fontomas__check_equal(reader.pin().fallbacks(1, 0).size(), 1);
+    fontomas__check_equal(reader.pin().fallbacks(0, 1).size(), 1);
+
+    g.publish();
+    fontomas__check_equal(Tester::nbRetired(g), 0);
+
+    // nested snapshots are protected, until the last of them is gone
+    {
+        ConcurrentGraph::Snapshot outer = reader.pin();
+        {
+            ConcurrentGraph::Snapshot inner = reader.pin();
+            g.publish();
+            fontomas__check_equal(inner.fallbacks(1, 0).size(), 1);
+        }
+        g.publish();
+
+        fontomas__check_equal(Tester::nbRetired(g), 2);
+        fontomas__check_equal(outer.fallbacks(1, 0).size(), 1);
+    }
+    g.publish();
+    fontomas__check_equal(Tester::nbRetired(g), 0);
+
+    // removals are published like additions
+    fontomas__check_equal(g.removeRoute(0, 1, 0), Graph::eOk);
+    fontomas__check_equal(g.removeNode(2), Graph::eOk);
+    fontomas__check_equal(g.detachTag(0, 1), Graph::eOk);
+    fontomas__check_true(g.compactStep(16));
+    fontomas__check_equal(reader.pin().fallbacks(0, 0).size(), 1);
+    g.publish();
+    fontomas__check_equal(reader.pin().fallbacks(0, 0).size(), 0);
+    fontomas__check_equal(reader.pin().fallbacks(1, 0).size(), 0);
+    fontomas__check_equal(reader.pin().fallbacks(0, 1).size(), 0);
+
+    return true;
+}
+
+
+bool test__fallback__concurrentgraph_readers() {
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    ConcurrentGraph g(2);
+
+    {
+        ConcurrentGraph::Reader a = g.reader();
+        ConcurrentGraph::Reader b = g.reader();
+        fontomas__check_true(a.valid() && b.valid());
+        fontomas__check_false(g.reader().valid());
+
+        // an invalid reader pins nothing
+        ConcurrentGraph::Snapshot none = g.reader().pin();
+        fontomas__check_false(none.valid());
+        fontomas__check_equal(none.fallbacks(0, 0).size(), 0);
+        fontomas__check_true(a.pin().valid());
+
+        ConcurrentGraph::Reader moved = std::move(a);
+        fontomas__check_false(a.valid());
+        fontomas__check_true(moved.valid());
+        fontomas__check_false(g.reader().valid());
+    }
+
+    // slots of gone readers are taken again
+    ConcurrentGraph::Reader c = g.reader();
+    ConcurrentGraph::Reader d = g.reader();
+    fontomas__check_true(c.valid() && d.valid());
+
+    return true;
+}
+
+
+bool test__fallback__concurrentgraph_stress() {
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    static constexpr nodeid_t sNbNodes = 1500;
+    static constexpr int sNbReaders = 8;
+
+    ConcurrentGraph g;
+    g.addNode(0, 0);
+    g.publish();
+
+    std::atomic<bool> done(false), failed(false);
+    std::atomic<int> nbReady(0);
+
+    // the writer makes a path n -> n - 1, so each version has to be a whole
+    // path from the last node down to 0
+    auto read = [&]() {
+        ConcurrentGraph::Reader reader = g.reader();
+        if (!reader.valid())
+            failed = true;
+        ++nbReady;
+
+        while (!done && !failed) {
+            ConcurrentGraph::Snapshot snapshot = reader.pin();
+
+            nodeid_t last = 0;
+            while (snapshot.fallbacks(nodeid_t(last + 1), 0).size() > 0)
+                ++last;
+
+            for (nodeid_t n = 1; n <= last; ++n) {
+                span_t<const nodeid_t> fallbacks = snapshot.fallbacks(n, 0);
+                if (1 != fallbacks.size() || n - 1 != fallbacks[0])
+                    failed = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < sNbReaders; ++i)
+        readers.emplace_back(read);
+    while (nbReady < sNbReaders)
+        std::this_thread::yield();
+
+    for (nodeid_t n = 1; n < sNbNodes && !failed; ++n) {
+        g.addNode(n, 0);
+        g.addRoute(n, nodeid_t(n - 1), 0);
+        g.publish();
+    }
+
+    done = true;
+    for (std::thread& t : readers)
+        t.join();
+
+    fontomas__check_false(failed);
+
+    g.publish();
+    fontomas__check_equal(Tester::nbRetired(g), 0);
+    fontomas__check_equal(g.reader().pin().fallbacks(sNbNodes - 1, 0).size(), 1);
+
+    return true;
+}
+
+
+// tst/test_fallback_concurrentgraph.cpp
@@ -0,0 +1,140 @@
+#include "fontomas/fallback/coverage.h"
+
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "testsglobals.h"
+
+
+bool test__fallback__coverage_add();
+bool test__fallback__coverage_random();
+bool test__fallback__coverage_memory();
+
+
+fontomas__tests_suit_begin(FallbackCoverage)
+    fontomas__test(test__fallback__coverage_add),
+    fontomas__test(test__fallback__coverage_random),
+    fontomas__test(test__fallback__coverage_memory)
+fontomas__tests_suit_end(FallbackCoverage);
+
+
+bool test__fallback__coverage_add() {
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    Coverage c;
+    fontomas__check_true(c.empty());
+    fontomas__check_false(c.covers(0));
+    fontomas__check_false(c.covers(Coverage::sMaxCodepoint));
+    fontomas__check_false(c.covers(0xFFFFFFFF));
+
+    // basic latin and a piece of cyrillic
+    fontomas__check_true(c.add(0x20, 0x7E));
+    fontomas__check_true(c.add(0x410, 0x44F));
+    fontomas__check_true(c.add(0x401));
+    fontomas__check_false(c.empty());
+
+    fontomas__check_false(c.covers(0x1F));
+    fontomas__check_true(c.covers(0x20));
+    fontomas__check_true(c.covers(0x41));
+    fontomas__check_true(c.covers(0x7E));
+    fontomas__check_false(c.covers(0x7F));
+    fontomas__check_false(c.covers(0x400));
+    fontomas__check_true(c.covers(0x401));
+    fontomas__check_false(c.covers(0x402));
+    fontomas__check_true(c.covers(0x44F));
+    fontomas__check_false(c.covers(0x450));
+    fontomas__check_false(c.covers(0x4E00));
+
+    // ranges, which cross blocks, and the ends of unicode
+    fontomas__check_true(c.add(0x4E00, 0x9FFF));
+    fontomas__check_true(c.covers(0x4E00) && c.covers(0x4EFF) && c.covers(0x4F00) && c.covers(0x9FFF));
+    fontomas__check_false(c.covers(0x4DFF) || c.covers(0xA000));
+    fontomas__check_true(c.add(Coverage::sMaxCodepoint));
+    fontomas__check_true(c.covers(Coverage::sMaxCodepoint));
+    fontomas__check_false(c.covers(Coverage::sMaxCodepoint - 1));
+    fontomas__check_true(c.add(0));
+    fontomas__check_true(c.covers(0));
+
+    // wrong ranges are not added
+    fontomas__check_false(c.add(0x100, 0xFF));
+    fontomas__check_false(c.add(0x10FFF0, 0x110000));
+    fontomas__check_false(c.covers(0x10FFF0));
+
+    // a whole block, which was covered partly before
+    fontomas__check_true(c.add(0x400, 0x4FF));
+    fontomas__check_true(c.covers(0x400) && c.covers(0x450) && c.covers(0x4FF));
+
+    // moves
+    Coverage moved(std::move(c));
+    fontomas__check_true(c.empty());
+    fontomas__check_false(c.covers(0x41));
+    fontomas__check_true(moved.covers(0x41));
+
+    c = std::move(moved);
+    fontomas__check_true(c.covers(0x9FFF));
+    fontomas__check_true(moved.empty());
+
+    return true;
+}
+
+
+bool test__fallback__coverage_random() {
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    static constexpr codepoint_t sRange = 0x3000;
+
+    std::mt19937 rng(17);
+    for (int round = 0; round < 20; ++round) {
+        Coverage c;
+        std::vector<bool> expected(sRange, false);
+
+        for (int i = 0; i < 40; ++i) {
+            const codepoint_t first = rng() % sRange;
+            const codepoint_t last = std::min<codepoint_t>(sRange - 1, first + rng() % (0 == i % 4 ? 600 : 8));
+            fontomas__check_true(c.add(first, last));
+            for (codepoint_t cp = first; cp <= last; ++cp)
+                expected[cp] = true;
+        }
+
+        if (0 == round % 2)
+            c.shrink_to_fit();
+
+        for (codepoint_t cp = 0; cp < sRange + 300; ++cp)
+            fontomas__check_equal(c.covers(cp), cp < sRange && expected[cp]);
+    }
+
+    return true;
+}
+
+
+bool test__fallback__coverage_memory() {
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    HeapAllocator heap;
+
+    {
+        // whole blocks take no bits
+        Coverage c(heap);
+        fontomas__check_true(c.add(0x4E00, 0x9FFF));
+        c.shrink_to_fit();
+        fontomas__check_equal(c.memory().reserved, sizeof(uint16_t) * (0x9F + 1));
+        fontomas__check_equal(c.memory().used, c.memory().reserved);
+        fontomas__check_equal(heap.stats().used, c.memory().reserved);
+
+        // a block, which is covered partly, takes a page of 256 bits
+        fontomas__check_true(c.add(0x41, 0x5A));
+        c.shrink_to_fit();
+        fontomas__check_equal(c.memory().reserved, sizeof(uint16_t) * (0x9F + 1) + 32);
+    }
+
+    fontomas__check_equal(heap.stats().used, std::size_t(0));
+
+    return true;
+}
+
+
+// tst/test_fallback_coverage.cpp
@@ -1,9 +1,15 @@
 #include "fontomas/fallback/consts.h"
 #include "fontomas/fallback/graph.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include <list>
 #include <limits>
+#include <map>
 #include <memory>
+#include <random>
+#include <vector>
 
 #include "testers.h"
 #include "testsglobals.h"
@@ -11,12 +17,46 @@
 
 bool test__fallback__graph_addnode();
 bool test__fallback__graph_addroute();
+bool test__fallback__graph_addroute_loops();
+bool test__fallback__graph_addroutes();
+bool test__fallback__graph_addroutes_parallel();
 bool test__fallback__graph_fallbacks();
+bool test__fallback__graph_fallbacks_for_tags();
+bool test__fallback__graph_fallbacks_batch();
+bool test__fallback__graph_freeze();
+bool test__fallback__graph_freeze_save();
+bool test__fallback__graph_chain();
+bool test__fallback__graph_cheapest();
+bool test__fallback__graph_first_covering();
+bool test__fallback__graph_deep();
+bool test__fallback__graph_allocators();
+bool test__fallback__graph_tags();
+bool test__fallback__graph_capacity();
+bool test__fallback__graph_remove();
+bool test__fallback__graph_remove_random();
+bool test__fallback__graph_widths();
 
 fontomas__tests_suit_begin(FallbackGraph)
     fontomas__test(test__fallback__graph_addnode),
     fontomas__test(test__fallback__graph_addroute),
+    fontomas__test(test__fallback__graph_addroute_loops),
+    fontomas__test(test__fallback__graph_addroutes),
+    fontomas__test(test__fallback__graph_addroutes_parallel),
     fontomas__test(test__fallback__graph_fallbacks),
+    fontomas__test(test__fallback__graph_fallbacks_for_tags),
+    fontomas__test(test__fallback__graph_fallbacks_batch),
+    fontomas__test(test__fallback__graph_freeze),
+    fontomas__test(test__fallback__graph_freeze_save),
+    fontomas__test(test__fallback__graph_chain),
+    fontomas__test(test__fallback__graph_cheapest),
+    fontomas__test(test__fallback__graph_first_covering),
+    fontomas__test(test__fallback__graph_deep),
+    fontomas__test(test__fallback__graph_allocators),
+    fontomas__test(test__fallback__graph_tags),
+    fontomas__test(test__fallback__graph_capacity),
+    fontomas__test(test__fallback__graph_remove),
+    fontomas__test(test__fallback__graph_remove_random),
+    fontomas__test(test__fallback__graph_widths),
 fontomas__tests_suit_end(FallbackGraph);
 
 
@@ -48,9 +88,15 @@ static fontomas::tagid_t sEtalonMatrix[7][7] = {
 #define graph_node(NodeId, TagId) \
     std::pair<nodeid_t, tagid_t>(NodeId, TagId)
 
+#define graph_isconsistent(GraphVar) \
+    fontomas::fallback::Tester::isConsistent((GraphVar))
+
 #define graph_hasroute(GraphVar, NodeId, FallbackId, TagId) \
     fontomas::fallback::Tester::hasRoute((GraphVar), (NodeId), (FallbackId), (TagId))
 
+#define graph_isordered(GraphVar) \
+    fontomas::fallback::Tester::isOrdered((GraphVar))
+
 
 bool test__fallback__graph_addnode() {
     using namespace fontomas;
@@ -175,6 +221,303 @@ bool test__fallback__graph_addroute() {
 }
 
 
+bool test__fallback__graph_addroute_loops() {
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    static constexpr nodeid_t sNbNodes = 64;
+    static constexpr tagid_t sNbTags = 3;
+    static constexpr int sNbRoutes = 512;
+
+    // bounds of orders start from the middle, or close to their limits, so
+    // orders are renumbered, before they wrap
+    for (bool nearLimits : { false, true }) {
+        Graph g;
+        for (nodeid_t n = 0; n < sNbNodes; ++n) {
+            fontomas__check_equal(g.addNode(n, n % sNbTags), Graph::eOk);
+        }
+        if (nearLimits)
+            Tester::setOrders(g, 3, std::numeric_limits<uint32_t>::max() - 3);
+
+        // random routes: a route makes a loop iff its node is already reachable
+        // from its fallback
+        for (int i = 0; i < sNbRoutes; ++i) {
+            nodeid_t from = std::rand() % sNbNodes;
+            nodeid_t to = std::rand() % sNbNodes;
+            tagid_t tag = std::rand() % sNbTags;
+
+            span_t<const nodeid_t> reachable = g.chain(to, tag);
+            bool looped = from == to || std::find(reachable.begin(), reachable.end(), from) != reachable.end();
+            bool exists = graph_hasroute(g, from, to, tag);
+
+            Graph::Result res = g.addRoute(from, to, tag);
+            if (looped) {
+                fontomas__check_equal(res, Graph::eNotAllowed);
+            } else if (exists) {
+                fontomas__check_equal(res, Graph::eExists);
+            } else {
+                fontomas__check_equal(res, Graph::eOk);
+            }
+
+            fontomas__check_true(graph_isordered(g));
+        }
+
+        if (nearLimits) {
+            // new nodes and tags take orders after renumbering too
+            fontomas__check_true(Tester::orders(g).first > 3);
+            fontomas__check_equal(g.addNode(sNbNodes, 0), Graph::eOk);
+            fontomas__check_equal(g.reserve(0, sNbTags, 1), Graph::eOk);
+            fontomas__check_equal(g.addRoute(sNbNodes, 0, sNbTags), Graph::eOk);
+            fontomas__check_equal(g.addRoute(0, sNbNodes, sNbTags), Graph::eNotAllowed);
+            fontomas__check_true(graph_isordered(g));
+        }
+    }
+
+    return true;
+}
+
+
+bool test__fallback__graph_addroutes() {
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    static const Graph::Route sRoutes[8] = {
+        Graph::Route{0, 1, 0},
+        Graph::Route{0, 2, 3},
+        Graph::Route{0, 3, 1},
+        Graph::Route{2, 3, 1},
+        Graph::Route{2, 5, 1},
+        Graph::Route{3, 5, 1},
+        Graph::Route{3, 4, 1},
+        Graph::Route{5, 4, 2}
+    };
+
+    Graph g;
+    bool ok = graph_init(g, graph_node(0, 0), graph_node(1, 0),
+                            graph_node(2, 1), graph_node(3, 1),
+                            graph_node(4, 2), graph_node(5, 2),
+                            graph_node(6, 10));
+    fontomas__check_equal(ok, true);
+
+    Graph::Result res = g.addRoutes(span_t<const Graph::Route>(sRoutes, CountOf(sRoutes)));
+    fontomas__check_equal(res, Graph::eOk);
+    fontomas__check_true(graph_isordered(g));
+
+    for (nodeid_t n = 0; n < 7; ++n) {
+        for (tagid_t t = 0; t < 10; ++t) {
+            std::list<nodeid_t> ref = testing::collect_all(sEtalonMatrix[n], (nodeid_t)7, t,
+                [n](nodeid_t v) -> bool { return n != v; }
+            );
+            span_t<const nodeid_t> view = g.fallbacks(n, t);
+            fontomas__check_equal(view.size(), ref.size());
+            fontomas__check_true(testing::equal_unordered(view.data(), ref));
+        }
+    }
+
+    // routes on loops, self routes, duplicates and unknown nodes are reported
+    static const Graph::Route sBadRoutes[8] = {
+        Graph::Route{1, 2, 4},
+        Graph::Route{2, 3, 4},
+        Graph::Route{3, 1, 4},
+        Graph::Route{3, 6, 4},
+        Graph::Route{6, 6, 4},
+        Graph::Route{9, 1, 4},
+        Graph::Route{1, 2, 4},
+        Graph::Route{4, 0, 1}
+    };
+    static const Graph::Result sExpected[8] = {
+        Graph::eOk, Graph::eOk, Graph::eNotAllowed, Graph::eOk,
+        Graph::eNotAllowed, Graph::eNotExists, Graph::eExists, Graph::eNotAllowed
+    };
+
+    Graph::Result results[8];
+    res = g.addRoutes(span_t<const Graph::Route>(sBadRoutes, CountOf(sBadRoutes)), results);
+    fontomas__check_equal(res, Graph::eNotAllowed);
+    for (std::size_t i = 0; i < CountOf(sExpected); ++i) {
+        fontomas__check_equal(results[i], sExpected[i]);
+    }
+    fontomas__check_true(graph_isordered(g));
+    fontomas__check_equal(g.chain(1, 4).size(), 3);
+
+    // a batch gives the same results as routes added one by one
+    static constexpr nodeid_t sNbNodes = 48;
+    static constexpr tagid_t sNbTags = 3;
+
+    std::vector<Graph::Route> routes(256);
+    for (Graph::Route& route : routes)
+        route = Graph::Route{nodeid_t(std::rand() % sNbNodes), nodeid_t(std::rand() % sNbNodes), tagid_t(std::rand() % sNbTags)};
+
+    Graph sequential, batched;
+    for (nodeid_t n = 0; n < sNbNodes; ++n) {
+        sequential.addNode(n, 0);
+        batched.addNode(n, 0);
+    }
+
+    std::vector<Graph::Result> batchedResults(routes.size());
+    batched.addRoutes(span_t<const Graph::Route>(routes.data(), routes.size()), batchedResults.data());
+    fontomas__check_true(graph_isordered(batched));
+
+    for (std::size_t i = 0; i < routes.size(); ++i) {
+        res = sequential.addRoute(routes[i].nodeId, routes[i].fallbackId, routes[i].tagId);
+        fontomas__check_equal(res, batchedResults[i]);
+    }
+
+    for (nodeid_t n = 0; n < sNbNodes; ++n) {
+        for (tagid_t t = 0; t < sNbTags; ++t) {
+            span_t<const nodeid_t> a = sequential.fallbacks(n, t);
+            span_t<const nodeid_t> b = batched.fallbacks(n, t);
+            fontomas__check_equal(a.size(), b.size());
+            fontomas__check_true(std::equal(a.begin(), a.end(), b.begin()));
+        }
+
+        // fallbacks of different tags are listed in the order of the table
+        for (uint64_t mask = 1; mask < (1u << sNbTags); ++mask) {
+            nodeid_t a[sNbNodes], b[sNbNodes];
+            const uint16_t nba = sequential.fallbacksForTags(n, span_t<const uint64_t>(&mask, 1), a, sNbNodes);
+            const uint16_t nbb = batched.fallbacksForTags(n, span_t<const uint64_t>(&mask, 1), b, sNbNodes);
+            fontomas__check_equal(nba, nbb);
+            fontomas__check_true(std::equal(a, a + nba, b));
+        }
+    }
+
+    // each batch takes orders for all nodes, which it renumbers, so small
+    // batches near the limit renumber the graph, before orders wrap
+    Graph renumbered;
+    for (nodeid_t n = 0; n < sNbNodes; ++n)
+        renumbered.addNode(n, 0);
+    Tester::setOrders(renumbered, 3, std::numeric_limits<uint32_t>::max() - 64);
+
+    for (std::size_t i = 0; i < routes.size(); i += 8) {
+        const std::size_t nbroutes = std::min<std::size_t>(8, routes.size() - i);
+        renumbered.addRoutes(span_t<const Graph::Route>(routes.data() + i, nbroutes), batchedResults.data() + i);
+        fontomas__check_true(graph_isordered(renumbered));
+    }
+    fontomas__check_true(Tester::orders(renumbered).second < std::numeric_limits<uint32_t>::max() - 64);
+
+    for (nodeid_t n = 0; n < sNbNodes; ++n) {
+        for (tagid_t t = 0; t < sNbTags; ++t) {
+            span_t<const nodeid_t> a = sequential.fallbacks(n, t);
+            span_t<const nodeid_t> b = renumbered.fallbacks(n, t);
+            fontomas__check_equal(a.size(), b.size());
+            fontomas__check_true(std::equal(a.begin(), a.end(), b.begin()));
+        }
+    }
+
+    return true;
+}
+
+
+bool test__fallback__graph_addroutes_parallel() {
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    static constexpr nodeid_t sNbNodes = 48;
+    static constexpr tagid_t sNbTags = 16;
+
+    std::mt19937 rng(18);
+    auto table = [&rng](std::size_t nbroutes) {
+        std::vector<Graph::Route> routes(nbroutes);
+        for (Graph::Route& route : routes) {
+            // a few routes are self ones, go to unknown nodes or have no tag
+            route = Graph::Route{nodeid_t(rng() % sNbNodes), nodeid_t(rng() % (sNbNodes + 2)), tagid_t(rng() % sNbTags)};
+            if (0 == rng() % 64)
+                route.tagId = sNotConnected;
+        }
+        return routes;
+    };
+
+    for (uint32_t nbThreads : { 1u, 3u, 8u }) {
+        // routes, which are added one by one, give the expected results
+        Graph sequential, parallel;
+        for (nodeid_t n = 0; n < sNbNodes; ++n) {
+            sequential.addNode(n, tagid_t(n % 2));
+            parallel.addNode(n, tagid_t(n % 2));
+        }
+
+        // the second table meets routes of the first one
+        for (std::size_t nbroutes : { 300, 600 }) {
+            const std::vector<Graph::Route> routes = table(nbroutes);
+            const span_t<const Graph::Route> view(routes.data(), routes.size());
+
+            std::vector<Graph::Result> results(routes.size());
+            const Graph::Result res = parallel.addRoutesParallel(view, nbThreads, results.data());
+
+            Graph::Result expected = Graph::eOk;
+            for (std::size_t i = 0; i < routes.size(); ++i) {
+                const Graph::Result added = sequential.addRoute(routes[i].nodeId, routes[i].fallbackId, routes[i].tagId);
+                fontomas__check_equal(results[i], added);
+                if (Graph::eOk == expected)
+                    expected = added;
+            }
+            fontomas__check_equal(res, expected);
+
+            fontomas__check_true(graph_isordered(parallel));
+            fontomas__check_true(Tester::isConsistent(parallel));
+
+            for (nodeid_t n = 0; n < sNbNodes; ++n) {
+                for (tagid_t t = 0; t < sNbTags; ++t) {
+                    span_t<const nodeid_t> a = sequential.fallbacks(n, t);
+                    span_t<const nodeid_t> b = parallel.fallbacks(n, t);
+                    fontomas__check_equal(a.size(), b.size());
+                    fontomas__check_true(std::equal(a.begin(), a.end(), b.begin()));
+
+                    a = sequential.chain(n, t);
+                    b = parallel.chain(n, t);
+                    fontomas__check_equal(a.size(), b.size());
+                    fontomas__check_true(std::equal(a.begin(), a.end(), b.begin()));
+                }
+            }
+        }
+
+        // routes, which are added later one by one, still see all loops
+        for (const Graph::Route& route : table(200)) {
+            fontomas__check_equal(parallel.addRoute(route.nodeId, route.fallbackId, route.tagId),
+                                  sequential.addRoute(route.nodeId, route.fallbackId, route.tagId));
+        }
+        fontomas__check_true(graph_isordered(parallel));
+    }
+
+    // a batch moves only nodes between the ends of routes, which go
+    // backwards, like addRoute() does: 40 -> 30 moves 40, 30 and 31, but not
+    // 41, which follows 40, or 29, which precedes 30
+    {
+        static constexpr nodeid_t sNbPaired = 64;
+
+        Graph paired;
+        for (nodeid_t n = 0; n < sNbPaired; ++n)
+            paired.addNode(n, 0);
+        for (nodeid_t n = 0; n < sNbPaired; n += 2)
+            paired.addRoute(n, nodeid_t(n + 1), 0);
+
+        std::vector<uint32_t> before(sNbPaired);
+        for (nodeid_t n = 0; n < sNbPaired; ++n)
+            before[n] = Tester::order(paired, n, 0);
+
+        const Graph::Route backwards[] = { {40, 30, 0}, {12, 14, 0} };
+        fontomas__check_equal(paired.addRoutesParallel(span_t<const Graph::Route>(backwards, 2), 2), Graph::eOk);
+        fontomas__check_true(graph_isordered(paired));
+
+        for (nodeid_t n = 0; n < sNbPaired; ++n) {
+            if (30 != n && 31 != n && 40 != n)
+                fontomas__check_equal(Tester::order(paired, n, 0), before[n]);
+        }
+        fontomas__check_equal(Tester::order(paired, 40, 0), before[30]);
+        fontomas__check_equal(Tester::order(paired, 30, 0), before[31]);
+        fontomas__check_equal(Tester::order(paired, 31, 0), before[40]);
+    }
+
+    // an empty table and a table without valid routes change nothing
+    Graph g;
+    g.addNode(0, 0);
+    fontomas__check_equal(g.addRoutesParallel(span_t<const Graph::Route>(), 4), Graph::eOk);
+    const Graph::Route self{0, 0, 0};
+    fontomas__check_equal(g.addRoutesParallel(span_t<const Graph::Route>(&self, 1), 4), Graph::eNotAllowed);
+    fontomas__check_equal(g.generation(), 1);
+
+    return true;
+}
+
+
 bool test__fallback__graph_fallbacks() {
     using namespace fontomas;
     using namespace fontomas::fallback;
@@ -266,6 +609,1361 @@ bool test__fallback__graph_fallbacks() {
     res = g.fallbacks(3, 1, buffer.get(), 0);
     fontomas__check_equal(res, 0);
 
+    // views report the full count and match the copied fallbacks
+    for (nodeid_t n = 0; n < 7; ++n) {
+        for (tagid_t t = 0; t < 12; ++t) {
+            span_t<const nodeid_t> view = g.fallbacks(n, t);
+            uint16_t nbcopied = g.fallbacks(n, t, buffer.get(), 7);
+            fontomas__check_equal(view.size(), nbcopied);
+            fontomas__check_true(std::equal(view.begin(), view.end(), buffer.get()));
+        }
+    }
+    fontomas__check_equal(g.fallbacks(3, 1).size(), 2);
+    fontomas__check_true(g.fallbacks(7, 1).empty());
+    fontomas__check_true(Graph().fallbacks(0, 0).empty());
+
+    return true;
+}
+
+
+bool test__fallback__graph_fallbacks_for_tags() {
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    static constexpr nodeid_t sNbNodes = 64;
+    static constexpr tagid_t sNbTags = 12;
+
+    nodeid_t buffer[sNbNodes];
+
+    // fallbacks of all tags in the mask, in the order they were added first
+    {
+        Graph g;
+        for (nodeid_t n = 0; n < sNbNodes; ++n)
+            g.addNode(n, 0);
+
+        std::mt19937 rng(7);
+        std::vector<std::vector<nodeid_t>> added(sNbNodes);
+        for (int i = 0; i < 2000; ++i) {
+            const nodeid_t from = nodeid_t(rng() % sNbNodes), to = nodeid_t(rng() % sNbNodes);
+            if (Graph::eOk != g.addRoute(from, to, tagid_t(rng() % sNbTags)))
+                continue;
+            if (added[from].end() == std::find(added[from].begin(), added[from].end(), to))
+                added[from].push_back(to);
+        }
+
+        for (int i = 0; i < 200; ++i) {
+            const uint64_t mask = rng() & ((1u << sNbTags) - 1);
+            for (nodeid_t n = 0; n < sNbNodes; ++n) {
+                std::vector<nodeid_t> expected;
+                for (nodeid_t fallbackId : added[n]) {
+                    for (tagid_t t = 0; t < sNbTags; ++t) {
+                        span_t<const nodeid_t> fallbacks = g.fallbacks(n, t);
+                        if (0 != (mask & (uint64_t(1) << t)) &&
+                            fallbacks.end() != std::find(fallbacks.begin(), fallbacks.end(), fallbackId))
+                        {
+                            expected.push_back(fallbackId);
+                            break;
+                        }
+                    }
+                }
+
+                const uint16_t nbfound = g.fallbacksForTags(n, span_t<const uint64_t>(&mask, 1), buffer, sNbNodes);
+                fontomas__check_equal(nbfound, expected.size());
+                fontomas__check_true(std::equal(expected.begin(), expected.end(), buffer));
+            }
+        }
+
+        // too small buffer
+        const uint64_t all = ~uint64_t(0);
+        const uint16_t nbfound = g.fallbacksForTags(0, span_t<const uint64_t>(&all, 1), buffer, sNbNodes);
+        fontomas__check_true(nbfound > 1);
+        const nodeid_t first = buffer[0];
+        fontomas__check_equal(g.fallbacksForTags(0, span_t<const uint64_t>(&all, 1), buffer, 1), nbfound);
+        fontomas__check_equal(buffer[0], first);
+
+        // shrinking keeps edges
+        g.shrink_to_fit();
+        fontomas__check_equal(g.fallbacksForTags(0, span_t<const uint64_t>(&all, 1), buffer, sNbNodes), nbfound);
+        fontomas__check_equal(buffer[0], first);
+
+        // no tags and no nodes
+        fontomas__check_equal(g.fallbacksForTags(0, span_t<const uint64_t>(), buffer, sNbNodes), 0);
+        fontomas__check_equal(g.fallbacksForTags(sNbNodes, span_t<const uint64_t>(&all, 1), buffer, sNbNodes), 0);
+        fontomas__check_equal(Graph().fallbacksForTags(0, span_t<const uint64_t>(&all, 1), buffer, sNbNodes), 0);
+    }
+
+    // tags 2, 66 and 130 share a bit of their words
+    {
+        Graph g;
+        for (nodeid_t n = 0; n < 4; ++n)
+            g.addNode(n, 2);
+        fontomas__check_equal(g.addRoute(0, 1, 66), Graph::eOk);
+        fontomas__check_equal(g.addRoute(0, 2, 2), Graph::eOk);
+        fontomas__check_equal(g.addRoute(0, 3, 130), Graph::eOk);
+        fontomas__check_equal(g.addRoute(0, 2, 66), Graph::eOk);
+
+        const uint64_t bit = uint64_t(1) << 2;
+        const uint64_t masks[][3] = {
+            { bit, 0, 0 }, { 0, bit, 0 }, { 0, 0, bit }, { bit, 0, bit }, { 0, 0, 0 }
+        };
+        const std::vector<nodeid_t> expected[] = { { 2 }, { 1, 2 }, { 3 }, { 2, 3 }, {} };
+
+        for (std::size_t i = 0; i < 5; ++i) {
+            const uint16_t nbfound = g.fallbacksForTags(0, span_t<const uint64_t>(masks[i], 3), buffer, sNbNodes);
+            fontomas__check_equal(nbfound, expected[i].size());
+            fontomas__check_true(std::equal(expected[i].begin(), expected[i].end(), buffer));
+        }
+
+        // tags beyond the mask are not in it
+        fontomas__check_equal(g.fallbacksForTags(0, span_t<const uint64_t>(masks[2], 2), buffer, sNbNodes), 0);
+    }
+
+    // routes, which are rejected in a batch, leave no edges
+    {
+        Graph g;
+        for (nodeid_t n = 0; n < 3; ++n)
+            g.addNode(n, 0);
+
+        Graph::Route routes[] = { {0, 1, 0}, {1, 0, 0}, {1, 2, 1}, {0, 2, 1} };
+        Graph::Result results[4];
+        g.addRoutes(span_t<const Graph::Route>(routes, 4), results);
+        fontomas__check_equal(results[0], Graph::eOk);
+        fontomas__check_equal(results[1], Graph::eNotAllowed);
+
+        const uint64_t mask = 1;
+        fontomas__check_equal(g.fallbacksForTags(1, span_t<const uint64_t>(&mask, 1), buffer, sNbNodes), 0);
+        fontomas__check_equal(g.fallbacksForTags(0, span_t<const uint64_t>(&mask, 1), buffer, sNbNodes), 1);
+        fontomas__check_equal(buffer[0], 1);
+    }
+
+    return true;
+}
+
+
+bool test__fallback__graph_fallbacks_batch() {
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    static constexpr nodeid_t sNbNodes = 256;
+
+    // nodes get a few, close or spread tags, so all layouts are queried
+    Graph g;
+    std::mt19937 rng(11);
+    for (nodeid_t n = 0; n < sNbNodes; ++n)
+        g.addNode(n, 0);
+    for (int i = 0; i < 6000; ++i) {
+        const nodeid_t from = nodeid_t(rng() % sNbNodes);
+        const tagid_t tagId = from % 3 == 0 ? tagid_t(rng() % 4)
+                            : from % 3 == 1 ? tagid_t(rng() % 24)
+                            : tagid_t(rng() % 1000);
+        g.addRoute(from, nodeid_t(rng() % sNbNodes), tagId);
+    }
+
+    // some queries miss nodes or tags
+    std::vector<Graph::Query> queries(1000);
+    for (Graph::Query& q : queries) {
+        q.nodeId = nodeid_t(rng() % (sNbNodes + 8));
+        q.tagId = q.nodeId % 3 == 2 ? tagid_t(rng() % 1000) : tagid_t(rng() % 24);
+    }
+
+    std::vector<Graph::Found> found(queries.size());
+    std::vector<nodeid_t> arena(1 << 16);
+    const uint32_t nbfound = g.fallbacks(span_t<const Graph::Query>(queries.data(), queries.size()),
+                                         found.data(), arena.data(), uint32_t(arena.size()));
+
+    uint32_t offset = 0;
+    for (std::size_t i = 0; i < queries.size(); ++i) {
+        span_t<const nodeid_t> view = g.fallbacks(queries[i].nodeId, queries[i].tagId);
+        fontomas__check_equal(found[i].offset, offset);
+        fontomas__check_equal(found[i].count, view.size());
+        fontomas__check_true(std::equal(view.begin(), view.end(), arena.data() + offset));
+        offset += uint32_t(view.size());
+    }
+    fontomas__check_equal(nbfound, offset);
+    fontomas__check_true(nbfound > 0);
+
+    // fallbacks, which don't fit the arena, are counted but not copied
+    std::vector<nodeid_t> small(nbfound / 2 + 1, sNotConnected);
+    std::vector<Graph::Found> foundSmall(queries.size());
+    fontomas__check_equal(g.fallbacks(span_t<const Graph::Query>(queries.data(), queries.size()),
+                                      foundSmall.data(), small.data(), uint32_t(small.size() - 1)),
+                          nbfound);
+    fontomas__check_true(std::equal(small.begin(), small.end() - 1, arena.begin()));
+    fontomas__check_equal(small.back(), sNotConnected);
+    for (std::size_t i = 0; i < queries.size(); ++i) {
+        fontomas__check_equal(foundSmall[i].offset, found[i].offset);
+        fontomas__check_equal(foundSmall[i].count, found[i].count);
+    }
+
+    // no queries and no nodes
+    fontomas__check_equal(g.fallbacks(span_t<const Graph::Query>(), nullptr, nullptr, 0), 0);
+    fontomas__check_equal(Graph().fallbacks(span_t<const Graph::Query>(queries.data(), queries.size()),
+                                            found.data(), arena.data(), uint32_t(arena.size())), 0);
+    fontomas__check_equal(found[0].count, 0);
+
+    return true;
+}
+
+
+bool test__fallback__graph_freeze() {
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    struct Route {
+        nodeid_t from, to;
+        tagid_t tag;
+    };
+
+    static const Route sRoutes[8] = {
+        Route{0, 1, 0},
+        Route{0, 2, 3},
+        Route{0, 3, 1},
+        Route{2, 3, 1},
+        Route{2, 5, 1},
+        Route{3, 5, 1},
+        Route{3, 4, 1},
+        Route{5, 4, 2}
+    };
+
+    Graph g;
+    fontomas__check_true(g.freeze().empty());
+    fontomas__check_equal(g.freeze().fallbacks(0, 0).size(), 0);
+
+    bool ok = graph_init(g, graph_node(0, 0), graph_node(1, 0),
+                            graph_node(2, 1), graph_node(3, 1),
+                            graph_node(4, 2), graph_node(5, 2),
+                            graph_node(6, 10));
+    fontomas__check_equal(ok, true);
+
+    for (const Route& route : sRoutes) {
+        Graph::Result res = g.addRoute(route.from, route.to, route.tag);
+        fontomas__check_equal(res, Graph::eOk);
+    }
+
+    FrozenGraph frozen = g.freeze();
+    fontomas__check_false(frozen.empty());
+
+    for (nodeid_t n = 0; n < 7; ++n) {
+        for (tagid_t t = 0; t < 12; ++t) {
+            span_t<const nodeid_t> res = frozen.fallbacks(n, t);
+
+            std::list<nodeid_t> ref = testing::collect_all(sEtalonMatrix[n], (nodeid_t)7, t,
+                [n](nodeid_t v) -> bool { return n != v; }
+            );
+            fontomas__check_equal(res.size(), ref.size());
+
+            bool areEqual = testing::equal_unordered(res.data(), ref);
+            fontomas__check_true(areEqual);
+        }
+    }
+
+    // not existing node
+    fontomas__check_equal(frozen.fallbacks(7, 0).size(), 0);
+    fontomas__check_equal(frozen.fallbacks(std::numeric_limits<nodeid_t>::max(), 1).size(), 0);
+
+    // the snapshot doesn't see later changes
+    fontomas__check_equal(g.addRoute(1, 6, 0), Graph::eOk);
+    fontomas__check_equal(frozen.fallbacks(1, 0).size(), 0);
+
+    FrozenGraph moved = std::move(frozen);
+    fontomas__check_true(frozen.empty());
+    fontomas__check_equal(moved.fallbacks(3, 1).size(), 2);
+
+    return true;
+}
+
+
+bool test__fallback__graph_freeze_save() {
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    static const char* sPath = "test_fallback_graph.fgraph";
+
+    auto read = [](std::vector<uint8_t>& bytes) -> bool {
+        std::FILE* file = std::fopen(sPath, "rb");
+        if (!file)
+            return false;
+        bytes.resize(1 << 20);
+        bytes.resize(std::fread(bytes.data(), 1, bytes.size(), file));
+        std::fclose(file);
+        return true;
+    };
+
+    auto write = [](const std::vector<uint8_t>& bytes) -> bool {
+        std::FILE* file = std::fopen(sPath, "wb");
+        if (!file)
+            return false;
+        const bool written = bytes.size() == std::fwrite(bytes.data(), 1, bytes.size(), file);
+        return 0 == std::fclose(file) && written;
+    };
+
+    Graph g;
+    for (nodeid_t n = 0; n < 100; ++n)
+        g.addNode(n, tagid_t(n % 7));
+    for (int i = 0; i < 1000; ++i)
+        g.addRoute(nodeid_t(std::rand() % 100), nodeid_t(std::rand() % 100), tagid_t(std::rand() % 12));
+
+    FrozenGraph frozen = g.freeze();
+    fontomas__check_equal(frozen.save(sPath), FrozenGraph::eOk);
+
+    FrozenGraph loaded;
+    fontomas__check_equal(loaded.load(sPath), FrozenGraph::eOk);
+    FrozenGraph moved = std::move(loaded);
+    fontomas__check_true(loaded.empty());
+
+    for (nodeid_t n = 0; n <= 100; ++n) {
+        for (tagid_t t = 0; t <= 12; ++t) {
+            span_t<const nodeid_t> a = frozen.fallbacks(n, t);
+            span_t<const nodeid_t> b = moved.fallbacks(n, t);
+            fontomas__check_equal(a.size(), b.size());
+            fontomas__check_true(std::equal(a.begin(), a.end(), b.begin()));
+        }
+    }
+
+    // a loaded snapshot is saved as it is
+    std::vector<uint8_t> bytes, resaved;
+    fontomas__check_true(read(bytes));
+    fontomas__check_equal(moved.save(sPath), FrozenGraph::eOk);
+    fontomas__check_true(read(resaved));
+    fontomas__check_true(bytes == resaved);
+
+    // damaged files
+    std::vector<uint8_t> damaged = bytes;
+    damaged[bytes.size() - 8] ^= 0x40;
+    fontomas__check_true(write(damaged));
+    fontomas__check_equal(loaded.load(sPath), FrozenGraph::eCorrupted);
+    fontomas__check_true(loaded.empty());
+    fontomas__check_equal(loaded.load(sPath, false), FrozenGraph::eOk);
+
+    damaged.assign(bytes.begin(), bytes.end() - 4);
+    fontomas__check_true(write(damaged));
+    fontomas__check_equal(loaded.load(sPath), FrozenGraph::eCorrupted);
+
+    // tables, which would lead lookups out of bounds, are found even in a
+    // trusted file; a word of the block is patched after the header
+    auto patch = [&bytes](std::size_t word, uint32_t value) -> std::vector<uint8_t> {
+        std::vector<uint8_t> patched = bytes;
+        std::memcpy(patched.data() + 32 + sizeof(uint32_t) * word, &value, sizeof(value));
+        return patched;
+    };
+
+    uint32_t nbNodes;
+    std::memcpy(&nbNodes, bytes.data() + 8, sizeof(nbNodes));
+    fontomas__check_true(write(patch(1, 0xFFFFFFF0u))); // a slice beyond tags
+    fontomas__check_equal(loaded.load(sPath, false), FrozenGraph::eCorrupted);
+    fontomas__check_true(loaded.empty());
+    fontomas__check_true(write(patch(nbNodes + 1 + 2, 0))); // a decreasing offset
+    fontomas__check_equal(loaded.load(sPath, false), FrozenGraph::eCorrupted);
+    fontomas__check_true(write(patch(nbNodes + 1, 1))); // offsets must start from 0
+    fontomas__check_equal(loaded.load(sPath, false), FrozenGraph::eCorrupted);
+
+    damaged = bytes;
+    damaged[4] += 1; // format version
+    fontomas__check_true(write(damaged));
+    fontomas__check_equal(loaded.load(sPath), FrozenGraph::eNotSupported);
+
+    damaged = bytes;
+    std::reverse(damaged.begin(), damaged.begin() + 4); // byte order
+    fontomas__check_true(write(damaged));
+    fontomas__check_equal(loaded.load(sPath), FrozenGraph::eNotSupported);
+
+    // an empty snapshot
+    fontomas__check_equal(FrozenGraph().save(sPath), FrozenGraph::eOk);
+    fontomas__check_equal(loaded.load(sPath), FrozenGraph::eOk);
+    fontomas__check_true(loaded.empty());
+
+    std::remove(sPath);
+    fontomas__check_equal(loaded.load(sPath), FrozenGraph::eNotExists);
+    fontomas__check_equal(frozen.save("not/existing/folder/graph.fgraph"), FrozenGraph::eFailed);
+
+    return true;
+}
+
+bool test__fallback__graph_chain() {
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    struct Route {
+        nodeid_t from, to;
+        tagid_t tag;
+    };
+
+    static const Route sRoutes[8] = {
+        Route{0, 1, 0},
+        Route{0, 2, 3},
+        Route{0, 3, 1},
+        Route{2, 3, 1},
+        Route{2, 5, 1},
+        Route{3, 5, 1},
+        Route{3, 4, 1},
+        Route{5, 4, 2}
+    };
+
+    auto equal = [](span_t<const nodeid_t> chain, std::initializer_list<nodeid_t> ref) -> bool {
+        return chain.size() == ref.size() && std::equal(chain.begin(), chain.end(), ref.begin());
+    };
+
+    Graph g;
+    bool ok = graph_init(g, graph_node(0, 0), graph_node(1, 0),
+                            graph_node(2, 1), graph_node(3, 1),
+                            graph_node(4, 2), graph_node(5, 2),
+                            graph_node(6, 10));
+    fontomas__check_equal(ok, true);
+
+    for (const Route& route : sRoutes) {
+        Graph::Result res = g.addRoute(route.from, route.to, route.tag);
+        fontomas__check_equal(res, Graph::eOk);
+    }
+
+    fontomas__check_true(equal(g.chain(0, 1), {3, 5, 4}));
+    fontomas__check_true(equal(g.chain(2, 1), {3, 4, 5}));
+    fontomas__check_true(equal(g.chain(0, 0), {1}));
+    fontomas__check_true(equal(g.chain(5, 2), {4}));
+    fontomas__check_true(g.chain(5, 1).empty());
+    fontomas__check_true(g.chain(6, 1).empty());
+    fontomas__check_true(g.chain(7, 1).empty());
+
+    // cached chains are reused
+    const nodeid_t* cached02 = g.chain(0, 1).data();
+    fontomas__check_equal(g.chain(0, 1).data(), cached02);
+
+    // only ancestors of the changed node are invalidated
+    const nodeid_t* cached52 = g.chain(5, 2).data();
+    fontomas__check_equal(g.addRoute(4, 6, 1), Graph::eOk);
+    fontomas__check_equal(g.chain(5, 2).data(), cached52);
+
+    fontomas__check_true(equal(g.chain(0, 1), {3, 5, 4, 6}));
+    fontomas__check_true(equal(g.chain(2, 1), {3, 4, 6, 5}));
+    fontomas__check_true(equal(g.chain(3, 1), {5, 4, 6}));
+    fontomas__check_true(equal(g.chain(4, 1), {6}));
+
+    return true;
+}
+
+
+bool test__fallback__graph_cheapest() {
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    class TableCosts : public Costs {
+    public:
+        uint32_t cost(nodeid_t nodeId, nodeid_t fallbackId, tagid_t tagId) noexcept override {
+            if (weighted)
+                return (nodeId * 7 + fallbackId * 13 + tagId) % 10;
+            return 0 == nodeId && 1 == fallbackId ? expensive : 1;
+        }
+        bool serves(nodeid_t nodeId, tagid_t) noexcept override {
+            return std::find(serving.begin(), serving.end(), nodeId) != serving.end();
+        }
+
+        std::vector<nodeid_t> serving;
+        uint32_t expensive = 1;
+        bool weighted = false;
+    };
+
+    //
+    //    0 --> 1 ------> 4
+    //    |               ^
+    //    +---> 2 --> 3 --+
+    //
+    Graph g;
+    for (nodeid_t n = 0; n < 6; ++n)
+        g.addNode(n, 0);
+    g.addRoute(0, 1, 0);
+    g.addRoute(0, 2, 0);
+    g.addRoute(2, 3, 0);
+    g.addRoute(3, 4, 0);
+    g.addRoute(1, 4, 0);
+
+    TableCosts costs;
+    costs.serving = { 0, 1, 4 };
+    nodeid_t hops[4];
+
+    // equal costs are taken in the order of fallbacks
+    Graph::Path path = g.cheapest(0, 0, costs, hops, 4);
+    fontomas__check_equal(path.nodeId, 1);
+    fontomas__check_equal(path.cost, 1);
+    fontomas__check_equal(path.nbhops, 1);
+    fontomas__check_equal(hops[0], 1);
+
+    // an expensive route is avoided
+    costs.expensive = 10;
+    path = g.cheapest(0, 0, costs, hops, 4);
+    fontomas__check_equal(path.nodeId, 4);
+    fontomas__check_equal(path.cost, 3);
+    fontomas__check_equal(path.nbhops, 3);
+    fontomas__check_equal(hops[0], 2);
+    fontomas__check_equal(hops[1], 3);
+    fontomas__check_equal(hops[2], 4);
+
+    // too small buffer
+    hops[1] = sNotConnected;
+    path = g.cheapest(0, 0, costs, hops, 1);
+    fontomas__check_equal(path.nbhops, 3);
+    fontomas__check_equal(hops[0], 2);
+    fontomas__check_equal(hops[1], sNotConnected);
+
+    // nothing serves
+    costs.serving = { 0 };
+    fontomas__check_equal(g.cheapest(0, 0, costs).nodeId, sNotConnected);
+    fontomas__check_equal(g.cheapest(0, 1, costs).nodeId, sNotConnected);
+    fontomas__check_equal(g.cheapest(6, 0, costs).nodeId, sNotConnected);
+    fontomas__check_equal(Graph().cheapest(0, 0, costs).nodeId, sNotConnected);
+
+    // costs match the cheapest path over the whole dag; routes go to greater
+    // ids, so nodes are relaxed in the order of ids
+    {
+        static constexpr nodeid_t sNbNodes = 200;
+
+        Graph dag;
+        std::mt19937 rng(5);
+        for (nodeid_t n = 0; n < sNbNodes; ++n)
+            dag.addNode(n, 0);
+        for (nodeid_t n = 0; n + 1 < sNbNodes; ++n) {
+            for (int i = 0; i < 4; ++i)
+                dag.addRoute(n, nodeid_t(n + 1 + rng() % (sNbNodes - n - 1)), 0);
+        }
+
+        costs.weighted = true;
+        for (int round = 0; round < 50; ++round) {
+            costs.serving.clear();
+            for (nodeid_t n = 0; n < sNbNodes; ++n) {
+                if (0 == rng() % 16)
+                    costs.serving.push_back(n);
+            }
+
+            const nodeid_t start = nodeid_t(rng() % 32);
+            std::vector<uint32_t> best(sNbNodes, std::numeric_limits<uint32_t>::max());
+            best[start] = 0;
+            uint32_t expected = std::numeric_limits<uint32_t>::max();
+            for (nodeid_t n = start; n < sNbNodes; ++n) {
+                if (std::numeric_limits<uint32_t>::max() == best[n])
+                    continue;
+                if (n != start && costs.serves(n, 0))
+                    expected = std::min(expected, best[n]);
+                for (nodeid_t f : dag.fallbacks(n, 0))
+                    best[f] = std::min(best[f], best[n] + costs.cost(n, f, 0));
+            }
+
+            nodeid_t path[sNbNodes];
+            const Graph::Path found = dag.cheapest(start, 0, costs, path, sNbNodes, sNbNodes);
+            if (std::numeric_limits<uint32_t>::max() == expected) {
+                fontomas__check_equal(found.nodeId, sNotConnected);
+                continue;
+            }
+
+            fontomas__check_equal(found.cost, expected);
+            fontomas__check_true(costs.serves(found.nodeId, 0));
+            fontomas__check_equal(path[found.nbhops - 1], found.nodeId);
+
+            uint32_t sum = 0;
+            for (uint16_t i = 0; i < found.nbhops; ++i) {
+                const nodeid_t from = 0 == i ? start : path[i - 1];
+                span_t<const nodeid_t> fallbacks = dag.fallbacks(from, 0);
+                fontomas__check_true(fallbacks.end() != std::find(fallbacks.begin(), fallbacks.end(), path[i]));
+                sum += costs.cost(from, path[i], 0);
+            }
+            fontomas__check_equal(sum, found.cost);
+
+            // a small frontier may miss the cheapest path, but not a cheaper one
+            const Graph::Path bounded = dag.cheapest(start, 0, costs, nullptr, 0, 2);
+            fontomas__check_true(sNotConnected == bounded.nodeId || costs.serves(bounded.nodeId, 0));
+            fontomas__check_true(sNotConnected == bounded.nodeId || bounded.cost >= expected);
+        }
+    }
+
+    return true;
+}
+
+
+bool test__fallback__graph_first_covering() {
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    //
+    //   0 (latin) --> 1 (no coverage) --> 2 (cyrillic)
+    //   |
+    //   +-----------> 3 (latin, cyrillic, cjk)
+    //
+    Graph g;
+    for (nodeid_t n = 0; n < 4; ++n)
+        g.addNode(n, 0);
+    g.addRoute(0, 1, 0);
+    g.addRoute(1, 2, 0);
+    g.addRoute(0, 3, 0);
+
+    auto coverage = [](std::initializer_list<std::pair<codepoint_t, codepoint_t>> ranges) {
+        Coverage c;
+        for (const auto& range : ranges)
+            c.add(range.first, range.second);
+        return c;
+    };
+
+    fontomas__check_equal(g.setCoverage(0, coverage({ {0x20, 0x7E} })), Graph::eOk);
+    fontomas__check_equal(g.setCoverage(2, coverage({ {0x400, 0x4FF} })), Graph::eOk);
+    fontomas__check_equal(g.setCoverage(3, coverage({ {0x20, 0x7E}, {0x400, 0x4FF}, {0x4E00, 0x9FFF} })), Graph::eOk);
+    fontomas__check_equal(g.setCoverage(4, coverage({ {0x20, 0x7E} })), Graph::eNotExists);
+
+    fontomas__check_true(nullptr == g.coverage(1));
+    fontomas__check_true(g.coverage(3)->covers(0x4E00));
+
+    // a chain, which isn't resolved, is only found by firstCovering()
+    nodeid_t found;
+    fontomas__check_true(g.cachedCovering(0, 0, 'A', found));
+    fontomas__check_equal(found, 0);
+    fontomas__check_false(g.cachedCovering(0, 0, 0x416, found));
+    fontomas__check_true(g.cachedCovering(5, 0, 'A', found));
+    fontomas__check_equal(found, sNotConnected);
+
+    // the node itself, then its chain in order
+    fontomas__check_equal(g.firstCovering(0, 0, 'A'), 0);
+    fontomas__check_equal(g.firstCovering(0, 0, 0x416), 2);
+    fontomas__check_equal(g.firstCovering(0, 0, 0x4E2D), 3);
+    fontomas__check_equal(g.firstCovering(0, 0, 0x1F600), sNotConnected);
+    fontomas__check_equal(g.firstCovering(1, 0, 'A'), sNotConnected);
+    fontomas__check_equal(g.firstCovering(0, 1, 0x416), sNotConnected);
+    fontomas__check_equal(g.firstCovering(5, 0, 'A'), sNotConnected);
+    fontomas__check_true(g.cachedCovering(0, 0, 0x416, found));
+    fontomas__check_equal(found, 2);
+    fontomas__check_true(g.cachedCovering(0, 0, 0x1F600, found));
+    fontomas__check_equal(found, sNotConnected);
+
+    // coverages follow changes of the graph
+    g.removeRoute(1, 2, 0);
+    fontomas__check_equal(g.firstCovering(0, 0, 0x416), 3);
+
+    fontomas__check_equal(g.setCoverage(3, coverage({ {0x20, 0x7E} })), Graph::eOk);
+    fontomas__check_equal(g.firstCovering(0, 0, 0x4E2D), sNotConnected);
+
+    const std::size_t reserved = g.memory().reserved;
+    fontomas__check_equal(g.removeNode(3), Graph::eOk);
+    fontomas__check_true(g.memory().reserved < reserved);
+    fontomas__check_equal(g.firstCovering(0, 0, 0x416), sNotConnected);
+
+    // the max id of any width is sNotConnected, so it can't be a node, which
+    // would be found as no node
+    Graph8 narrow;
+    fontomas__check_equal(narrow.addNode(0xFF, 0), Graph8::eNotAllowed);
+    fontomas__check_equal(narrow.addNode(0xFE, 0), Graph8::eOk);
+    fontomas__check_equal(narrow.addNode(0, 0), Graph8::eOk);
+    fontomas__check_equal(narrow.addRoute(0, 0xFF, 0), Graph8::eNotExists);
+    fontomas__check_equal(narrow.addRoute(0, 0xFE, 0), Graph8::eOk);
+    fontomas__check_equal(narrow.setCoverage(0xFE, coverage({ {0x20, 0x7E} })), Graph8::eOk);
+    fontomas__check_equal(narrow.firstCovering(0, 0, 'A'), 0xFE);
+    fontomas__check_equal(narrow.firstCovering(0, 0, 0x416), Graph8::sNotConnected);
+    fontomas__check_equal(g.addNode(Graph::sNotConnected, 0), Graph::eNotAllowed);
+    fontomas__check_equal(Graph32().addNode(Graph32::sNotConnected, 0), Graph32::eNotAllowed);
+
+    return true;
+}
+
+
+bool test__fallback__graph_deep() {
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    static constexpr nodeid_t sNbNodes = 60000;
+    static constexpr nodeid_t sChainDepth = 1000;
+
+    // one long path 0 -> 1 -> ... -> sNbNodes - 1, which traversals have to
+    // walk through without running out of the stack
+    std::vector<Graph::Route> routes;
+    for (nodeid_t n = 0; n + 1 < sNbNodes; ++n)
+        routes.push_back(Graph::Route{n, nodeid_t(n + 1), 0});
+    routes.push_back(Graph::Route{nodeid_t(sNbNodes - 1), 0, 0});
+
+    Graph g, bulk;
+    for (nodeid_t n = 0; n < sNbNodes; ++n) {
+        fontomas__check_equal(g.addNode(n, 0), Graph::eOk);
+        fontomas__check_equal(bulk.addNode(n, 0), Graph::eOk);
+    }
+
+    for (std::size_t i = 0; i + 1 < routes.size(); ++i) {
+        fontomas__check_equal(g.addRoute(routes[i].nodeId, routes[i].fallbackId, 0), Graph::eOk);
+    }
+    fontomas__check_equal(g.addRoute(sNbNodes - 1, 0, 0), Graph::eNotAllowed);
+    fontomas__check_true(graph_isordered(g));
+
+    std::vector<Graph::Result> results(routes.size());
+    Graph::Result res = bulk.addRoutes(span_t<const Graph::Route>(routes.data(), routes.size()),
+                                       results.data());
+    fontomas__check_equal(res, Graph::eNotAllowed);
+    fontomas__check_equal(results.back(), Graph::eNotAllowed);
+    fontomas__check_equal(results.front(), Graph::eOk);
+    fontomas__check_true(graph_isordered(bulk));
+
+    // chains are resolved through the whole depth below the node
+    const nodeid_t nodeId = sNbNodes - sChainDepth - 1;
+    span_t<const nodeid_t> chain = g.chain(nodeId, 0);
+    fontomas__check_equal(chain.size(), std::size_t(sChainDepth));
+    fontomas__check_equal(chain[0], nodeid_t(nodeId + 1));
+    fontomas__check_equal(chain[sChainDepth - 1], nodeid_t(sNbNodes - 1));
+
+    // and invalidated through the whole depth above the changed node
+    fontomas__check_equal(g.addNode(sNbNodes, 0), Graph::eOk);
+    fontomas__check_equal(g.addRoute(sNbNodes - 1, sNbNodes, 0), Graph::eOk);
+    chain = g.chain(nodeId, 0);
+    fontomas__check_equal(chain.size(), std::size_t(sChainDepth + 1));
+    fontomas__check_equal(chain[sChainDepth], nodeid_t(sNbNodes));
+
+    return true;
+}
+
+
+bool test__fallback__graph_allocators() {
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    static constexpr nodeid_t sNbNodes = 200;
+    static constexpr tagid_t sNbTags = 20;
+    static constexpr int sNbRoutes = 4000;
+
+    std::vector<Graph::Route> routes;
+    for (int i = 0; i < sNbRoutes; ++i) {
+        routes.push_back(Graph::Route{nodeid_t(std::rand() % sNbNodes), nodeid_t(std::rand() % sNbNodes),
+                                      tagid_t(std::rand() % sNbTags)});
+    }
+
+    HeapAllocator heap;
+    ArenaAllocator arena;
+    PoolAllocator pool;
+
+    {
+        Graph reference, gheap(heap), garena(arena), gpool(pool);
+        Graph* graphs[] = { &gheap, &garena, &gpool };
+
+        for (nodeid_t n = 0; n < sNbNodes; ++n) {
+            reference.addNode(n, 0);
+            for (Graph* g : graphs)
+                g->addNode(n, 0);
+        }
+
+        for (const Graph::Route& r : routes) {
+            Graph::Result res = reference.addRoute(r.nodeId, r.fallbackId, r.tagId);
+            for (Graph* g : graphs) {
+                fontomas__check_equal(g->addRoute(r.nodeId, r.fallbackId, r.tagId), res);
+            }
+        }
+
+        for (nodeid_t n = 0; n < sNbNodes; ++n) {
+            for (tagid_t t = 0; t < sNbTags; ++t) {
+                span_t<const nodeid_t> chain = reference.chain(n, t);
+                for (Graph* g : graphs) {
+                    span_t<const nodeid_t> other = g->chain(n, t);
+                    fontomas__check_equal(other.size(), chain.size());
+                    fontomas__check_true(std::equal(chain.begin(), chain.end(), other.begin()));
+                }
+            }
+        }
+
+        // all memory of a graph comes from its allocator
+        MemoryStats memory = gheap.memory();
+        fontomas__check_equal(memory.reserved, heap.stats().used);
+        fontomas__check_true(memory.used <= memory.reserved);
+        fontomas__check_true(arena.stats().used >= memory.reserved);
+        fontomas__check_true(pool.stats().used >= memory.reserved);
+    }
+
+    fontomas__check_equal(heap.stats().used, std::size_t(0));
+    fontomas__check_equal(pool.stats().used, std::size_t(0));
+
+    return true;
+}
+
+
+bool test__fallback__graph_tags() {
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    // a node with one big tag id doesn't take memory for all smaller ones
+    {
+        Graph g;
+        fontomas__check_equal(g.addNode(0, 40000), Graph::eOk);
+        fontomas__check_true(g.memory().reserved < 4096);
+
+        fontomas__check_equal(g.addNode(1, sNotConnected), Graph::eNotAllowed);
+        fontomas__check_equal(g.addNode(1, 0), Graph::eOk);
+        fontomas__check_equal(g.addRoute(0, 1, sNotConnected), Graph::eNotAllowed);
+        fontomas__check_equal(g.addRoute(0, 1, 40000), Graph::eOk);
+        fontomas__check_equal(g.fallbacks(0, 40000).size(), 1);
+        fontomas__check_equal(g.fallbacks(0, 0).size(), 0);
+    }
+
+    struct Case {
+        tagid_t first;
+        tagid_t stride;
+        tagid_t nbtags;
+        uint8_t layout;
+    };
+
+    static const Case sCases[] = {
+        { 40000, 7000, 3, Tester::sSorted },
+        { 100, 1, 200, Tester::sDense },
+        { 5, 977, 60, Tester::sHashed },
+    };
+
+    for (const Case& c : sCases) {
+        std::vector<tagid_t> tags;
+        for (tagid_t i = 0; i < c.nbtags; ++i)
+            tags.push_back(tagid_t(c.first + i * c.stride));
+        std::shuffle(tags.begin(), tags.end(), std::mt19937(std::rand()));
+
+        // 0 -> 1 -> 2 by every tag, tags are attached in a random order
+        Graph g;
+        bool ok = graph_init(g, graph_node(0, tags[0]), graph_node(1, tags[0]), graph_node(2, tags[0]));
+        fontomas__check_equal(ok, true);
+
+        for (tagid_t t : tags) {
+            fontomas__check_equal(g.addRoute(1, 2, t), Graph::eOk);
+            fontomas__check_equal(g.addRoute(0, 1, t), Graph::eOk);
+        }
+        fontomas__check_equal(Tester::layout(g, 0), c.layout);
+        fontomas__check_true(graph_isordered(g));
+
+        FrozenGraph frozen = g.freeze();
+        for (tagid_t t : tags) {
+            fontomas__check_equal(g.fallbacks(0, t).size(), 1);
+            fontomas__check_equal(g.fallbacks(0, t)[0], nodeid_t(1));
+            fontomas__check_equal(g.chain(0, t).size(), 2);
+            fontomas__check_equal(frozen.fallbacks(0, t).size(), 1);
+            fontomas__check_equal(g.addRoute(2, 0, t), Graph::eNotAllowed);
+
+        }
+
+        // tags around, which are not attached
+        for (tagid_t t : { tagid_t(c.first - 1), tagid_t(c.first + c.nbtags * c.stride), tagid_t(c.first + 1) }) {
+            if (std::find(tags.begin(), tags.end(), t) != tags.end())
+                continue;
+            fontomas__check_equal(g.fallbacks(0, t).size(), 0);
+            fontomas__check_equal(frozen.fallbacks(1, t).size(), 0);
+        }
+    }
+
+    return true;
+}
+
+
+bool test__fallback__graph_capacity() {
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    // the max id is sNotConnected, so all others can be nodes
+    static constexpr uint32_t sNbNodes = Graph::sNotConnected;
+    static constexpr nodeid_t sNbFallbacks = 3000;
+
+    class CountingAllocator final : public Allocator {
+    public:
+        void* allocate(std::size_t size) noexcept override {
+            nballocs += size > 0 ? 1 : 0;
+            return heap.allocate(size);
+        }
+        void deallocate(void* block, std::size_t size) noexcept override {
+            heap.deallocate(block, size);
+        }
+        MemoryStats stats() const noexcept override { return heap.stats(); }
+
+        HeapAllocator heap;
+        std::size_t nballocs = 0;
+    };
+
+    // the nodes array grows geometrically up to the last node id
+    {
+        Graph g;
+        uint32_t nbGrowths = 0;
+        for (uint32_t n = 0; n < sNbNodes; ++n) {
+            const uint32_t szNodes = graph_szNodes(g);
+            fontomas__check_equal(g.addNode(nodeid_t(n), 0), Graph::eOk);
+            nbGrowths += szNodes != graph_szNodes(g) ? 1 : 0;
+        }
+        fontomas__check_true(nbGrowths < 32);
+        fontomas__check_equal(graph_szNodes(g), sNbNodes);
+        fontomas__check_equal(g.addRoute(0, nodeid_t(sNbNodes - 1), 0), Graph::eOk);
+        fontomas__check_equal(g.chain(0, 0).size(), 1);
+    }
+
+    // so do fallbacks, unless their capacity is reserved
+    for (bool hinted : { false, true }) {
+        CountingAllocator allocator;
+        Graph g(allocator);
+        for (nodeid_t n = 0; n <= sNbFallbacks; ++n)
+            g.addNode(n, 0);
+
+        if (hinted)
+            fontomas__check_equal(g.reserve(0, 0, sNbFallbacks), Graph::eOk);
+
+        // each route allocates parents of its fallback
+        const std::size_t nballocs = allocator.nballocs;
+        for (nodeid_t n = 1; n <= sNbFallbacks; ++n)
+            fontomas__check_equal(g.addRoute(0, n, 0), Graph::eOk);
+
+        // a growth reallocates fallbacks and both arrays of edges of the node
+        const std::size_t nbgrowths = allocator.nballocs - nballocs - sNbFallbacks;
+        fontomas__check_true(hinted ? 0 == nbgrowths : nbgrowths < 3 * 24);
+        fontomas__check_equal(g.fallbacks(0, 0).size(), sNbFallbacks);
+    }
+
+    // capacity hints
+    {
+        Graph g;
+        g.reserve(1000);
+        fontomas__check_true(g.empty());
+        fontomas__check_equal(graph_szNodes(g), 1000);
+        for (nodeid_t n = 0; n < 1000; ++n)
+            g.addNode(n, 0);
+        fontomas__check_equal(graph_szNodes(g), 1000);
+
+        // a hint is exact, even if it's below the geometric growth
+        g.reserve(1200);
+        fontomas__check_equal(graph_szNodes(g), 1200);
+        g.reserve(1201);
+        fontomas__check_equal(graph_szNodes(g), 1201);
+        g.reserve(1100);
+        fontomas__check_equal(graph_szNodes(g), 1201);
+        g.reserve(sNbNodes + 1);
+        fontomas__check_equal(graph_szNodes(g), sNbNodes);
+
+        fontomas__check_equal(g.reserve(1000, 0, 10), Graph::eNotExists);
+        fontomas__check_equal(g.reserve(0, sNotConnected, 10), Graph::eNotAllowed);
+        fontomas__check_equal(g.reserve(0, 5, 10), Graph::eOk);
+        fontomas__check_equal(g.fallbacks(0, 5).size(), 0);
+        fontomas__check_equal(g.addRoute(1, 0, 5), Graph::eOk);
+        fontomas__check_equal(g.addRoute(0, 1, 5), Graph::eNotAllowed);
+        fontomas__check_true(graph_isordered(g));
+
+        Graph reserved;
+        reserved.reserve(100);
+        reserved.shrink_to_fit();
+        fontomas__check_equal(reserved.memory().reserved, std::size_t(0));
+    }
+
+    // shrinking keeps routes
+    {
+        Graph g;
+        for (nodeid_t n = 0; n < 100; ++n)
+            g.addNode(n, 0);
+        for (int i = 0; i < 1000; ++i)
+            g.addRoute(nodeid_t(std::rand() % 100), nodeid_t(std::rand() % 100), tagid_t(std::rand() % 4));
+
+        std::vector<std::vector<nodeid_t>> chains;
+        for (nodeid_t n = 0; n < 100; ++n) {
+            for (tagid_t t = 0; t < 4; ++t) {
+                span_t<const nodeid_t> chain = g.chain(n, t);
+                chains.emplace_back(chain.begin(), chain.end());
+            }
+        }
+
+        const MemoryStats loaded = g.memory();
+        g.shrink_to_fit();
+
+        // a tag without fallbacks keeps a place for one
+        const MemoryStats shrunk = g.memory();
+        fontomas__check_equal(shrunk.used, loaded.used);
+        fontomas__check_true(shrunk.reserved < loaded.reserved);
+        fontomas__check_true(shrunk.reserved - shrunk.used <= 100 * 4 * sizeof(nodeid_t));
+        fontomas__check_equal(graph_szNodes(g), 100);
+
+        for (nodeid_t n = 0; n < 100; ++n) {
+            for (tagid_t t = 0; t < 4; ++t) {
+                span_t<const nodeid_t> chain = g.chain(n, t);
+                const std::vector<nodeid_t>& ref = chains[n * 4 + t];
+                fontomas__check_equal(chain.size(), ref.size());
+                fontomas__check_true(std::equal(chain.begin(), chain.end(), ref.begin()));
+            }
+        }
+        fontomas__check_true(graph_isordered(g));
+
+        // and the graph grows again
+        fontomas__check_equal(g.addNode(100, 0), Graph::eOk);
+        fontomas__check_equal(g.addRoute(100, 0, 0), Graph::eOk);
+        fontomas__check_equal(g.chain(100, 0)[0], nodeid_t(0));
+    }
+
+    return true;
+}
+
+
+bool test__fallback__graph_remove() {
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    //
+    //   0 --> 1 --> 2 --> 3
+    //   |                 ^
+    //   +---------4-------+
+    //
+    Graph g;
+    for (nodeid_t n = 0; n < 10; ++n)
+        fontomas__check_equal(g.addNode(n, 0), Graph::eOk);
+    g.addRoute(0, 1, 0);
+    g.addRoute(1, 2, 0);
+    g.addRoute(2, 3, 0);
+    g.addRoute(0, 4, 0);
+    g.addRoute(4, 3, 0);
+    g.addRoute(0, 1, 1);
+    fontomas__check_equal(g.chain(0, 0).size(), 4);
+
+    // routes
+    fontomas__check_equal(g.removeRoute(1, 2, 0), Graph::eOk);
+    fontomas__check_equal(g.removeRoute(1, 2, 0), Graph::eNotExists);
+    fontomas__check_equal(g.removeRoute(0, 1, 2), Graph::eNotExists);
+    fontomas__check_equal(g.removeRoute(10, 1, 0), Graph::eNotExists);
+    fontomas__check_equal(g.chain(0, 0).size(), 3);
+    fontomas__check_equal(g.chain(1, 0).size(), 0);
+    fontomas__check_true(graph_isconsistent(g));
+
+    // a route, which was removed, may be added back the other way
+    fontomas__check_equal(g.addRoute(2, 1, 0), Graph::eOk);
+    fontomas__check_equal(g.chain(0, 0).size(), 3);
+    fontomas__check_true(graph_isordered(g));
+
+    // tags
+    fontomas__check_equal(g.detachTag(0, 1), Graph::eOk);
+    fontomas__check_equal(g.detachTag(0, 1), Graph::eNotExists);
+    fontomas__check_equal(g.fallbacks(0, 1).size(), 0);
+    fontomas__check_equal(g.fallbacks(0, 0).size(), 2);
+    fontomas__check_equal(g.detachTag(1, 0), Graph::eOk);
+    fontomas__check_equal(g.detachTag(1, 1), Graph::eNotAllowed);
+    fontomas__check_equal(g.fallbacks(0, 0).size(), 1);
+    fontomas__check_equal(g.chain(2, 0).size(), 1);
+    fontomas__check_true(graph_isconsistent(g));
+
+    // nodes
+    fontomas__check_equal(g.removeNode(4), Graph::eOk);
+    fontomas__check_equal(g.removeNode(4), Graph::eNotExists);
+    fontomas__check_equal(g.chain(0, 0).size(), 0);
+    fontomas__check_equal(graph_nbNodes(g), 9);
+    fontomas__check_true(graph_isconsistent(g));
+
+    // ids of removed nodes are taken again
+    fontomas__check_equal(g.removeNode(7), Graph::eOk);
+    fontomas__check_equal(g.vacantNode(), 7);
+    fontomas__check_equal(g.addNode(7, 0), Graph::eOk);
+    fontomas__check_equal(g.vacantNode(), 4);
+    fontomas__check_equal(g.addNode(4, 0), Graph::eOk);
+    fontomas__check_equal(g.vacantNode(), 10);
+
+    // the last node isn't vacant, the nodes array is cut down to it
+    fontomas__check_equal(g.removeNode(9), Graph::eOk);
+    fontomas__check_equal(g.removeNode(8), Graph::eOk);
+    fontomas__check_equal(graph_maxNodeId(g), 7);
+    fontomas__check_equal(g.vacantNode(), 8);
+
+    uint32_t nbSteps = 1;
+    while (!g.compactStep(3))
+        ++nbSteps;
+    fontomas__check_equal(nbSteps, 3);
+    fontomas__check_equal(graph_szNodes(g), 8);
+    // only tags without fallbacks keep a place for one: all but node 2
+    fontomas__check_equal(g.memory().reserved, g.memory().used + 7 * sizeof(nodeid_t));
+    fontomas__check_true(graph_isconsistent(g));
+
+    for (nodeid_t n = 0; n < 8; ++n)
+        fontomas__check_equal(g.removeNode(n), Graph::eOk);
+    fontomas__check_true(g.empty());
+    fontomas__check_equal(g.vacantNode(), 0);
+    fontomas__check_true(g.compactStep(1));
+    fontomas__check_equal(graph_szNodes(g), 0);
+    fontomas__check_equal(g.addNode(3, 0), Graph::eOk);
+    fontomas__check_equal(g.fallbacks(3, 0).size(), 0);
+
+    return true;
+}
+
+
+bool test__fallback__graph_remove_random() {
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    static constexpr nodeid_t sNbNodes = 40;
+    // few close tags and many spread ones, so all layouts lose tags
+    static const tagid_t sTags[] = { 0, 1, 2, 3, 70, 200, 300, 1000, 2000, 4000, 5000, 9000 };
+    static constexpr std::size_t sNbTags = sizeof(sTags) / sizeof(sTags[0]);
+
+    typedef std::map<tagid_t, std::vector<nodeid_t>> Routes;
+    std::vector<Routes> model(sNbNodes);
+
+    auto forget = [&model](nodeid_t nodeId, tagid_t tagId) {
+        for (Routes& routes : model) {
+            auto found = routes.find(tagId);
+            if (routes.end() != found)
+                found->second.erase(std::remove(found->second.begin(), found->second.end(), nodeId), found->second.end());
+        }
+    };
+
+    auto reach = [&model](nodeid_t nodeId, tagid_t tagId) {
+        std::vector<nodeid_t> reached, stack(1, nodeId);
+        while (!stack.empty()) {
+            const nodeid_t n = stack.back();
+            stack.pop_back();
+            auto found = model[n].find(tagId);
+            for (nodeid_t f : model[n].end() != found ? found->second : std::vector<nodeid_t>()) {
+                if (reached.end() == std::find(reached.begin(), reached.end(), f)) {
+                    reached.push_back(f);
+                    stack.push_back(f);
+                }
+            }
+        }
+        std::sort(reached.begin(), reached.end());
+        return reached;
+    };
+
+    Graph g;
+    std::mt19937 rng(3);
+    for (int op = 0; op < 4000; ++op) {
+        const nodeid_t n = nodeid_t(rng() % sNbNodes), f = nodeid_t(rng() % sNbNodes);
+        const tagid_t t = sTags[rng() % sNbTags];
+
+        switch (rng() % 8) {
+        case 0: {
+            const Graph::Result expected = model[n].empty() ? Graph::eOk : Graph::eExists;
+            fontomas__check_equal(g.addNode(n, t), expected);
+            if (Graph::eOk == expected)
+                model[n][t];
+            break;
+        }
+        case 1: case 2: case 3:
+            if (Graph::eOk == g.addRoute(n, f, t)) {
+                model[n][t].push_back(f);
+                model[f][t];
+            }
+            break;
+        case 4: {
+            auto found = model[n].find(t);
+            const bool exists = model[n].end() != found &&
+                found->second.end() != std::find(found->second.begin(), found->second.end(), f);
+            fontomas__check_equal(g.removeRoute(n, f, t), exists ? Graph::eOk : Graph::eNotExists);
+            if (exists)
+                found->second.erase(std::find(found->second.begin(), found->second.end(), f));
+            break;
+        }
+        case 5: {
+            const Graph::Result expected = 0 == model[n].count(t) ? Graph::eNotExists
+                                         : 1 == model[n].size() ? Graph::eNotAllowed : Graph::eOk;
+            fontomas__check_equal(g.detachTag(n, t), expected);
+            if (Graph::eOk == expected) {
+                model[n].erase(t);
+                forget(n, t);
+            }
+            break;
+        }
+        case 6: {
+            const Graph::Result expected = model[n].empty() ? Graph::eNotExists : Graph::eOk;
+            fontomas__check_equal(g.removeNode(n), expected);
+            for (const auto& routes : model[n])
+                forget(n, routes.first);
+            model[n].clear();
+            break;
+        }
+        case 7:
+            g.compactStep(7);
+            break;
+        }
+
+        if (0 != op % 16)
+            continue;
+
+        fontomas__check_true(graph_isconsistent(g));
+        fontomas__check_true(graph_isordered(g));
+        for (nodeid_t m = 0; m < sNbNodes; ++m) {
+            for (tagid_t tagId : sTags) {
+                auto found = model[m].find(tagId);
+                const std::vector<nodeid_t> expected = model[m].end() != found ? found->second : std::vector<nodeid_t>();
+                span_t<const nodeid_t> fallbacks = g.fallbacks(m, tagId);
+                fontomas__check_equal(fallbacks.size(), expected.size());
+                fontomas__check_true(std::equal(expected.begin(), expected.end(), fallbacks.begin()));
+
+                span_t<const nodeid_t> chain = g.chain(m, tagId);
+                std::vector<nodeid_t> sorted(chain.begin(), chain.end());
+                std::sort(sorted.begin(), sorted.end());
+                fontomas__check_true(reach(m, tagId) == sorted);
+            }
+        }
+    }
+
+    return true;
+}
+
+
+bool test__fallback__graph_widths() {
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    static constexpr uint32_t sNbNodes = 200;
+    static constexpr uint32_t sNbTags = 100;
+
+    fontomas__check_equal(Graph8::sNotConnected, 0xFF);
+    fontomas__check_equal(Graph::sNotConnected, sNotConnected);
+    fontomas__check_equal(Graph32::sNotConnected, 0xFFFFFFFFu);
+    fontomas__check_true(sizeof(Graph8::Route) < sizeof(Graph::Route));
+
+    // the same changes give the same routes whatever the width of ids is
+    Graph8 narrow;
+    Graph middle;
+    Graph32 wide;
+    for (uint32_t n = 0; n < sNbNodes; ++n) {
+        fontomas__check_equal(narrow.addNode(uint8_t(n), uint8_t(n % 3)), Graph8::eOk);
+        fontomas__check_equal(middle.addNode(nodeid_t(n), tagid_t(n % 3)), Graph::eOk);
+        fontomas__check_equal(wide.addNode(n, n % 3), Graph32::eOk);
+    }
+
+    std::mt19937 rng(19);
+    std::vector<Graph8::Route> narrowRoutes;
+    std::vector<Graph::Route> middleRoutes;
+    std::vector<Graph32::Route> wideRoutes;
+    for (int i = 0; i < 3000; ++i) {
+        const uint32_t n = rng() % sNbNodes, f = rng() % sNbNodes, t = rng() % sNbTags;
+        if (i % 2) {
+            narrowRoutes.push_back(Graph8::Route{uint8_t(n), uint8_t(f), uint8_t(t)});
+            middleRoutes.push_back(Graph::Route{nodeid_t(n), nodeid_t(f), tagid_t(t)});
+            wideRoutes.push_back(Graph32::Route{n, f, t});
+            continue;
+        }
+
+        const Graph::Result res = middle.addRoute(nodeid_t(n), nodeid_t(f), tagid_t(t));
+        fontomas__check_equal(int(narrow.addRoute(uint8_t(n), uint8_t(f), uint8_t(t))), int(res));
+        fontomas__check_equal(int(wide.addRoute(n, f, t)), int(res));
+    }
+
+    std::vector<Graph8::Result> narrowResults(narrowRoutes.size());
+    std::vector<Graph::Result> middleResults(middleRoutes.size());
+    std::vector<Graph32::Result> wideResults(wideRoutes.size());
+    narrow.addRoutes(span_t<const Graph8::Route>(narrowRoutes.data(), narrowRoutes.size()), narrowResults.data());
+    middle.addRoutes(span_t<const Graph::Route>(middleRoutes.data(), middleRoutes.size()), middleResults.data());
+    wide.addRoutesParallel(span_t<const Graph32::Route>(wideRoutes.data(), wideRoutes.size()), 4, wideResults.data());
+    for (std::size_t i = 0; i < middleResults.size(); ++i) {
+        fontomas__check_equal(int(narrowResults[i]), int(middleResults[i]));
+        fontomas__check_equal(int(wideResults[i]), int(middleResults[i]));
+    }
+
+    for (uint32_t n = 0; n < sNbNodes; n += 7) {
+        for (uint32_t t = 0; t < sNbTags; t += 3) {
+            const Graph::Result res = middle.removeRoute(nodeid_t(n), nodeid_t((n + t) % sNbNodes), tagid_t(t));
+            fontomas__check_equal(int(narrow.removeRoute(uint8_t(n), uint8_t((n + t) % sNbNodes), uint8_t(t))), int(res));
+            fontomas__check_equal(int(wide.removeRoute(n, (n + t) % sNbNodes, t)), int(res));
+        }
+    }
+
+    fontomas__check_true(graph_isconsistent(narrow) && graph_isordered(narrow));
+    fontomas__check_true(graph_isconsistent(wide) && graph_isordered(wide));
+
+    auto same = [](auto a, auto b) {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+    };
+
+    const Graph::FrozenGraph frozen = middle.freeze();
+    const Graph8::FrozenGraph narrowFrozen = narrow.freeze();
+    const Graph32::FrozenGraph wideFrozen = wide.freeze();
+    for (uint32_t n = 0; n < sNbNodes; ++n) {
+        for (uint32_t t = 0; t < sNbTags; ++t) {
+            const span_t<const nodeid_t> fallbacks = middle.fallbacks(nodeid_t(n), tagid_t(t));
+            fontomas__check_true(same(fallbacks, narrow.fallbacks(uint8_t(n), uint8_t(t))));
+            fontomas__check_true(same(fallbacks, wide.fallbacks(n, t)));
+            fontomas__check_true(same(fallbacks, narrowFrozen.fallbacks(uint8_t(n), uint8_t(t))));
+            fontomas__check_true(same(fallbacks, wideFrozen.fallbacks(n, t)));
+
+            const span_t<const nodeid_t> chain = middle.chain(nodeid_t(n), tagid_t(t));
+            fontomas__check_true(same(chain, narrow.chain(uint8_t(n), uint8_t(t))));
+            fontomas__check_true(same(chain, wide.chain(n, t)));
+        }
+    }
+
+    // narrow ids take less memory
+    fontomas__check_true(narrow.memory().used < middle.memory().used);
+    fontomas__check_true(middle.memory().used < wide.memory().used);
+
+    // a snapshot is loaded only by one of the same width
+    static const char* sPath = "test_fallback_graph_widths.fgraph";
+    fontomas__check_equal(narrowFrozen.save(sPath), Graph8::FrozenGraph::eOk);
+    FrozenGraph loaded;
+    fontomas__check_equal(loaded.load(sPath), FrozenGraph::eNotSupported);
+    Graph8::FrozenGraph narrowLoaded;
+    fontomas__check_equal(narrowLoaded.load(sPath), Graph8::FrozenGraph::eOk);
+    fontomas__check_true(same(narrowFrozen.fallbacks(0, 0), narrowLoaded.fallbacks(0, 0)));
+    std::remove(sPath);
+
+    // all ids of narrow graphs are taken
+    for (uint32_t n = sNbNodes; n < 0xFF; ++n)
+        fontomas__check_equal(narrow.addNode(narrow.vacantNode(), 0), Graph8::eOk);
+    fontomas__check_equal(narrow.addNode(0xFF, 0), Graph8::eNotAllowed);
+    fontomas__check_equal(narrow.vacantNode(), Graph8::sNotConnected);
+
+    // so are all ids of 16 bit graphs but sNotConnected, which is no node
+    {
+        Graph full;
+        for (uint32_t n = 0; n < Graph::sNotConnected; ++n)
+            fontomas__check_equal(full.addNode(full.vacantNode(), 0), Graph::eOk);
+        fontomas__check_equal(full.vacantNode(), Graph::sNotConnected);
+        fontomas__check_equal(full.addNode(full.vacantNode(), 0), Graph::eNotAllowed);
+        fontomas__check_equal(full.removeNode(100), Graph::eOk);
+        fontomas__check_equal(full.vacantNode(), 100);
+
+        // the last node is found, while no node is sNotConnected
+        class LastCosts final : public Costs {
+        public:
+            bool serves(nodeid_t nodeId, tagid_t) noexcept override { return Graph::sNotConnected - 1 == nodeId; }
+        } costs;
+        fontomas__check_equal(full.addRoute(0, nodeid_t(Graph::sNotConnected - 1), 0), Graph::eOk);
+        fontomas__check_equal(full.cheapest(0, 0, costs).nodeId, Graph::sNotConnected - 1);
+        fontomas__check_equal(full.cheapest(1, 0, costs).nodeId, Graph::sNotConnected);
+    }
+    fontomas__check_equal(narrow.addNode(0, 0xFF), Graph8::eNotAllowed);
+
+    // wide graphs have ids beyond 16 bits and nodes with more parents,
+    // e.g. a last resort font
+    static constexpr uint32_t sLastResort = 70000;
+
+    Graph32 big;
+    fontomas__check_equal(big.addNode(Graph32::sNotConnected, 0), Graph32::eNotAllowed);
+    std::vector<Graph32::Route> lastResort;
+    for (uint32_t n = 0; n <= sLastResort; ++n) {
+        big.addNode(n, 0x12345);
+        if (n < sLastResort)
+            lastResort.push_back(Graph32::Route{n, sLastResort, 0x12345});
+    }
+    fontomas__check_equal(big.addRoutes(span_t<const Graph32::Route>(lastResort.data(), lastResort.size())),
+                          Graph32::eOk);
+    fontomas__check_equal(big.addRoute(sLastResort, 0, 0x12345), Graph32::eNotAllowed);
+    fontomas__check_equal(big.addRoute(sLastResort - 1, sLastResort - 2, 0x12345), Graph32::eOk);
+    fontomas__check_equal(big.chain(sLastResort - 1, 0x12345).size(), 2);
+    fontomas__check_true(graph_hasroute(big, 0, sLastResort, 0x12345));
+
+    class LastResortCosts final : public Graph32::Costs {
+    public:
+        bool serves(uint32_t nodeId, uint32_t tagId) noexcept override {
+            return sLastResort == nodeId && 0x12345 == tagId;
+        }
+    } costs;
+
+    uint32_t hops[4] = {};
+    const Graph32::Path path = big.cheapest(sLastResort - 1, 0x12345, costs, hops, 4);
+    fontomas__check_equal(path.nodeId, sLastResort);
+    fontomas__check_equal(path.nbhops, 1);
+    fontomas__check_equal(hops[0], sLastResort);
+
+    // a snapshot keeps only tags, which nodes have, so a large tag id costs
+    // nothing; the file is about 16 bytes per node
+    const Graph32::FrozenGraph bigFrozen = big.freeze();
+    fontomas__check_false(bigFrozen.empty());
+    fontomas__check_true(same(bigFrozen.fallbacks(0, 0x12345), big.fallbacks(0, 0x12345)));
+    fontomas__check_true(same(bigFrozen.fallbacks(sLastResort - 1, 0x12345), big.fallbacks(sLastResort - 1, 0x12345)));
+    fontomas__check_equal(bigFrozen.fallbacks(0, 0x12344).size(), 0);
+    fontomas__check_equal(bigFrozen.fallbacks(0, 0x12346).size(), 0);
+    fontomas__check_equal(bigFrozen.fallbacks(sLastResort, 0x12345).size(), 0);
+
+    fontomas__check_equal(bigFrozen.save(sPath), Graph32::FrozenGraph::eOk);
+    std::FILE* file = std::fopen(sPath, "rb");
+    fontomas__check_true(nullptr != file);
+    std::fseek(file, 0, SEEK_END);
+    const long szFile = std::ftell(file);
+    std::fclose(file);
+    std::remove(sPath);
+    fontomas__check_true(szFile < long(32 * sLastResort));
+
+    fontomas__check_equal(big.removeNode(sLastResort), Graph32::eOk);
+    fontomas__check_equal(big.chain(sLastResort - 1, 0x12345).size(), 1);
+    for (uint32_t n = 0; n < sLastResort - 1; ++n)
+        fontomas__check_equal(big.fallbacks(n, 0x12345).size(), 0);
+
     return true;
 }
 
@@ -0,0 +1,244 @@
+#include "fontomas/fallback/resolutioncache.h"
+
+#include <atomic>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fontomas/fallback/consts.h"
+
+#include "testsglobals.h"
+
+
+bool test__fallback__resolutioncache_resolve();
+bool test__fallback__resolutioncache_evict();
+bool test__fallback__resolutioncache_report();
+bool test__fallback__resolutioncache_threads();
+
+
+fontomas__tests_suit_begin(FallbackResolutionCache)
+    fontomas__test(test__fallback__resolutioncache_resolve),
+    fontomas__test(test__fallback__resolutioncache_evict),
+    fontomas__test(test__fallback__resolutioncache_report),
+    fontomas__test(test__fallback__resolutioncache_threads)
+fontomas__tests_suit_end(FallbackResolutionCache);
+
+
+namespace {
+
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    //
+    //   0 (latin) --> 1 (cyrillic) --> 2 (cjk)
+    //   |
+    //   +-----------> 3 (latin, cyrillic, cjk)
+    //
+    void build(Graph& g) {
+        for (nodeid_t n = 0; n < 4; ++n)
+            g.addNode(n, 0);
+        g.addRoute(0, 1, 0);
+        g.addRoute(1, 2, 0);
+        g.addRoute(0, 3, 0);
+
+        Coverage latin, cyrillic, cjk, all;
+        latin.add(0x20, 0x7E);
+        cyrillic.add(0x400, 0x4FF);
+        cjk.add(0x4E00, 0x9FFF);
+        all.add(0x20, 0x7E);
+        all.add(0x400, 0x4FF);
+        all.add(0x4E00, 0x9FFF);
+
+        g.setCoverage(0, std::move(latin));
+        g.setCoverage(1, std::move(cyrillic));
+        g.setCoverage(2, std::move(cjk));
+        g.setCoverage(3, std::move(all));
+    }
+
+
+    class TestLogger final : public services::Logger {
+    public:
+        bool visible(Level level) const noexcept override { return Level::Info == level; }
+        void print(Level level, const char* message) noexcept override {
+            if (Level::Info == level)
+                lines.push_back(message);
+        }
+
+        static std::vector<std::string> lines;
+    };
+
+    std::vector<std::string> TestLogger::lines;
+
+}
+
+
+bool test__fallback__resolutioncache_resolve() {
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    Graph g;
+    build(g);
+
+    ResolutionCache cache(g);
+
+    fontomas__check_equal(cache.resolve(0, 0, 'A'), 0);
+    fontomas__check_equal(cache.resolve(0, 0, 0x416), 1);
+    fontomas__check_equal(cache.resolve(0, 0, 0x4E2D), 2);
+    fontomas__check_equal(cache.resolve(0, 0, 0x1F600), sNotConnected);
+    fontomas__check_equal(cache.resolve(7, 0, 'A'), sNotConnected);
+    fontomas__check_equal(cache.resolve(0, 0, 0xFFFFFFFF), sNotConnected);
+    fontomas__check_equal(cache.stats().hits, 0);
+    fontomas__check_equal(cache.stats().misses, 5);
+
+    fontomas__check_equal(cache.resolve(0, 0, 'A'), 0);
+    fontomas__check_equal(cache.resolve(0, 0, 0x416), 1);
+    fontomas__check_equal(cache.resolve(0, 0, 0x1F600), sNotConnected);
+    fontomas__check_equal(cache.stats().hits, 3);
+    fontomas__check_equal(cache.stats().misses, 5);
+
+    // any change of the graph drops entries
+    fontomas__check_equal(g.removeRoute(0, 1, 0), Graph::eOk);
+    fontomas__check_equal(cache.resolve(0, 0, 0x416), 3);
+    fontomas__check_equal(cache.stats().misses, 6);
+
+    Coverage emoji;
+    emoji.add(0x1F600, 0x1F64F);
+    fontomas__check_equal(g.setCoverage(3, std::move(emoji)), Graph::eOk);
+    fontomas__check_equal(cache.resolve(0, 0, 0x1F600), 3);
+    fontomas__check_equal(cache.resolve(0, 0, 0x416), sNotConnected);
+
+    // compaction doesn't change results, so entries are kept
+    const uint64_t misses = cache.stats().misses;
+    g.shrink_to_fit();
+    fontomas__check_equal(cache.resolve(0, 0, 0x1F600), 3);
+    fontomas__check_equal(cache.stats().misses, misses);
+
+    cache.clear();
+    fontomas__check_equal(cache.resolve(0, 0, 0x1F600), 3);
+    fontomas__check_equal(cache.stats().misses, misses + 1);
+
+    return true;
+}
+
+
+bool test__fallback__resolutioncache_evict() {
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    Graph g;
+    build(g);
+
+    HeapAllocator heap;
+    {
+        // a single window for all keys
+        ResolutionCache cache(g, 4, 1, heap);
+        fontomas__check_equal(cache.memory().reserved, heap.stats().used);
+
+        std::mt19937 rng(17);
+        for (int i = 0; i < 10000; ++i) {
+            const nodeid_t nodeId = nodeid_t(rng() % 5);
+            const codepoint_t codepoint = rng() % 3 ? 0x20 + rng() % 16 : 0x400 + rng() % 16;
+            fontomas__check_equal(cache.resolve(nodeId, 0, codepoint), g.firstCovering(nodeId, 0, codepoint));
+        }
+
+        const ResolutionCache::Stats stats = cache.stats();
+        fontomas__check_equal(stats.hits + stats.misses, 10000);
+        fontomas__check_true(stats.hits > 0);
+    }
+    fontomas__check_equal(heap.stats().used, 0);
+
+    return true;
+}
+
+
+bool test__fallback__resolutioncache_report() {
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    Graph g;
+    build(g);
+
+    TestLogger::lines.clear();
+
+    // no logger - nothing to report to
+    ResolutionCache silent(g);
+    silent.resolve(0, 0, 'A');
+    silent.report();
+    fontomas__check_equal(TestLogger::lines.size(), 0);
+
+    DIContainer di;
+    di.registerService<services::Logger, TestLogger>();
+
+    ResolutionCache::Ptr cache = di.resolve<ResolutionCache>(g);
+    cache->resolve(0, 0, 'A');
+    cache->resolve(0, 0, 'A');
+    cache->resolve(0, 0, 'A');
+    cache->resolve(0, 0, 0x416);
+    cache->report();
+
+    fontomas__check_equal(TestLogger::lines.size(), 1);
+    fontomas__check_equal(TestLogger::lines[0],
+                          std::string("fallback::ResolutionCache: 2 hits, 2 misses, 50.0% hit rate"));
+
+    return true;
+}
+
+
+bool test__fallback__resolutioncache_threads() {
+    using namespace fontomas;
+    using namespace fontomas::fallback;
+
+    static constexpr int sNbThreads = 8;
+    static constexpr int sNbLookups = 20000;
+
+    // answers are taken from another graph, so threads find chains of this
+    // one unresolved and resolve them at once
+    Graph g, reference;
+    build(g);
+    build(reference);
+
+    // answers of the graph itself for nodes 0..3 and codepoints 0..sNbCodepoints-1
+    // of each script
+    static constexpr codepoint_t sScripts[] = { 0x20, 0x400, 0x4E00 };
+    static constexpr uint32_t sNbCodepoints = 64;
+
+    std::vector<nodeid_t> expected;
+    for (nodeid_t n = 0; n < 4; ++n) {
+        for (codepoint_t script : sScripts) {
+            for (codepoint_t c = 0; c < sNbCodepoints; ++c)
+                expected.push_back(reference.firstCovering(n, 0, script + c));
+        }
+    }
+
+    ResolutionCache cache(g, 256, 4);
+
+    std::atomic<bool> failed(false);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < sNbThreads; ++t) {
+        threads.emplace_back([&, t]() {
+            std::mt19937 rng(t);
+            for (int i = 0; i < sNbLookups; ++i) {
+                const uint32_t index = rng() % uint32_t(expected.size());
+                const nodeid_t nodeId = nodeid_t(index / (3 * sNbCodepoints));
+                const codepoint_t codepoint = sScripts[index / sNbCodepoints % 3] + index % sNbCodepoints;
+                if (expected[index] != cache.resolve(nodeId, 0, codepoint))
+                    failed = true;
+            }
+        });
+    }
+
+    for (std::thread& t : threads)
+        t.join();
+
+    fontomas__check_false(failed);
+
+    const ResolutionCache::Stats stats = cache.stats();
+    fontomas__check_equal(stats.hits + stats.misses, uint64_t(sNbThreads) * sNbLookups);
+
+    return true;
+}
+
+
+// tst/test_fallback_resolutioncache.cpp
@@ -3,12 +3,16 @@
 #define FONTOMAS_TESTING_TESTERS_H_
 
 
+#include <algorithm>
 #include <cstring>
+#include <new>
+#include <utility>
 #include <vector>
 
 #include <fontomas/debug.h>
 #include <fontomas/macros.h>
 
+#include <fontomas/fallback/concurrentgraph.h>
 #include <fontomas/fallback/consts.h>
 #include <fontomas/fallback/graph.h>
 
@@ -19,11 +23,15 @@ namespace fallback { ;
 
 class Tester final {
 public:
+    static constexpr uint8_t sSorted = Graph::eSorted;
+    static constexpr uint8_t sDense = Graph::eDense;
+    static constexpr uint8_t sHashed = Graph::eHashed;
+
     static nodeid_t maxNodeId(const Graph& g) noexcept {
         return g._maxNodeId;
     }
     
-    static nodeid_t szNodes(const Graph& g) noexcept {
+    static uint32_t szNodes(const Graph& g) noexcept {
         return g._szNodes;
     }
     
@@ -31,7 +39,7 @@ public:
         if (!g._nodes)
             return 0;
         nodeid_t counter = 0;
-        for (nodeid_t i = 0; i < g._szNodes; ++i) {
+        for (uint32_t i = 0; i < g._szNodes; ++i) {
             if (g._nodes[i].routes)
                 counter += 1;
         }
@@ -41,8 +49,7 @@ public:
     static bool initWithNodes(Graph& g, std::initializer_list<std::pair<nodeid_t, tagid_t>> nodes) noexcept {
         if (g._szNodes > 0) {
             g.~Graph();
-            g._szNodes = g._maxNodeId = 0;
-            g._nodes = nullptr;
+            new (&g) Graph();
         }
 
         for (const auto& p : nodes) {
@@ -53,11 +60,137 @@ public:
         return true;
     }
 
-    static bool hasRoute(const Graph& g, nodeid_t nodeId, nodeid_t fallbackId, tagid_t tagId) noexcept {
+    static uint8_t layout(const Graph& g, nodeid_t nodeId) noexcept {
+        return g._nodes[nodeId].layout;
+    }
+
+    template <class G>
+    static bool hasRoute(const G& g, typename G::nodeid_t nodeId, typename G::nodeid_t fallbackId,
+                         typename G::tagid_t tagId) noexcept
+    {
         if (nodeId > g._maxNodeId || !g._nodes[nodeId].routes)
             return false;
         
-        return Graph::has_route(g._nodes[nodeId], fallbackId, tagId);
+        return G::has_route(g._nodes[nodeId], fallbackId, tagId);
+    }
+
+    // bounds of topological orders, which are given to new tags of nodes
+    template <class G>
+    static std::pair<uint32_t, uint32_t> orders(const G& g) noexcept {
+        return std::make_pair(g._lowOrder, g._highOrder);
+    }
+
+    // a position of the node in the topological order of the tag, which must
+    // be attached to it
+    template <class G>
+    static uint32_t order(const G& g, typename G::nodeid_t nodeId, typename G::tagid_t tagId) noexcept {
+        const typename G::NodeInfo& info = g._nodes[nodeId];
+        for (typename G::count_t slot = 0; slot < info.sztags; ++slot) {
+            if (tagId == G::slot_tag(info, slot))
+                return info.routes[slot].order;
+        }
+        return 0;
+    }
+
+    // moves the bounds, e.g. close to their limits; orders of existing tags
+    // must stay between them
+    template <class G>
+    static void setOrders(G& g, uint32_t low, uint32_t high) noexcept {
+        g._lowOrder = low;
+        g._highOrder = high;
+    }
+
+    static std::size_t nbRetired(const ConcurrentGraph& g) noexcept {
+        return g._retired.size();
+    }
+
+    // checks that every route goes forward in the topological order of its tag
+    template <class G>
+    static bool isOrdered(const G& g) noexcept {
+        using count_t = typename G::count_t;
+
+        for (uint32_t i = 0; g._nodes && i <= g._maxNodeId; ++i) {
+            const typename G::NodeInfo& info = g._nodes[i];
+            for (count_t slot = 0; info.routes && slot < info.sztags; ++slot) {
+                const typename G::tagid_t t = G::slot_tag(info, slot);
+                const typename G::TagRoutes& route = info.routes[slot];
+                for (count_t j = 0; G::sNoTag != t && route.fallbacks && j < route.nbfallbacks; ++j) {
+                    const typename G::NodeInfo& fallback = g._nodes[route.fallbacks[j]];
+                    for (count_t k = 0; k < fallback.sztags; ++k) {
+                        if (t == G::slot_tag(fallback, k) && route.order >= fallback.routes[k].order)
+                            return false;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    // checks bookkeeping of every node: counts of tags, masks, edges and
+    // parents, which mirror fallbacks
+    template <class G>
+    static bool isConsistent(const G& g) noexcept {
+        using nodeid_t = typename G::nodeid_t;
+        using count_t = typename G::count_t;
+
+        uint32_t nbNodes = 0;
+        for (uint32_t i = 0; g._nodes && i < g._szNodes; ++i) {
+            const typename G::NodeInfo& info = g._nodes[i];
+            if (!info.routes || 0 == info.nbtags)
+                continue;
+            if (i > g._maxNodeId)
+                return false;
+            ++nbNodes;
+
+            count_t nbtags = 0;
+            uint64_t tagmask = 0;
+            std::vector<nodeid_t> edges;
+            for (count_t slot = 0; slot < info.sztags; ++slot) {
+                const typename G::tagid_t t = G::slot_tag(info, slot);
+                const typename G::TagRoutes& route = info.routes[slot];
+                if (G::sNoTag == t || !route.fallbacks)
+                    continue;
+
+                ++nbtags;
+                tagmask |= uint64_t(1) << (t % 64);
+                for (count_t j = 0; j < route.nbfallbacks; ++j) {
+                    const nodeid_t f = route.fallbacks[j];
+                    if (!hasParent(g, f, nodeid_t(i), t))
+                        return false;
+                    if (edges.end() == std::find(edges.begin(), edges.end(), f))
+                        edges.push_back(f);
+                }
+                for (count_t j = 0; j < route.nbparents; ++j) {
+                    if (!hasRoute(g, route.parents[j], nodeid_t(i), t))
+                        return false;
+                }
+            }
+
+            if (nbtags != info.nbtags || tagmask != info.tagmask || edges.size() != info.nbedges)
+                return false;
+            for (count_t e = 0; e < info.nbedges; ++e) {
+                if (edges.end() == std::find(edges.begin(), edges.end(), info.edges[e]) || 0 == info.edgemasks[e])
+                    return false;
+            }
+        }
+        return nbNodes == g._nbNodes;
+    }
+
+private:
+    template <class G>
+    static bool hasParent(const G& g, typename G::nodeid_t nodeId, typename G::nodeid_t parentId,
+                          typename G::tagid_t tagId) noexcept
+    {
+        if (nodeId > g._maxNodeId || !g._nodes[nodeId].routes)
+            return false;
+
+        const typename G::NodeInfo& info = g._nodes[nodeId];
+        for (typename G::count_t slot = 0; slot < info.sztags; ++slot) {
+            const typename G::TagRoutes& route = info.routes[slot];
+            if (tagId == G::slot_tag(info, slot) && route.fallbacks)
+                return route.parents + route.nbparents != std::find(route.parents, route.parents + route.nbparents, parentId);
+        }
+        return false;
     }
 };
 
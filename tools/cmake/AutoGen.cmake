@@ -187,6 +187,36 @@ macro(autogen_add_test target testname sourcespath datapath)
 endmacro()
 
 
+macro(autogen_add_benchmark target benchname sourcespath)
+    autogen_init()
+
+    if (${VERBOSE})
+        message(STATUS "*** add_benchmark ${target} ${benchname} ${sourcespath}")
+    endif()
+
+    file(GLOB_RECURSE _allitems "${CMAKE_CURRENT_SOURCE_DIR}/${sourcespath}/*.*")
+    set(_items "")
+    foreach(item ${_allitems})
+        if (${item} MATCHES "^(.+[.]((c)|(cpp)|([m]+)|(h)))$")
+            list(APPEND _items ${item})
+        endif()
+    endforeach()
+
+    AG_FilterPlatformSources(_items "(c)|(cpp)|([m]+)|(h)")
+
+    if (${CMAKE_VERSION} VERSION_LESS "3.8.0")
+        source_group("[sources]" FILES ${_items})
+    else()
+        source_group(TREE ${CMAKE_CURRENT_SOURCE_DIR}/${sourcespath} PREFIX "[sources]" FILES ${_items})
+    endif()
+
+    AG_Platform_AddExecutableTarget(${benchname} _items)
+    AG_Platform_LinkTargetToExecutable(${benchname} ${target})
+
+    target_include_directories(${benchname} PRIVATE ${sourcespath})
+endmacro()
+
+
 macro(autogen_setup_install target)
     autogen_init()
 
@@ -60,7 +60,7 @@ macro(AG_DefineTargetProperty propertyname)
             BRIEF_DOCS "project ${propertyname} custom prop"
             FULL_DOCS  "project ${propertyname} custom prop"
         )
-        set(PROJECT_${propertyname}_DEF ON CACHE BOOL "${propertyname} PROP defined")
+        set(PROJECT_${propertyname}_DEF ON)
         list(APPEND UG_GLOBAL_PROPERTIES_LIST "${propertyname}")
     endif()
 endmacro()